@@ -0,0 +1,165 @@
+// Entradas patologicas: literales de 100 KB, lineas de varios MB, inicializadores
+// anidados y construcciones sin cerrar que obligan a buscar el cierre en el resto
+// de la linea o del archivo. Cada caso se transpila con el pipeline fusionado y con
+// el secuencial en dos tamanos, uno size_factor veces mayor que el otro, y se
+// comprueba que el costo sea lineal:
+// - la razon entre los mejores tiempos de varias repeticiones no debe superar
+//   max_growth: 3 veces la razon de tamanos. Es 32 si el costo es lineal y 1024 si
+//   es cuadratico; el margen cubre que la entrada menor cabe en la cache y que las
+//   salidas mayores se escriben en paginas nuevas
+// - el tamano mayor no debe tardar mas de 'ms por MB' (500 por omision; ctest,
+//   que tambien corre sin optimizar o con sanitizadores, da un limite mayor)
+// Tambien falla si los modos dan salidas distintas.
+//
+// Uso: AdversarialBenchmark [repeticiones] [KB del tamano menor] [ms por MB]
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BenchmarkTools.hpp"
+#include "TranspilerPipeline.hpp"
+
+namespace {
+
+    using Clock = BenchmarkTools::Clock;
+
+    constexpr size_t size_factor = 32;
+    constexpr double max_growth = 3.0 * size_factor;
+
+    struct AdversarialCase {
+        const char* name;
+
+        // Genera una entrada de aproximadamente 'size' bytes
+        std::function<std::string(size_t)> generate;
+    };
+
+    // 'prefix', luego 'unit' repetido hasta 'size' bytes y al final 'suffix'
+    std::string repeat(std::string_view prefix, std::string_view unit, size_t size, std::string_view suffix = "\n")
+    {
+        std::string text(prefix);
+        text.reserve(size + suffix.size() + unit.size());
+        while (text.size() < size) text.append(unit);
+        text.append(suffix);
+        return text;
+    }
+
+    const std::vector<AdversarialCase>& adversarialCases()
+    {
+        static const std::vector<AdversarialCase> cases{
+            { "literales de 100 KB", [](size_t size) {
+                std::string line = repeat("char* blob = \"", "abc\\\"de\\\\", 100 << 10, "\";\nprintf(\"%s\\n\", blob);\n");
+                return repeat("", line, size, "");
+            } },
+            { "linea minificada", [](size_t size) {
+                return repeat("", "int a[2]={1,2};char*s=\"x\";if(p==NULL)printf(\"%d\",a[0]);", size);
+            } },
+            { "inicializador anidado", [](size_t size) {
+                return std::string("int a[] = ") + std::string(size / 2, '{') + std::string(size / 2, '}') + ";\n";
+            } },
+            { "printf sin comilla de cierre", [](size_t size) {
+                return repeat("printf(\"\n", "dato\n", size);
+            } },
+            { "printf sin parentesis de cierre", [](size_t size) {
+                return repeat("printf(\"%d\", \n", "valor,\n", size);
+            } },
+            { "strcmp en una linea", [](size_t size) {
+                return repeat("char s[] = \"x\";\n", "strcmp(s, t) == 0 || ", size, ";\n");
+            } },
+            { "strcpy sin cerrar", [](size_t size) {
+                return repeat("", "strcpy(a, ", size);
+            } },
+            { "llaves sin cerrar", [](size_t size) {
+                return repeat("", "int a[] = { ", size);
+            } },
+            { "comillas sin cerrar", [](size_t size) {
+                return repeat("", "char b[] = \"", size);
+            } },
+            { "tramos entre literales", [](size_t size) {
+                return repeat("", "x[0] = \"a\"; ", size);
+            } },
+            { "define de 1 linea", [](size_t size) {
+                return repeat("#define VALOR ", "(1 + ", size);
+            } },
+        };
+        return cases;
+    }
+
+    // Mejor tiempo de 'repetitions' transpilaciones; deja la salida en 'output'
+    double bestSeconds(TranspilerPipeline& pipeline, const std::string& input, PipelineMode mode,
+        size_t repetitions, std::string& output)
+    {
+        double best = 0;
+        for (size_t i = 0; i < repetitions; ++i) {
+            auto start = Clock::now();
+            output = pipeline.transpile(input, mode);
+            double seconds = BenchmarkTools::seconds(start, Clock::now());
+            if (i == 0 || seconds < best) best = seconds;
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t repetitions = 5;
+    size_t small_kb = 128;
+    size_t ms_per_mb = 500;
+    if ((argc > 1 && !BenchmarkTools::parseCount(argv[1], 1, 1000, repetitions)) ||
+        (argc > 2 && !BenchmarkTools::parseCount(argv[2], 1, 1 << 20, small_kb)) ||
+        (argc > 3 && !BenchmarkTools::parseCount(argv[3], 1, SIZE_MAX, ms_per_mb))) {
+        std::cerr << "Uso: AdversarialBenchmark [repeticiones] [KB del tamano menor] [ms por MB]\n";
+        return 1;
+    }
+
+    size_t small_size = small_kb << 10;
+    size_t large_size = small_size * size_factor;
+    double max_seconds = static_cast<double>(ms_per_mb) / 1000.0 * static_cast<double>(large_size) / (1024.0 * 1024.0);
+
+    std::cout << "Tamanos: " << (small_size >> 10) << " KB y " << (large_size >> 10) << " KB; "
+        << repetitions << " repeticiones; razon maxima " << max_growth << ", limite "
+        << max_seconds << " s para el mayor\n";
+
+    std::cout << std::left << std::setw(34) << "Caso" << std::right << std::setw(12) << "Modo"
+        << std::setw(11) << "ms menor" << std::setw(11) << "ms mayor" << std::setw(8) << "Razon" << "\n";
+
+    // Sin memoria de lineas: cada repeticion analiza todo de nuevo
+    TranspilerPipeline pipeline(TranspilerRules::shared(), nullptr);
+    size_t failures = 0;
+
+    for (const auto& adversarial : adversarialCases()) {
+        std::string small_input = adversarial.generate(small_size);
+        std::string large_input = adversarial.generate(large_size);
+
+        std::string fused_output;
+        for (PipelineMode mode : { PipelineMode::Fused, PipelineMode::Sequential }) {
+            std::string small_output, large_output;
+            double small_seconds = bestSeconds(pipeline, small_input, mode, repetitions, small_output);
+            double large_seconds = bestSeconds(pipeline, large_input, mode, repetitions, large_output);
+            double growth = large_seconds / std::max(small_seconds, 1e-6);
+
+            std::string problem;
+            if (growth > max_growth) problem = "crecimiento no lineal";
+            else if (large_seconds > max_seconds) problem = "demasiado lento";
+
+            if (mode == PipelineMode::Fused) fused_output = std::move(large_output);
+            else if (large_output != fused_output) problem = "salida distinta entre modos";
+
+            std::cout << std::left << std::setw(34) << adversarial.name << std::right << std::setw(12)
+                << (mode == PipelineMode::Fused ? "fusionado" : "secuencial") << std::fixed
+                << std::setprecision(1) << std::setw(11) << small_seconds * 1000.0
+                << std::setw(11) << large_seconds * 1000.0 << std::setw(8) << growth;
+            if (!problem.empty()) {
+                std::cout << "  FALLA: " << problem;
+                ++failures;
+            }
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "Casos con falla: " << failures << "\n";
+    return failures == 0 ? 0 : 1;
+}
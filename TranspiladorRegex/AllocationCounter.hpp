@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// Asignaciones de memoria del hilo actual. Solo se cuentan si el ejecutable
+// reemplaza operator new con TRANSPILER_COUNT_ALLOCATIONS() (en un solo .cpp) y
+// despues de enable(); sin el reemplazo los contadores quedan en cero y
+// installed() es false. Sin enable(), el operator new reemplazado solo lee una
+// bandera antes de llamar a malloc
+class AllocationCounter {
+public:
+    struct Totals {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    static Totals& current() {
+        thread_local Totals totals;
+        return totals;
+    }
+
+    static bool& installed() {
+        static bool hooked = false;
+        return hooked;
+    }
+
+    // Se llama una vez, antes de crear los hilos que se quieren medir
+    static void enable() { counting.store(true, std::memory_order_relaxed); }
+
+    static bool enabled() { return counting.load(std::memory_order_relaxed); }
+
+    // nullptr si no hay memoria
+    static void* tryAllocate(size_t size) {
+        count(size);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    static void* tryAllocate(size_t size, std::align_val_t alignment) {
+        count(size);
+        size_t align = static_cast<size_t>(alignment);
+        size_t rounded = (size == 0 ? align : (size + align - 1) / align * align);
+#if defined(_WIN32)
+        return _aligned_malloc(rounded, align);
+#else
+        return std::aligned_alloc(align, rounded);
+#endif
+    }
+
+    static void* allocate(size_t size) {
+        void* memory = tryAllocate(size);
+        if (!memory) throw std::bad_alloc();
+        return memory;
+    }
+
+    static void* allocate(size_t size, std::align_val_t alignment) {
+        void* memory = tryAllocate(size, alignment);
+        if (!memory) throw std::bad_alloc();
+        return memory;
+    }
+
+    static void release(void* memory) noexcept { std::free(memory); }
+
+    static void release(void* memory, std::align_val_t) noexcept {
+#if defined(_WIN32)
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+
+private:
+    static inline std::atomic<bool> counting{ false };
+
+    static void count(size_t size) {
+        if (!enabled()) return;
+
+        Totals& totals = current();
+        ++totals.count;
+        totals.bytes += size;
+    }
+};
+
+// Reemplaza todas las formas de operator new y delete (simples, de arreglos, con
+// alineacion y nothrow), para que cada delete libere con la funcion que corresponde
+// a su new
+#define TRANSPILER_COUNT_ALLOCATIONS()                                                                          \
+    void* operator new(size_t size) { return AllocationCounter::allocate(size); }                               \
+    void* operator new[](size_t size) { return AllocationCounter::allocate(size); }                             \
+    void* operator new(size_t size, const std::nothrow_t&) noexcept { return AllocationCounter::tryAllocate(size); } \
+    void* operator new[](size_t size, const std::nothrow_t&) noexcept { return AllocationCounter::tryAllocate(size); } \
+    void* operator new(size_t size, std::align_val_t align) { return AllocationCounter::allocate(size, align); } \
+    void* operator new[](size_t size, std::align_val_t align) { return AllocationCounter::allocate(size, align); } \
+    void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {                  \
+        return AllocationCounter::tryAllocate(size, align);                                                     \
+    }                                                                                                           \
+    void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {                \
+        return AllocationCounter::tryAllocate(size, align);                                                     \
+    }                                                                                                           \
+    void operator delete(void* memory) noexcept { AllocationCounter::release(memory); }                         \
+    void operator delete[](void* memory) noexcept { AllocationCounter::release(memory); }                       \
+    void operator delete(void* memory, size_t) noexcept { AllocationCounter::release(memory); }                 \
+    void operator delete[](void* memory, size_t) noexcept { AllocationCounter::release(memory); }               \
+    void operator delete(void* memory, const std::nothrow_t&) noexcept { AllocationCounter::release(memory); }  \
+    void operator delete[](void* memory, const std::nothrow_t&) noexcept { AllocationCounter::release(memory); } \
+    void operator delete(void* memory, std::align_val_t align) noexcept { AllocationCounter::release(memory, align); } \
+    void operator delete[](void* memory, std::align_val_t align) noexcept { AllocationCounter::release(memory, align); } \
+    void operator delete(void* memory, size_t, std::align_val_t align) noexcept {                              \
+        AllocationCounter::release(memory, align);                                                              \
+    }                                                                                                           \
+    void operator delete[](void* memory, size_t, std::align_val_t align) noexcept {                            \
+        AllocationCounter::release(memory, align);                                                              \
+    }                                                                                                           \
+    void operator delete(void* memory, std::align_val_t align, const std::nothrow_t&) noexcept {               \
+        AllocationCounter::release(memory, align);                                                              \
+    }                                                                                                           \
+    void operator delete[](void* memory, std::align_val_t align, const std::nothrow_t&) noexcept {             \
+        AllocationCounter::release(memory, align);                                                              \
+    }                                                                                                           \
+    static const bool allocation_counter_installed = (AllocationCounter::installed() = true)
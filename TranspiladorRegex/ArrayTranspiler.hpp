@@ -1,278 +1,301 @@
 #pragma once
-#include <regex>
 #include <sstream>
 #include <string>
-
+#include "CLexer.hpp"
+#include "EditList.hpp"
+#include "PatternMatchers.hpp"
+#include "IncludeRewriter.hpp"
+#include "KeywordPrefilter.hpp"
+#include "LineMemo.hpp"
+#include "SourceLines.hpp"
+#include "TranspilerStats.hpp"
+
+// Las reglas no cambian durante un recorrido: el estado vive en un Context, y un
+// mismo ArrayTranspiler puede usarse desde varios hilos a la vez
 class ArrayTranspiler {
+public:
+    // Estado de un recorrido
+    struct Context {
+        IncludeRewriter::Context include;
 
-    struct StringRegion {
-        size_t start;
-        size_t length;
-
-        StringRegion(size_t s, size_t l) : start(s), length(l) {}
-    };
+        // Estado del lexer entre lineas del archivo en curso
+        LexState lex_state;
+        std::vector<Token> line_tokens;
+        std::vector<ProtectedRegion> protected_regions;
 
-private:
-    std::regex array_declaration_pattern{
-        R"(([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\])"
-    };
+        // Reemplazos de la linea en curso, aplicados de una sola vez al final
+        EditList line_edits;
 
-    // Expresion regular para declaraciones con inicialización
-    // Ejemplo: int arr[5] = {1, 2, 3, 4, 5}
-    std::regex array_init_pattern{
-        R"(([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\]\s*=\s*(\{[^}]*\}))"
-    };
+        // Memoria de lineas ya convertidas (opcional, puede compartirse entre hilos)
+        LineMemo* memo = nullptr;
 
-    // Expresion regular para declaraciones con inicializacion automática de tamaño
-    // Ejemplo: int arr[] = {1, 2, 3, 4, 5}
-    std::regex array_auto_init_pattern{
-        R"(([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*\]\s*=\s*(\{[^}]*\}))"
+        // Verdadero si ningun estado pasa de la ultima linea procesada a la siguiente
+        bool idle() const { return lex_state == LexState{} && include.idle(); }
     };
 
-    // Expresion regular para múltiples declaraciones en una linea
-    // Ejemplo: int a[10], b[20], c[30];
-    std::regex multi_array_pattern{
-        R"(([A-Za-z_][A-Za-z0-9_]*\s+)([A-Za-z_][A-Za-z0-9_]*\s*\[\s*\d+\s*\](?:\s*,\s*[A-Za-z_][A-Za-z0-9_]*\s*\[\s*\d+\s*\])*)\s*;)"
-    };
+private:
+    // Las declaraciones se reconocen con ArrayDeclarationPattern (int arr[5]),
+    // InitializedArrayPattern (int arr[5] = {1, 2, 3, 4, 5}),
+    // AutoInitArrayPattern (int arr[] = {1, 2, 3, 4, 5}) y
+    // MultipleArrayPattern (int a[10], b[20], c[30];)
 
-    // Expresion regular para detectar strings literales
-    std::regex string_literal_pattern{
-        R"("([^"\\]|\\.)*")"
-    };
+    // Lexer compartido para ubicar literales y comentarios
+    CLexer lexer;
 
-    // Expresion regular para detectar comentarios
-    std::regex comment_pattern{
-        R"(//.*$|/\*.*?\*/)"
-    };
+    // Inserta #include <array> despues de la primera directiva #include
+    IncludeRewriter include_rewriter{ "#include <array>" };
 
 public:
-    std::string transpileFile(const std::string& content);
+    std::string transpileFile(std::string_view content) const;
 
-private:
-    std::string addArrayInclude(const std::string& content);
+    // Procesamiento linea a linea para el pipeline fusionado. 'insert_include' y
+    // 'prepend_include' indican si falta #include <array> y si el archivo no tiene
+    // ninguna directiva #include (la nueva va entonces al inicio)
+    void beginStream(Context& context, bool insert_include, bool prepend_include, std::string& out) const;
 
-    std::string transpileArrayDeclarations(const std::string& content);
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const;
 
-    std::string processArrayLine(const std::string& line);
+    // 'triggers' son los bits de KeywordPrefilter ya calculados para la linea
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
 
-    bool containsStringLiteralOrComment(const std::string& line);
+    void endStream(Context& context, std::string& out) const;
 
-    std::string processLineWithLiterals(const std::string& line);
+    // Auxiliares de las reglas sin estado de recorrido; son publicos para que
+    // transpiler_bench los mida por separado
+    int countInitializerElements(const std::string& initializer) const;
 
-    std::string processArrayDeclarations(const std::string& line);
+    void findProtectedRegions(const std::vector<Token>& tokens, size_t line_length,
+        std::vector<ProtectedRegion>& protected_regions) const;
 
-    std::string processAutoInitArrays(const std::string& line);
+private:
+    void transpileArrayDeclarations(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
+
+    std::string processArrayLine(const std::string& line, const std::vector<ProtectedRegion>& protected_regions,
+        EditList& line_edits) const;
 
-    std::string processInitializedArrays(const std::string& line);
+    // Cada etapa busca sobre el texto original del tramo [begin, end) y registra
+    // sus reemplazos; los que se solapan con uno anterior se descartan
+    void processArrayDeclarations(const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    std::string processMultipleArrays(const std::string& line);
+    void processAutoInitArrays(const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    std::string processSimpleArrays(const std::string& line);
+    void processInitializedArrays(const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    std::string convertMultipleArrayDeclarations(const std::string& type, const std::string& declarations);
+    void processMultipleArrays(const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    int countInitializerElements(const std::string& initializer);
+    void processSimpleArrays(const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    bool isPartOfProcessedDeclaration(const std::string& line, size_t pos);
+    std::string convertMultipleArrayDeclarations(const std::string& type, const std::string& declarations) const;
 
-    std::vector<StringRegion> findProtectedRegions(const std::string& line);
+    // Posicion del ultimo caracter del primer "std::array" que empieza en [begin, end)
+    // (npos si no hay). Los posteriores no cambian la decision y no se buscan: con
+    // muchos tramos en una linea la busqueda recorreria el resto de la linea cada vez
+    size_t findProcessedDeclaration(const std::string& line, size_t begin, size_t end) const;
 
-    std::string trim(const std::string& str);
+    std::string trim(const std::string& str) const;
 };
 
 #include "ArrayTranspiler.hpp"
 
 
-std::string ArrayTranspiler::transpileFile(const std::string& content) {
-    std::string result = content;
+inline std::string ArrayTranspiler::transpileFile(std::string_view content) const {
+    std::string result;
+    result.reserve(content.size() + content.size() / 16 + 32);
 
-    result = addArrayInclude(result);
+    bool insert_include = content.find("#include <array>") == std::string_view::npos;
+    bool prepend_include = insert_include && !lexer.hasIncludeDirective(content);
 
-    result = transpileArrayDeclarations(result);
+    Context context;
+    beginStream(context, insert_include, prepend_include, result);
+    KeywordPrefilter::shared().forEachLine(content, [&](std::string_view line, bool has_newline, unsigned triggers) {
+        transpileLine(context, line, has_newline, result, triggers);
+    });
+    endStream(context, result);
 
     return result;
 }
 
-std::string ArrayTranspiler::addArrayInclude(const std::string& content) {
-    std::string result = content;
+inline void ArrayTranspiler::beginStream(Context& context, bool insert_include, bool prepend_include, std::string& out) const {
+    context.lex_state = LexState{};
 
-    if (result.find("#include <array>") == std::string::npos) {
-        std::regex include_pattern(R"(#include\s*[<"][^>"]*[>"])");
-        std::smatch match;
+    include_rewriter.begin(context.include, insert_include, prepend_include, [&](std::string_view line, bool has_newline) {
+        transpileArrayDeclarations(context, line, has_newline, out, KeywordPrefilter::shared().scan(line));
+    });
+}
 
-        if (std::regex_search(result, match, include_pattern)) {
-            size_t pos = match.position() + match.length();
-            result.insert(pos, "\n#include <array>");
-        }
-        else {
-            result = "#include <array>\n" + result;
-        }
-    }
+inline void ArrayTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const {
+    transpileLine(context, line, has_newline, out, KeywordPrefilter::shared().scan(line));
+}
 
-    return result;
+inline void ArrayTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+    unsigned triggers) const {
+    include_rewriter.rewriteLine(context.include, line, has_newline, triggers,
+        [&](std::string_view rewritten, bool rewritten_newline) {
+            transpileArrayDeclarations(context, rewritten, rewritten_newline, out,
+                KeywordPrefilter::rescanIfChanged(line, rewritten, triggers));
+        });
 }
 
-std::string ArrayTranspiler::transpileArrayDeclarations(const std::string& content) {
-    std::istringstream iss(content);
-    std::string line;
-    std::string processed_content;
+inline void ArrayTranspiler::endStream(Context&, std::string&) const {
+}
 
-    while (std::getline(iss, line)) {
-        std::string processed_line = processArrayLine(line);
-        processed_content += processed_line + "\n";
+inline void ArrayTranspiler::transpileArrayDeclarations(Context& context, std::string_view line, bool has_newline,
+    std::string& out, unsigned triggers) const {
+    // Sin '[' no hay declaraciones de arreglos
+    if ((triggers & trigger_array) == 0) {
+        lexer.skipLine(line, has_newline, context.lex_state, (triggers & trigger_lexer) == 0);
+        out.append(line);
+        out += '\n';
+        return;
     }
 
-    return processed_content;
-}
-
-std::string ArrayTranspiler::processArrayLine(const std::string& line) {
-    if (containsStringLiteralOrComment(line)) {
-        return processLineWithLiterals(line);
+    // Desde el estado inicial del lexer el resultado depende solo de la linea
+    bool memoizable = context.memo != nullptr && context.lex_state == LexState{};
+    if (memoizable && context.memo->lookup(MemoPass::Array, line, has_newline, out, context.lex_state)) {
+        return;
     }
+    size_t output_start = out.size();
+    LineMemo::RuleMark rules;
 
-    return processArrayDeclarations(line);
-}
+    context.line_tokens.clear();
+    lexer.tokenizeLine(line, has_newline, context.lex_state, context.line_tokens);
+    findProtectedRegions(context.line_tokens, line.size(), context.protected_regions);
 
-bool ArrayTranspiler::containsStringLiteralOrComment(const std::string& line) {
-    std::smatch match;
-    return std::regex_search(line, match, string_literal_pattern) ||
-        std::regex_search(line, match, comment_pattern);
+    out += processArrayLine(std::string(line), context.protected_regions, context.line_edits);
+    out += '\n';
+
+    if (memoizable) {
+        context.memo->store(MemoPass::Array, line, has_newline, std::string_view(out).substr(output_start),
+            context.lex_state, rules);
+    }
 }
 
-std::string ArrayTranspiler::processLineWithLiterals(const std::string& line) {
-    std::vector<StringRegion> protected_regions = findProtectedRegions(line);
+inline std::string ArrayTranspiler::processArrayLine(const std::string& line, const std::vector<ProtectedRegion>& protected_regions,
+    EditList& line_edits) const {
+    line_edits.clear();
 
-    std::string processed_line;
+    // Los literales y comentarios separan la linea en tramos que se procesan por separado
     size_t last_pos = 0;
 
     for (const auto& region : protected_regions) {
         if (region.start > last_pos) {
-            std::string segment = line.substr(last_pos, region.start - last_pos);
-            segment = processArrayDeclarations(segment);
-            processed_line += segment;
+            processArrayDeclarations(line, last_pos, region.start, line_edits);
         }
-
-        processed_line += line.substr(region.start, region.length);
         last_pos = region.start + region.length;
     }
 
     if (last_pos < line.length()) {
-        std::string segment = line.substr(last_pos);
-        segment = processArrayDeclarations(segment);
-        processed_line += segment;
+        processArrayDeclarations(line, last_pos, line.length(), line_edits);
     }
 
-    return processed_line;
-}
-
-std::string ArrayTranspiler::processArrayDeclarations(const std::string& line) {
-    std::string result = line;
+    if (line_edits.empty()) {
+        return line;
+    }
 
-    result = processAutoInitArrays(result);
+    return line_edits.apply(line);
+}
 
-    result = processInitializedArrays(result);
+inline void ArrayTranspiler::processArrayDeclarations(const std::string& line, size_t begin, size_t end, EditList& edits) const {
+    processAutoInitArrays(line, begin, end, edits);
 
-    result = processMultipleArrays(result);
+    processInitializedArrays(line, begin, end, edits);
 
-    result = processSimpleArrays(result);
+    processMultipleArrays(line, begin, end, edits);
 
-    return result;
+    processSimpleArrays(line, begin, end, edits);
 }
 
-std::string ArrayTranspiler::processAutoInitArrays(const std::string& line) {
-    std::string result = line;
-    std::smatch match;
+inline void ArrayTranspiler::processAutoInitArrays(const std::string& line, size_t begin, size_t end, EditList& edits) const {
+    std::string_view segment = std::string_view(line).substr(begin, end - begin);
 
-    while (std::regex_search(result, match, array_auto_init_pattern)) {
-        std::string type = trim(match[1].str());
-        std::string name = trim(match[2].str());
-        std::string initializer = match[3].str();
+    forEachPatternMatch<AutoInitArrayPattern>(segment, [&](const PatternMatch& match) {
+        std::string type = trim(match.str(1));
+        std::string name = trim(match.str(2));
+        std::string initializer = match.str(3);
 
         int size = countInitializerElements(initializer);
 
         std::string replacement = "std::array<" + type + ", " + std::to_string(size) + "> " +
             name + " = " + initializer + "; // Convertido de arreglo C";
 
-        size_t pos = match.position();
-        size_t len = match.length();
-        result.replace(pos, len, replacement);
-    }
-
-    return result;
+        if (edits.replace(begin + match.position, match.length, std::move(replacement))) {
+            TranspilerStats::countRule(StatsRule::ArrayAutoInit);
+        }
+    });
 }
 
-std::string ArrayTranspiler::processInitializedArrays(const std::string& line) {
-    std::string result = line;
-    std::smatch match;
+inline void ArrayTranspiler::processInitializedArrays(const std::string& line, size_t begin, size_t end, EditList& edits) const {
+    std::string_view segment = std::string_view(line).substr(begin, end - begin);
 
-    while (std::regex_search(result, match, array_init_pattern)) {
-        std::string type = trim(match[1].str());
-        std::string name = trim(match[2].str());
-        std::string size = match[3].str();
-        std::string initializer = match[4].str();
+    forEachPatternMatch<InitializedArrayPattern>(segment, [&](const PatternMatch& match) {
+        std::string type = trim(match.str(1));
+        std::string name = trim(match.str(2));
+        std::string size = match.str(3);
+        std::string initializer = match.str(4);
 
         std::string replacement = "std::array<" + type + ", " + size + "> " +
             name + " = " + initializer + "; // Convertido de arreglo C";
 
-        size_t pos = match.position();
-        size_t len = match.length();
-        result.replace(pos, len, replacement);
-    }
-
-    return result;
+        if (edits.replace(begin + match.position, match.length, std::move(replacement))) {
+            TranspilerStats::countRule(StatsRule::ArrayInitialized);
+        }
+    });
 }
 
-std::string ArrayTranspiler::processMultipleArrays(const std::string& line) {
-    std::string result = line;
-    std::smatch match;
+inline void ArrayTranspiler::processMultipleArrays(const std::string& line, size_t begin, size_t end, EditList& edits) const {
+    std::string_view segment = std::string_view(line).substr(begin, end - begin);
+    PatternMatch match;
 
-    if (std::regex_search(result, match, multi_array_pattern)) {
-        std::string type = trim(match[1].str());
-        std::string declarations = match[2].str();
+    // Solo se convierte la primera lista de declaraciones del tramo
+    for (size_t from = 0; searchPattern<MultipleArrayPattern>(segment, from, match); from = match.end()) {
+        size_t pos = begin + match.position;
 
-        std::string converted = convertMultipleArrayDeclarations(type, declarations);
+        if (edits.overlaps(pos, match.length)) continue;
 
-        size_t pos = match.position();
-        size_t len = match.length();
-        result.replace(pos, len, converted);
-    }
+        std::string type = trim(match.str(1));
+        std::string declarations = match.str(2);
 
-    return result;
+        edits.replace(pos, match.length, convertMultipleArrayDeclarations(type, declarations));
+        TranspilerStats::countRule(StatsRule::ArrayMultiple);
+        break;
+    }
 }
 
-std::string ArrayTranspiler::processSimpleArrays(const std::string& line) {
-    std::string result = line;
-    std::smatch match;
+inline void ArrayTranspiler::processSimpleArrays(const std::string& line, size_t begin, size_t end, EditList& edits) const {
+    std::string_view segment = std::string_view(line).substr(begin, end - begin);
 
-    while (std::regex_search(result, match, array_declaration_pattern)) {
-        std::string type = trim(match[1].str());
-        std::string name = trim(match[2].str());
-        std::string size = match[3].str();
+    size_t processed_at = findProcessedDeclaration(line, begin, end);
 
-        if (!isPartOfProcessedDeclaration(result, match.position())) {
-            std::string replacement = "std::array<" + type + ", " + size + "> " +
-                name + "; // Convertido de arreglo C";
+    forEachPatternMatch<ArrayDeclarationPattern>(segment, [&](const PatternMatch& match) {
+        size_t pos = begin + match.position;
 
-            size_t pos = match.position();
-            size_t len = match.length();
-            result.replace(pos, len, replacement);
+        // Una declaracion precedida por otra ya convertida se deja igual
+        if (processed_at < pos || edits.hasEditBetween(begin, pos)) {
+            return;
         }
-    }
 
-    return result;
+        std::string type = trim(match.str(1));
+        std::string name = trim(match.str(2));
+        std::string size = match.str(3);
+
+        std::string replacement = "std::array<" + type + ", " + size + "> " +
+            name + "; // Convertido de arreglo C";
+
+        if (edits.replace(pos, match.length, std::move(replacement))) {
+            TranspilerStats::countRule(StatsRule::ArrayDeclaration);
+        }
+    });
 }
 
-std::string ArrayTranspiler::convertMultipleArrayDeclarations(const std::string& type, const std::string& declarations) {
+inline std::string ArrayTranspiler::convertMultipleArrayDeclarations(const std::string& type, const std::string& declarations) const {
     std::string result;
-    std::regex single_decl_pattern{ R"(([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\])" };
-    std::sregex_iterator iter(declarations.begin(), declarations.end(), single_decl_pattern);
-    std::sregex_iterator end;
 
     bool first = true;
-    for (; iter != end; ++iter) {
-        const std::smatch& match = *iter;
-        std::string name = trim(match[1].str());
-        std::string size = match[2].str();
+    forEachPatternMatch<SizedDeclaratorPattern>(declarations, [&](const PatternMatch& match) {
+        std::string name = trim(match.str(1));
+        std::string size = match.str(2);
 
         if (!first) {
             result += "\n";
@@ -280,12 +303,12 @@ std::string ArrayTranspiler::convertMultipleArrayDeclarations(const std::string&
         first = false;
 
         result += "std::array<" + type + ", " + size + "> " + name + "; // Convertido de arreglo C";
-    }
+    });
 
     return result;
 }
 
-int ArrayTranspiler::countInitializerElements(const std::string& initializer) {
+inline int ArrayTranspiler::countInitializerElements(const std::string& initializer) const {
     if (initializer.length() < 2) return 0;
 
     std::string content = initializer.substr(1, initializer.length() - 2); // Remover { }
@@ -299,40 +322,27 @@ int ArrayTranspiler::countInitializerElements(const std::string& initializer) {
     return count;
 }
 
-bool ArrayTranspiler::isPartOfProcessedDeclaration(const std::string& line, size_t pos) {
-    if (pos > 0) {
-        std::string before = line.substr(0, pos);
-        return before.find("std::array") != std::string::npos;
-    }
-    return false;
-}
+inline size_t ArrayTranspiler::findProcessedDeclaration(const std::string& line, size_t begin, size_t end) const {
+    static constexpr std::string_view processed = "std::array";
 
-std::vector<ArrayTranspiler::StringRegion> ArrayTranspiler::findProtectedRegions(const std::string& line) {
-    std::vector<ArrayTranspiler::StringRegion> regions;
+    // Devuelve la posicion donde termina el primer "std::array" del tramo
+    std::string_view candidates = std::string_view(line).substr(begin, end - begin + processed.size() - 1);
+    size_t pos = candidates.find(processed);
+    if (pos == std::string_view::npos) return std::string::npos;
 
-    std::sregex_iterator iter(line.begin(), line.end(), string_literal_pattern);
-    std::sregex_iterator end;
-
-    for (; iter != end; ++iter) {
-        const std::smatch& match = *iter;
-        regions.emplace_back(match.position(), match.length());
-    }
-
-    std::sregex_iterator comment_iter(line.begin(), line.end(), comment_pattern);
-    for (; comment_iter != end; ++comment_iter) {
-        const std::smatch& match = *comment_iter;
-        regions.emplace_back(match.position(), match.length());
-    }
-
-    std::sort(regions.begin(), regions.end(),
-        [](const StringRegion& a, const StringRegion& b) {
-            return a.start < b.start;
-        });
+    return begin + pos + processed.size() - 1;
+}
 
-    return regions;
+inline void ArrayTranspiler::findProtectedRegions(const std::vector<Token>& tokens, size_t line_length,
+    std::vector<ProtectedRegion>& protected_regions) const {
+    // Los literales de cadena y los comentarios (incluidos los que abarcan
+    // varias lineas) vienen ya delimitados por el lexer
+    size_t cursor = 0;
+    CLexer::collectProtectedRegions(tokens, cursor, 0, line_length,
+        CLexer::protect_strings_and_comments, protected_regions);
 }
 
-std::string ArrayTranspiler::trim(const std::string& str) {
+inline std::string ArrayTranspiler::trim(const std::string& str) const {
     size_t start = str.find_first_not_of(" \t\r\n");
     if (start == std::string::npos) return "";
 
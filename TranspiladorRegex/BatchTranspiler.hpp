@@ -0,0 +1,299 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.hpp"
+#include "TranspileCache.hpp"
+#include "TranspilerPipeline.hpp"
+#include "WorkStealingPool.hpp"
+
+// Un archivo del lote: de donde se lee, donde se escribe y su tamano
+struct BatchJob {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    uintmax_t size = 0;
+};
+
+struct BatchSummary {
+    size_t files = 0;
+    size_t failures = 0;
+    uintmax_t bytes = 0;
+    double seconds = 0;
+
+    void print(std::ostream& out) const;
+};
+
+// Transpila muchos archivos en paralelo y escribe un arbol de salida que refleja
+// el de entrada (los .c pasan a .cpp). La entrada puede ser un directorio (se
+// toman los .c y .h), un patron con '*', '?' o '**' (p. ej. "src/**/*.c") o un
+// manifiesto "@lista.txt" con una ruta por linea.
+class BatchTranspiler {
+private:
+    PipelineMode mode;
+    size_t worker_count;
+
+    // Opcional: los archivos sin cambios se toman de la cache sin transpilarlos
+    TranspileCache* cache;
+
+    // Opcional: estadisticas por etapa y un intervalo de traza por archivo
+    Instrumentation instrumentation;
+
+public:
+    explicit BatchTranspiler(PipelineMode mode = PipelineMode::Fused, size_t workers = 0,
+        TranspileCache* cache = nullptr, const Instrumentation& instrumentation = {});
+
+    std::vector<BatchJob> collectJobs(const std::string& source, const std::filesystem::path& output_dir) const;
+
+    // Los archivos grandes se empiezan primero para no dejar uno largo al final.
+    // Los errores de cada archivo se informan en 'errors' y se cuentan en el resumen
+    BatchSummary run(const std::vector<BatchJob>& jobs, std::ostream& errors) const;
+
+    // '*' y '?' no cruzan '/'; "**/" abarca cualquier cantidad de directorios
+    static bool matchGlob(std::string_view pattern, std::string_view path);
+
+    static bool isSourceFile(const std::filesystem::path& path);
+
+    // Ruta de salida relativa: los .c pasan a .cpp
+    static std::filesystem::path outputName(const std::filesystem::path& relative);
+
+private:
+    static void addJob(std::vector<BatchJob>& jobs, const std::filesystem::path& input,
+        const std::filesystem::path& relative, const std::filesystem::path& output_dir);
+};
+
+
+inline void BatchSummary::print(std::ostream& out) const
+{
+    double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    double elapsed = seconds > 0 ? seconds : 1e-9;
+
+    out << std::fixed << std::setprecision(2)
+        << "Archivos: " << files << " (" << failures << " con error), "
+        << megabytes << " MB en " << seconds << " s: "
+        << static_cast<double>(files) / elapsed << " archivos/s, "
+        << megabytes / elapsed << " MB/s\n";
+}
+
+inline BatchTranspiler::BatchTranspiler(PipelineMode mode, size_t workers, TranspileCache* cache,
+    const Instrumentation& instrumentation)
+    : mode(mode), worker_count(workers), cache(cache), instrumentation(instrumentation)
+{
+}
+
+inline bool BatchTranspiler::isSourceFile(const std::filesystem::path& path)
+{
+    auto extension = path.extension();
+    return extension == ".c" || extension == ".h";
+}
+
+inline std::filesystem::path BatchTranspiler::outputName(const std::filesystem::path& relative)
+{
+    std::filesystem::path output = relative;
+    if (output.extension() == ".c") {
+        output.replace_extension(".cpp");
+    }
+    return output;
+}
+
+inline void BatchTranspiler::addJob(std::vector<BatchJob>& jobs, const std::filesystem::path& input,
+    const std::filesystem::path& relative, const std::filesystem::path& output_dir)
+{
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(input, error);
+
+    jobs.push_back(BatchJob{ input, output_dir / outputName(relative), error ? 0 : size });
+}
+
+inline std::vector<BatchJob> BatchTranspiler::collectJobs(const std::string& source,
+    const std::filesystem::path& output_dir) const
+{
+    namespace fs = std::filesystem;
+    std::vector<BatchJob> jobs;
+
+    // Manifiesto: una ruta por linea
+    if (!source.empty() && source[0] == '@') {
+        std::ifstream manifest(source.substr(1));
+        if (!manifest.is_open()) {
+            throw std::runtime_error("No se pudo abrir el manifiesto: " + source.substr(1));
+        }
+
+        std::string line;
+        while (std::getline(manifest, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+
+            fs::path input(line);
+            fs::path relative = input.lexically_normal();
+
+            // Las rutas absolutas o que salen del directorio actual se reflejan sin la raiz
+            if (relative.is_absolute() || (!relative.empty() && *relative.begin() == "..")) {
+                relative = fs::absolute(input).lexically_normal().relative_path();
+            }
+
+            addJob(jobs, input, relative, output_dir);
+        }
+        return jobs;
+    }
+
+    // Patron: el directorio base es el prefijo sin comodines
+    if (source.find_first_of("*?") != std::string::npos) {
+        std::string pattern = fs::path(source).generic_string();
+        size_t wildcard = pattern.find_first_of("*?");
+        size_t slash = pattern.rfind('/', wildcard);
+
+        fs::path base = slash == std::string::npos ? fs::path(".") : fs::path(pattern.substr(0, slash + 1));
+        std::string relative_pattern = slash == std::string::npos ? pattern : pattern.substr(slash + 1);
+
+        if (!fs::is_directory(base)) {
+            throw std::runtime_error("No existe el directorio: " + base.string());
+        }
+
+        for (const auto& entry : fs::recursive_directory_iterator(base)) {
+            if (!entry.is_regular_file()) continue;
+
+            fs::path relative = entry.path().lexically_relative(base);
+            if (matchGlob(relative_pattern, relative.generic_string())) {
+                addJob(jobs, entry.path(), relative, output_dir);
+            }
+        }
+        return jobs;
+    }
+
+    if (!fs::is_directory(source)) {
+        throw std::runtime_error("No existe el directorio: " + source);
+    }
+
+    for (const auto& entry : fs::recursive_directory_iterator(source)) {
+        if (entry.is_regular_file() && isSourceFile(entry.path())) {
+            addJob(jobs, entry.path(), entry.path().lexically_relative(source), output_dir);
+        }
+    }
+    return jobs;
+}
+
+inline bool BatchTranspiler::matchGlob(std::string_view pattern, std::string_view path)
+{
+    while (!pattern.empty()) {
+        if (pattern.substr(0, 2) == "**") {
+            std::string_view rest = pattern.substr(2);
+
+            // "**/" abarca cero o mas directorios completos
+            if (!rest.empty() && rest[0] == '/') {
+                rest.remove_prefix(1);
+                if (matchGlob(rest, path)) return true;
+
+                for (size_t i = 0; i < path.size(); ++i) {
+                    if (path[i] == '/' && matchGlob(rest, path.substr(i + 1))) return true;
+                }
+                return false;
+            }
+
+            // Cualquier otro "**" abarca cualquier texto, incluso '/'
+            for (size_t i = 0; i <= path.size(); ++i) {
+                if (matchGlob(rest, path.substr(i))) return true;
+            }
+            return false;
+        }
+
+        if (pattern[0] == '*') {
+            std::string_view rest = pattern.substr(1);
+            for (size_t i = 0; i <= path.size(); ++i) {
+                if (matchGlob(rest, path.substr(i))) return true;
+                if (i < path.size() && path[i] == '/') break;
+            }
+            return false;
+        }
+
+        if (path.empty()) return false;
+        if (pattern[0] == '?' ? path[0] == '/' : pattern[0] != path[0]) return false;
+
+        pattern.remove_prefix(1);
+        path.remove_prefix(1);
+    }
+
+    return path.empty();
+}
+
+inline BatchSummary BatchTranspiler::run(const std::vector<BatchJob>& jobs, std::ostream& errors) const
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Los directorios de salida se crean antes de repartir el trabajo
+    std::vector<std::filesystem::path> directories;
+    for (const auto& job : jobs) {
+        directories.push_back(job.output.parent_path());
+    }
+    std::sort(directories.begin(), directories.end());
+    directories.erase(std::unique(directories.begin(), directories.end()), directories.end());
+
+    for (const auto& directory : directories) {
+        std::error_code error;
+        if (!directory.empty()) std::filesystem::create_directories(directory, error);
+    }
+
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return jobs[a].size > jobs[b].size; });
+
+    WorkStealingPool pool(worker_count);
+    std::vector<TranspilerPipeline> pipelines(pool.size());
+    if (instrumentation.enabled()) {
+        for (auto& pipeline : pipelines) pipeline.instrument(instrumentation);
+    }
+
+    std::atomic<size_t> failures{ 0 };
+    std::atomic<uintmax_t> bytes{ 0 };
+    std::mutex errors_mutex;
+
+    auto fail = [&](const BatchJob& job, const std::string& message) {
+        ++failures;
+        std::lock_guard<std::mutex> lock(errors_mutex);
+        errors << job.input.string() << ": " << message << "\n";
+    };
+
+    pool.run(order, [&](size_t worker, size_t index) {
+        const BatchJob& job = jobs[index];
+        auto job_start = std::chrono::steady_clock::now();
+
+        try {
+            MappedFile input;
+            if (!input.open(job.input.string())) {
+                fail(job, "no se pudo abrir");
+                return;
+            }
+
+            auto transpile = [&] { return pipelines[worker].transpile(input.view(), mode); };
+            std::string result = cache != nullptr ? cache->transpile(input.view(), all_passes, transpile) : transpile();
+            bytes += input.view().size();
+
+            if (!writeFile(job.output.string(), result)) {
+                fail(job, "no se pudo escribir " + job.output.string());
+            }
+        }
+        catch (const std::exception& e) {
+            fail(job, e.what());
+        }
+
+        if (instrumentation.trace != nullptr) {
+            instrumentation.trace->complete(job.input.string(), "archivo", job_start, std::chrono::steady_clock::now(),
+                "\"bytes\":" + std::to_string(job.size));
+        }
+    });
+
+    BatchSummary summary;
+    summary.files = jobs.size();
+    summary.failures = failures;
+    summary.bytes = bytes;
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return summary;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonLine.hpp"
+#include "MappedFile.hpp"
+
+// Lo que comparten los programas de medicion: la carga de las muestras de
+// AfinamientoLLM y el resumen de los tiempos de varias repeticiones
+class BenchmarkTools {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static double seconds(Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    // Agrega a 'samples' el campo "source_code" de cada linea del archivo JSONL.
+    // Las lineas en blanco se saltan; las que no tienen el campo se informan por
+    // std::cerr. Devuelve false si el archivo no se pudo abrir
+    static bool loadSamples(const std::string& path, std::vector<std::string>& samples);
+
+    // Entero decimal en [min, max] que ocupa todo 'text'; si no, devuelve false y no
+    // modifica 'value'
+    static bool parseCount(std::string_view text, size_t min, size_t max, size_t& value);
+
+    static double median(std::vector<double> values);
+
+    static double best(const std::vector<double>& values);
+};
+
+
+inline bool BenchmarkTools::loadSamples(const std::string& path, std::vector<std::string>& samples)
+{
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    std::string_view content = file.view();
+    std::string source;
+    size_t skipped = 0;
+
+    for (size_t start = 0; start < content.size();) {
+        size_t end = content.find('\n', start);
+        if (end == std::string_view::npos) end = content.size();
+
+        std::string_view line = content.substr(start, end - start);
+        if (line.find_first_not_of(" \t\r") != std::string_view::npos) {
+            if (JsonLine::findString(line, "source_code", source)) samples.push_back(source);
+            else ++skipped;
+        }
+        start = end + 1;
+    }
+
+    if (skipped > 0) std::cerr << path << ": " << skipped << " lineas sin \"source_code\"\n";
+    return true;
+}
+
+inline bool BenchmarkTools::parseCount(std::string_view text, size_t min, size_t max, size_t& value)
+{
+    size_t parsed = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+    if (error != std::errc() || end != text.data() + text.size() || parsed < min || parsed > max) return false;
+
+    value = parsed;
+    return true;
+}
+
+inline double BenchmarkTools::median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.empty() ? 0 : values[values.size() / 2];
+}
+
+inline double BenchmarkTools::best(const std::vector<double>& values)
+{
+    return values.empty() ? 0 : *std::min_element(values.begin(), values.end());
+}
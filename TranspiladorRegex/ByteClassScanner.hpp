@@ -0,0 +1,327 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TRANSPILER_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC y Clang necesitan habilitar el conjunto de instrucciones por funcion para
+// poder elegirlo en tiempo de ejecucion; MSVC acepta los intrinsecos sin mas
+#if defined(TRANSPILER_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#define TRANSPILER_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define TRANSPILER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TRANSPILER_TARGET_SSE42
+#define TRANSPILER_TARGET_AVX2
+#endif
+
+// Nivel de instrucciones usado por el escaner
+enum class ScannerLevel {
+    Scalar,
+    SSE42,
+    AVX2
+};
+
+inline const char* scannerLevelName(ScannerLevel level)
+{
+    switch (level) {
+    case ScannerLevel::SSE42: return "sse4.2";
+    case ScannerLevel::AVX2: return "avx2";
+    default: return "escalar";
+    }
+}
+
+// Mapas de bits de un buffer completo: el bit i indica la clase del byte i
+struct ByteClassBitmaps {
+    std::vector<uint64_t> newlines;
+    std::vector<uint64_t> specials;
+    size_t size = 0;
+
+    // Posicion del primer '\n' en [from, size); 'size' si no hay
+    size_t nextNewline(size_t from) const;
+
+    // Llama a 'handler(pos)' por cada byte especial en [begin, end), en orden
+    template <typename PositionHandler>
+    void forEachSpecial(size_t begin, size_t end, PositionHandler&& handler) const;
+};
+
+// Clasifica todos los bytes de un buffer en una sola pasada: saltos de linea y un
+// conjunto de hasta 16 bytes especiales. Usa AVX2 o SSE4.2 si el procesador los
+// tiene (se detecta una sola vez con CPUID) y recorre byte a byte en otro caso.
+class ByteClassScanner {
+private:
+    static constexpr size_t max_special_count = 16;
+
+    std::array<char, max_special_count> special_chars{};
+    size_t special_count = 0;
+    // Clase de cada byte para la version escalar: bit 0 '\n', bit 1 especial
+    std::array<uint8_t, 256> byte_class{};
+
+public:
+    explicit ByteClassScanner(std::string_view specials);
+
+    void scan(std::string_view text, ByteClassBitmaps& bitmaps) const;
+
+    // Fuerza un nivel (para comparar implementaciones); si el procesador no lo
+    // admite se usa el mejor disponible
+    void scan(std::string_view text, ByteClassBitmaps& bitmaps, ScannerLevel level) const;
+
+    // Mejor nivel admitido por el procesador y el sistema operativo
+    static ScannerLevel detectedLevel();
+
+private:
+    // Cada implementacion llena las palabras [first_word, word_count) del mapa
+    void scanScalar(std::string_view text, ByteClassBitmaps& bitmaps, size_t first_word) const;
+
+    size_t scanSSE42(std::string_view text, ByteClassBitmaps& bitmaps) const;
+
+    size_t scanAVX2(std::string_view text, ByteClassBitmaps& bitmaps) const;
+
+    static ScannerLevel probeLevel();
+};
+
+
+inline size_t ByteClassBitmaps::nextNewline(size_t from) const
+{
+    if (from >= size) return size;
+
+    size_t word = from / 64;
+    uint64_t bits = newlines[word] & (~uint64_t{ 0 } << (from % 64));
+
+    while (bits == 0) {
+        if (++word == newlines.size()) return size;
+        bits = newlines[word];
+    }
+
+    size_t pos = word * 64 + static_cast<size_t>(std::countr_zero(bits));
+    return pos < size ? pos : size;
+}
+
+template <typename PositionHandler>
+void ByteClassBitmaps::forEachSpecial(size_t begin, size_t end, PositionHandler&& handler) const
+{
+    if (end > size) end = size;
+    if (begin >= end) return;
+
+    size_t word = begin / 64;
+    size_t last_word = (end - 1) / 64;
+    uint64_t bits = specials[word] & (~uint64_t{ 0 } << (begin % 64));
+
+    for (;;) {
+        if (word == last_word && end % 64 != 0) {
+            bits &= (uint64_t{ 1 } << (end % 64)) - 1;
+        }
+
+        while (bits != 0) {
+            handler(word * 64 + static_cast<size_t>(std::countr_zero(bits)));
+            bits &= bits - 1;
+        }
+
+        if (word == last_word) return;
+        bits = specials[++word];
+    }
+}
+
+inline ByteClassScanner::ByteClassScanner(std::string_view specials)
+{
+    if (specials.size() > max_special_count) {
+        throw std::invalid_argument("ByteClassScanner admite como maximo 16 bytes especiales");
+    }
+
+    byte_class['\n'] = 1;
+
+    for (char c : specials) {
+        auto byte = static_cast<unsigned char>(c);
+        if (c == '\n' || byte_class[byte] != 0) continue;
+        byte_class[byte] = 2;
+        special_chars[special_count++] = c;
+    }
+}
+
+inline ScannerLevel ByteClassScanner::detectedLevel()
+{
+    static const ScannerLevel level = probeLevel();
+    return level;
+}
+
+inline ScannerLevel ByteClassScanner::probeLevel()
+{
+#if defined(TRANSPILER_X86_SIMD) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse42 = (info[2] & (1 << 20)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+
+    // AVX2 requiere ademas que el sistema guarde los registros YMM
+    bool avx2 = false;
+    if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+
+    if (avx2) return ScannerLevel::AVX2;
+    if (sse42) return ScannerLevel::SSE42;
+    return ScannerLevel::Scalar;
+#elif defined(TRANSPILER_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return ScannerLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return ScannerLevel::SSE42;
+    return ScannerLevel::Scalar;
+#else
+    return ScannerLevel::Scalar;
+#endif
+}
+
+inline void ByteClassScanner::scan(std::string_view text, ByteClassBitmaps& bitmaps) const
+{
+    scan(text, bitmaps, detectedLevel());
+}
+
+inline void ByteClassScanner::scan(std::string_view text, ByteClassBitmaps& bitmaps, ScannerLevel level) const
+{
+    size_t word_count = (text.size() + 63) / 64;
+    bitmaps.size = text.size();
+    bitmaps.newlines.assign(word_count, 0);
+    bitmaps.specials.assign(word_count, 0);
+
+    if (level > detectedLevel()) {
+        level = detectedLevel();
+    }
+
+    // Las versiones vectoriales procesan bloques de 64 bytes y devuelven cuantas
+    // palabras completaron; el resto se termina byte a byte
+    size_t done = 0;
+    if (level == ScannerLevel::AVX2) {
+        done = scanAVX2(text, bitmaps);
+    }
+    else if (level == ScannerLevel::SSE42) {
+        done = scanSSE42(text, bitmaps);
+    }
+
+    scanScalar(text, bitmaps, done);
+}
+
+inline void ByteClassScanner::scanScalar(std::string_view text, ByteClassBitmaps& bitmaps, size_t first_word) const
+{
+    const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+    size_t word_count = (text.size() + 63) / 64;
+
+    // Sin saltos condicionales: cada byte aporta su bit a las dos palabras
+    for (size_t word = first_word; word < word_count; ++word) {
+        size_t begin = word * 64;
+        size_t count = std::min<size_t>(64, text.size() - begin);
+        uint64_t newline_bits = 0;
+        uint64_t special_bits = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t kind = byte_class[data[begin + i]];
+            newline_bits |= (kind & 1) << i;
+            special_bits |= (kind >> 1) << i;
+        }
+
+        bitmaps.newlines[word] = newline_bits;
+        bitmaps.specials[word] = special_bits;
+    }
+}
+
+#if defined(TRANSPILER_X86_SIMD)
+
+TRANSPILER_TARGET_SSE42
+inline size_t ByteClassScanner::scanSSE42(std::string_view text, ByteClassBitmaps& bitmaps) const
+{
+    // PCMPESTRM compara cada byte del bloque con todo el conjunto a la vez
+    constexpr int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+
+    alignas(16) char set_bytes[16] = {};
+    for (size_t i = 0; i < special_count; ++i) set_bytes[i] = special_chars[i];
+
+    const __m128i set = _mm_load_si128(reinterpret_cast<const __m128i*>(set_bytes));
+    const __m128i newline = _mm_set1_epi8('\n');
+    const int set_length = static_cast<int>(special_count);
+    const char* data = text.data();
+    size_t words = text.size() / 64;
+
+    for (size_t word = 0; word < words; ++word) {
+        uint64_t newline_bits = 0;
+        uint64_t special_bits = 0;
+
+        for (size_t part = 0; part < 4; ++part) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + word * 64 + part * 16));
+
+            auto newline_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+            newline_bits |= uint64_t{ newline_mask } << (part * 16);
+
+            if (set_length > 0) {
+                __m128i found = _mm_cmpestrm(set, set_length, block, 16, mode);
+                auto special_mask = static_cast<uint32_t>(_mm_cvtsi128_si32(found)) & 0xFFFFu;
+                special_bits |= uint64_t{ special_mask } << (part * 16);
+            }
+        }
+
+        bitmaps.newlines[word] = newline_bits;
+        bitmaps.specials[word] = special_bits;
+    }
+
+    return words;
+}
+
+TRANSPILER_TARGET_AVX2
+inline size_t ByteClassScanner::scanAVX2(std::string_view text, ByteClassBitmaps& bitmaps) const
+{
+    __m256i set[max_special_count];
+    for (size_t i = 0; i < special_count; ++i) set[i] = _mm256_set1_epi8(special_chars[i]);
+
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const char* data = text.data();
+    size_t words = text.size() / 64;
+
+    for (size_t word = 0; word < words; ++word) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + word * 64));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + word * 64 + 32));
+
+        __m256i low_special = _mm256_setzero_si256();
+        __m256i high_special = _mm256_setzero_si256();
+        for (size_t i = 0; i < special_count; ++i) {
+            low_special = _mm256_or_si256(low_special, _mm256_cmpeq_epi8(low, set[i]));
+            high_special = _mm256_or_si256(high_special, _mm256_cmpeq_epi8(high, set[i]));
+        }
+
+        auto low_newline = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline)));
+        auto high_newline = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)));
+        auto low_mask = static_cast<uint32_t>(_mm256_movemask_epi8(low_special));
+        auto high_mask = static_cast<uint32_t>(_mm256_movemask_epi8(high_special));
+
+        bitmaps.newlines[word] = uint64_t{ low_newline } | uint64_t{ high_newline } << 32;
+        bitmaps.specials[word] = uint64_t{ low_mask } | uint64_t{ high_mask } << 32;
+    }
+
+    return words;
+}
+
+#else
+
+inline size_t ByteClassScanner::scanSSE42(std::string_view, ByteClassBitmaps&) const
+{
+    return 0;
+}
+
+inline size_t ByteClassScanner::scanAVX2(std::string_view, ByteClassBitmaps&) const
+{
+    return 0;
+}
+
+#endif
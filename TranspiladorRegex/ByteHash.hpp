@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// MurmurHash64A: rapido para lineas cortas y para archivos completos. Distintas
+// semillas dan hashes independientes de los mismos bytes
+inline uint64_t hashBytes(std::string_view data, uint64_t seed)
+{
+    constexpr uint64_t m = 0xc6a4a7935bd1e995ull;
+    constexpr int r = 47;
+
+    uint64_t h = seed ^ (static_cast<uint64_t>(data.size()) * m);
+
+    size_t blocks = data.size() / 8;
+    for (size_t i = 0; i < blocks; ++i) {
+        uint64_t k;
+        std::memcpy(&k, data.data() + i * 8, 8);
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    std::string_view tail = data.substr(blocks * 8);
+    if (!tail.empty()) {
+        for (size_t i = 0; i < tail.size(); ++i) {
+            h ^= static_cast<uint64_t>(static_cast<unsigned char>(tail[i])) << (8 * i);
+        }
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h;
+}
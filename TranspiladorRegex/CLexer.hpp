@@ -0,0 +1,537 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tipos de token que reconoce el lexer de C
+enum class TokenKind {
+    Identifier,
+    Keyword,
+    NumberLiteral,
+    StringLiteral,
+    CharLiteral,
+    HeaderName,
+    Comment,
+    Preprocessor,
+    Punctuation
+};
+
+// Bit de un tipo de token, para armar mascaras de tipos
+constexpr unsigned tokenKindBit(TokenKind kind) {
+    return 1u << static_cast<unsigned>(kind);
+}
+
+// Token con su posicion en bytes dentro del archivo completo. Los offsets de 32 bits
+// reducen a la mitad el vector de tokens de una linea larga (tokenizeLine rechaza
+// offsets de mas de 4 GB)
+struct Token {
+    TokenKind kind;
+    uint32_t offset;
+    uint32_t length;
+
+    size_t end() const { return size_t{ offset } + length; }
+};
+
+// Region de una linea que los transpiladores no deben modificar
+// (literales de cadena o comentarios)
+struct ProtectedRegion {
+    size_t start;
+    size_t length;
+
+    ProtectedRegion(size_t s, size_t l) : start(s), length(l) {}
+};
+
+// Directiva #include con su encabezado (<...> o "..."), siempre en una sola linea
+struct IncludeDirective {
+    size_t start;           // posicion del '#'
+    size_t end;             // posicion justo despues del encabezado
+    std::string_view header;
+};
+
+// Estado del lexer al final de una linea, para reanudar el analisis en la siguiente.
+// Permite procesar un archivo linea a linea (o por bloques de lineas) y obtener
+// exactamente los mismos tokens que al analizarlo completo.
+struct LexState {
+    enum class Mode : unsigned char {
+        Code,
+        BlockComment,   // dentro de /* ... */
+        LineComment,    // comentario // continuado con '\' al final de linea
+        StringLiteral,  // literal continuado con '\' al final de linea
+        CharLiteral
+    };
+
+    Mode mode = Mode::Code;
+    bool at_line_start = true;     // solo espacios desde el ultimo salto de linea
+    bool expect_header = false;    // justo despues de #include
+
+    bool operator==(const LexState&) const = default;
+};
+
+// Lexer de C escrito a mano: recorre el archivo una sola vez, en tiempo lineal,
+// y produce la secuencia de tokens con sus offsets. Los comentarios de bloque y
+// los literales que continuan con '\' al final de linea abarcan varias lineas.
+class CLexer {
+public:
+    std::vector<Token> tokenize(std::string_view source) const;
+
+    // Analiza una sola linea (sin el '\n') partiendo del estado de la linea anterior.
+    // Los offsets se desplazan en 'base'. Con 'merge', un token abierto en la linea
+    // anterior se extiende en lugar de agregarse como un token nuevo.
+    void tokenizeLine(std::string_view line, bool has_newline, LexState& state,
+        std::vector<Token>& tokens, size_t base = 0, bool merge = false) const;
+
+    // Avanza el estado sobre una linea sin '/', '"', '\'', '\\' ni '#' (solo
+    // identificadores, numeros, espacios y puntuacion) sin generar tokens.
+    // Devuelve false si el estado no lo permite; la linea debe analizarse entonces
+    static bool skipPlainLine(std::string_view line, bool has_newline, LexState& state);
+
+    // Avanza el estado sobre una linea cuyos tokens no interesan, sin guardarlos. Con
+    // 'plain' el llamador garantiza que la linea no tiene esos caracteres (ver skipPlainLine)
+    void skipLine(std::string_view line, bool has_newline, LexState& state, bool plain) const;
+
+    // Mascaras para seleccionar que tokens protegen una linea
+    static constexpr unsigned protect_strings_and_comments =
+        tokenKindBit(TokenKind::StringLiteral) | tokenKindBit(TokenKind::Comment);
+
+    static constexpr unsigned protect_comments = tokenKindBit(TokenKind::Comment);
+
+    // Recorta a la linea [line_start, line_end) los tokens protegidos que la tocan.
+    // 'cursor' avanza de forma monotona, por lo que recorrer todas las lineas en
+    // orden cuesta O(tokens + lineas). Las regiones resultantes son relativas a
+    // line_start, estan ordenadas y no se solapan.
+    static void collectProtectedRegions(const std::vector<Token>& tokens, size_t& cursor,
+        size_t line_start, size_t line_end, unsigned kinds,
+        std::vector<ProtectedRegion>& regions);
+
+    // Directiva "#include" real dentro de los tokens de una linea (a lo sumo hay una)
+    static bool findIncludeDirective(std::string_view line, const std::vector<Token>& tokens,
+        IncludeDirective& directive);
+
+    // Indica si el archivo tiene alguna directiva #include; se detiene en la primera
+    bool hasIncludeDirective(std::string_view source) const;
+
+    // Inicio de la linea con la primera directiva #include, o npos si no hay ninguna
+    size_t findFirstIncludeLine(std::string_view source) const;
+
+    static bool isKeyword(std::string_view word);
+
+private:
+    static bool isIdentifierStart(unsigned char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    static bool isIdentifierChar(unsigned char c) {
+        return isIdentifierStart(c) || (c >= '0' && c <= '9');
+    }
+
+    static bool isDigit(unsigned char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool isHorizontalSpace(unsigned char c) {
+        return c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r';
+    }
+
+    static bool isSpliceAt(std::string_view line, size_t pos, bool has_newline);
+
+    static bool endsWithSplice(std::string_view line, size_t from, bool has_newline);
+
+    static size_t scanQuoted(std::string_view line, size_t pos, char quote, bool has_newline, bool& open);
+
+    static size_t scanNumber(std::string_view line, size_t pos);
+
+    static size_t scanIdentifier(std::string_view line, size_t pos);
+
+    static void emit(std::vector<Token>& tokens, TokenKind kind, size_t start, size_t end,
+        bool continues, bool merge);
+
+    // Recorrido comun de tokenizeLine y skipLine: entrega cada token a
+    // 'emit_token'(kind, start, end, continues), con offsets relativos a la linea
+    template <typename EmitToken>
+    void scanLine(std::string_view line, bool has_newline, LexState& state, EmitToken&& emit_token) const;
+};
+
+
+inline std::vector<Token> CLexer::tokenize(std::string_view src) const {
+    std::vector<Token> tokens;
+    tokens.reserve(src.size() / 4 + 1);
+
+    LexState state;
+    size_t line_start = 0;
+
+    while (line_start < src.size()) {
+        size_t line_end = src.find('\n', line_start);
+        bool has_newline = line_end != std::string_view::npos;
+        if (!has_newline) line_end = src.size();
+
+        tokenizeLine(src.substr(line_start, line_end - line_start), has_newline, state,
+            tokens, line_start, true);
+
+        line_start = line_end + 1;
+    }
+
+    return tokens;
+}
+
+inline void CLexer::tokenizeLine(std::string_view line, bool has_newline, LexState& state,
+    std::vector<Token>& tokens, size_t base, bool merge) const
+{
+    if (base + line.size() > UINT32_MAX) {
+        throw std::length_error("El lexer no admite offsets de mas de 4 GB");
+    }
+
+    scanLine(line, has_newline, state, [&](TokenKind kind, size_t start, size_t end, bool continues) {
+        emit(tokens, kind, base + start, base + end, continues, merge);
+    });
+}
+
+template <typename EmitToken>
+inline void CLexer::scanLine(std::string_view line, bool has_newline, LexState& state, EmitToken&& emit_token) const
+{
+    const size_t n = line.size();
+    size_t pos = 0;
+
+    // Continuar el token que quedo abierto en la linea anterior
+    if (state.mode != LexState::Mode::Code) {
+        TokenKind kind = TokenKind::Comment;
+        bool open = false;
+
+        switch (state.mode) {
+        case LexState::Mode::BlockComment: {
+            size_t close = line.find("*/");
+            open = close == std::string_view::npos;
+            pos = open ? n : close + 2;
+            break;
+        }
+        case LexState::Mode::LineComment:
+            pos = n;
+            open = endsWithSplice(line, 0, has_newline);
+            break;
+        case LexState::Mode::StringLiteral:
+        case LexState::Mode::CharLiteral: {
+            bool is_string = state.mode == LexState::Mode::StringLiteral;
+            kind = is_string ? TokenKind::StringLiteral : TokenKind::CharLiteral;
+            pos = scanQuoted(line, 0, is_string ? '"' : '\'', has_newline, open);
+            break;
+        }
+        default:
+            break;
+        }
+
+        emit_token(kind, 0, pos, true);
+        if (open) return;
+        state.mode = LexState::Mode::Code;
+    }
+
+    bool spliced = false;
+
+    while (pos < n) {
+        unsigned char c = static_cast<unsigned char>(line[pos]);
+
+        if (isHorizontalSpace(c)) {
+            ++pos;
+            continue;
+        }
+
+        if (c == '\\' && isSpliceAt(line, pos, has_newline)) {
+            spliced = true;
+            break;
+        }
+
+        size_t start = pos;
+        TokenKind kind;
+        bool open = false;
+
+        if (c == '/' && pos + 1 < n && line[pos + 1] == '/') {
+            kind = TokenKind::Comment;
+            pos = n;
+            // Un '\' al final de la linea continua el comentario en la siguiente
+            if (endsWithSplice(line, start + 2, has_newline)) {
+                open = true;
+                state.mode = LexState::Mode::LineComment;
+            }
+        }
+        else if (c == '/' && pos + 1 < n && line[pos + 1] == '*') {
+            kind = TokenKind::Comment;
+            size_t close = line.find("*/", pos + 2);
+            if (close == std::string_view::npos) {
+                pos = n;
+                open = true;
+                state.mode = LexState::Mode::BlockComment;
+            }
+            else {
+                pos = close + 2;
+            }
+        }
+        else if (c == '"' || c == '\'') {
+            kind = c == '"' ? TokenKind::StringLiteral : TokenKind::CharLiteral;
+            pos = scanQuoted(line, pos + 1, static_cast<char>(c), has_newline, open);
+            if (open) {
+                state.mode = c == '"' ? LexState::Mode::StringLiteral : LexState::Mode::CharLiteral;
+            }
+        }
+        else if (c == '<' && state.expect_header) {
+            size_t close = line.find('>', pos + 1);
+            if (close != std::string_view::npos) {
+                kind = TokenKind::HeaderName;
+                pos = close + 1;
+            }
+            else {
+                kind = TokenKind::Punctuation;
+                ++pos;
+            }
+        }
+        else if (c == '#' && state.at_line_start) {
+            // Directiva: '#', espacios opcionales y el nombre de la directiva
+            kind = TokenKind::Preprocessor;
+            ++pos;
+            while (pos < n && isHorizontalSpace(static_cast<unsigned char>(line[pos]))) ++pos;
+            size_t name_start = pos;
+            pos = scanIdentifier(line, pos);
+            state.expect_header = line.substr(name_start, pos - name_start) == "include";
+        }
+        else if (isDigit(c) || (c == '.' && pos + 1 < n && isDigit(static_cast<unsigned char>(line[pos + 1])))) {
+            kind = TokenKind::NumberLiteral;
+            pos = scanNumber(line, pos);
+        }
+        else if (isIdentifierStart(c)) {
+            pos = scanIdentifier(line, pos);
+            std::string_view word = line.substr(start, pos - start);
+
+            // Prefijos de codificacion: L"..", u"..", U"..", u8".." y sus variantes de char
+            bool is_prefix = word == "L" || word == "u" || word == "U" || word == "u8";
+            if (is_prefix && pos < n && (line[pos] == '"' || line[pos] == '\'')) {
+                char quote = line[pos];
+                kind = quote == '"' ? TokenKind::StringLiteral : TokenKind::CharLiteral;
+                pos = scanQuoted(line, pos + 1, quote, has_newline, open);
+                if (open) {
+                    state.mode = quote == '"' ? LexState::Mode::StringLiteral : LexState::Mode::CharLiteral;
+                }
+            }
+            else {
+                kind = isKeyword(word) ? TokenKind::Keyword : TokenKind::Identifier;
+            }
+        }
+        else {
+            kind = TokenKind::Punctuation;
+            ++pos;
+        }
+
+        if (kind != TokenKind::Comment && kind != TokenKind::Preprocessor) {
+            state.at_line_start = false;
+        }
+        if (kind != TokenKind::Preprocessor) {
+            state.expect_header = false;
+        }
+
+        emit_token(kind, start, pos, false);
+        if (open) return;
+    }
+
+    // El salto de linea reinicia el estado, salvo que la linea se una con la siguiente
+    if (has_newline && !spliced) {
+        state.at_line_start = true;
+        state.expect_header = false;
+    }
+}
+
+inline bool CLexer::skipPlainLine(std::string_view line, bool has_newline, LexState& state)
+{
+    if (state.mode != LexState::Mode::Code || state.expect_header) {
+        return false;
+    }
+
+    if (!has_newline && state.at_line_start) {
+        for (char c : line) {
+            if (!isHorizontalSpace(static_cast<unsigned char>(c))) {
+                state.at_line_start = false;
+                break;
+            }
+        }
+        return true;
+    }
+
+    state.at_line_start = has_newline;
+    return true;
+}
+
+inline void CLexer::skipLine(std::string_view line, bool has_newline, LexState& state, bool plain) const
+{
+    if (plain && skipPlainLine(line, has_newline, state)) {
+        return;
+    }
+
+    scanLine(line, has_newline, state, [](TokenKind, size_t, size_t, bool) {});
+}
+
+inline void CLexer::emit(std::vector<Token>& tokens, TokenKind kind, size_t start, size_t end,
+    bool continues, bool merge)
+{
+    if (continues && merge && !tokens.empty()) {
+        tokens.back().length = static_cast<uint32_t>(end - tokens.back().offset);
+        return;
+    }
+    if (end > start || !continues) {
+        tokens.push_back(Token{ kind, static_cast<uint32_t>(start), static_cast<uint32_t>(end - start) });
+    }
+}
+
+inline void CLexer::collectProtectedRegions(const std::vector<Token>& tokens, size_t& cursor,
+    size_t line_start, size_t line_end, unsigned kinds,
+    std::vector<ProtectedRegion>& regions)
+{
+    regions.clear();
+
+    // Saltar tokens que terminan antes de la linea
+    while (cursor < tokens.size() && tokens[cursor].end() <= line_start) {
+        ++cursor;
+    }
+
+    for (size_t i = cursor; i < tokens.size() && tokens[i].offset < line_end; ++i) {
+        const Token& token = tokens[i];
+        if ((tokenKindBit(token.kind) & kinds) == 0) continue;
+
+        size_t start = std::max<size_t>(token.offset, line_start);
+        size_t end = std::min(token.end(), line_end);
+        if (end > start) {
+            regions.emplace_back(start - line_start, end - start);
+        }
+    }
+}
+
+inline bool CLexer::findIncludeDirective(std::string_view line, const std::vector<Token>& tokens,
+    IncludeDirective& directive)
+{
+    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+        const Token& token = tokens[i];
+        if (token.kind != TokenKind::Preprocessor ||
+            line.substr(token.offset, token.length) != "#include") {
+            continue;
+        }
+
+        const Token& header = tokens[i + 1];
+        if (header.kind == TokenKind::HeaderName || header.kind == TokenKind::StringLiteral) {
+            directive = IncludeDirective{ token.offset, header.end(),
+                line.substr(header.offset, header.length) };
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline bool CLexer::hasIncludeDirective(std::string_view source) const {
+    return findFirstIncludeLine(source) != std::string_view::npos;
+}
+
+inline size_t CLexer::findFirstIncludeLine(std::string_view source) const {
+    if (source.find("#include") == std::string_view::npos) {
+        return std::string_view::npos;
+    }
+
+    LexState state;
+    std::vector<Token> tokens;
+    IncludeDirective directive;
+    size_t line_start = 0;
+
+    while (line_start < source.size()) {
+        size_t line_end = source.find('\n', line_start);
+        bool has_newline = line_end != std::string_view::npos;
+        if (!has_newline) line_end = source.size();
+
+        std::string_view line = source.substr(line_start, line_end - line_start);
+        tokens.clear();
+        tokenizeLine(line, has_newline, state, tokens);
+        if (findIncludeDirective(line, tokens, directive)) {
+            return line_start;
+        }
+
+        line_start = line_end + 1;
+    }
+
+    return std::string_view::npos;
+}
+
+inline bool CLexer::isKeyword(std::string_view word) {
+    // Palabras reservadas de C (C99/C11), ordenadas para busqueda binaria
+    static constexpr std::array<std::string_view, 44> keywords{
+        "_Alignas", "_Alignof", "_Atomic", "_Bool", "_Complex", "_Generic",
+        "_Imaginary", "_Noreturn", "_Static_assert", "_Thread_local",
+        "auto", "break", "case", "char", "const", "continue", "default", "do",
+        "double", "else", "enum", "extern", "float", "for", "goto", "if",
+        "inline", "int", "long", "register", "restrict", "return", "short",
+        "signed", "sizeof", "static", "struct", "switch", "typedef", "union",
+        "unsigned", "void", "volatile", "while"
+    };
+
+    return std::binary_search(keywords.begin(), keywords.end(), word);
+}
+
+inline bool CLexer::isSpliceAt(std::string_view line, size_t pos, bool has_newline) {
+    // '\' seguido del fin de linea (opcionalmente "\r\n") une dos lineas fisicas
+    if (!has_newline || line[pos] != '\\') return false;
+    return pos + 1 == line.size() || (pos + 2 == line.size() && line[pos + 1] == '\r');
+}
+
+inline bool CLexer::endsWithSplice(std::string_view line, size_t from, bool has_newline) {
+    const size_t n = line.size();
+    return (n >= from + 1 && isSpliceAt(line, n - 1, has_newline)) ||
+        (n >= from + 2 && isSpliceAt(line, n - 2, has_newline));
+}
+
+// 'pos' es la posicion siguiente a la comilla de apertura
+inline size_t CLexer::scanQuoted(std::string_view line, size_t pos, char quote, bool has_newline, bool& open) {
+    const size_t n = line.size();
+    open = false;
+
+    while (pos < n) {
+        char c = line[pos];
+        if (c == quote) return pos + 1;
+        if (c == '\\') {
+            if (isSpliceAt(line, pos, has_newline)) {
+                open = true;
+                return n;
+            }
+            pos += 2;
+            continue;
+        }
+        ++pos;
+    }
+
+    // Literal sin cerrar: termina con la linea
+    return n;
+}
+
+inline size_t CLexer::scanNumber(std::string_view line, size_t pos) {
+    // pp-number: digitos, letras, '_', '.', y exponentes con signo (e+, E-, p+, P-)
+    const size_t n = line.size();
+    ++pos;
+
+    while (pos < n) {
+        unsigned char c = static_cast<unsigned char>(line[pos]);
+        if ((c == '+' || c == '-') &&
+            (line[pos - 1] == 'e' || line[pos - 1] == 'E' || line[pos - 1] == 'p' || line[pos - 1] == 'P')) {
+            ++pos;
+        }
+        else if (isIdentifierChar(c) || c == '.') {
+            ++pos;
+        }
+        else {
+            break;
+        }
+    }
+
+    return pos;
+}
+
+inline size_t CLexer::scanIdentifier(std::string_view line, size_t pos) {
+    while (pos < line.size() && isIdentifierChar(static_cast<unsigned char>(line[pos]))) {
+        ++pos;
+    }
+    return pos;
+}
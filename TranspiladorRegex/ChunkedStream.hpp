@@ -0,0 +1,175 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "ByteClassScanner.hpp"
+#include "KeywordPrefilter.hpp"
+
+// Entrada que se recorre por tramos de tamano fijo y puede recorrerse varias
+// veces (cada etapa del modo por tramos hace un analisis previo). Si el archivo
+// no admite fseek (una tuberia), se copia primero a un archivo temporal.
+class ChunkedInput {
+private:
+    std::FILE* file = nullptr;
+    bool owned = false;
+    size_t chunk_size;
+
+    std::string buffer;
+    ByteClassBitmaps bitmaps;
+
+public:
+    ChunkedInput(std::FILE* input, size_t chunk_size, bool take_ownership = false);
+    ~ChunkedInput();
+
+    ChunkedInput(const ChunkedInput&) = delete;
+    ChunkedInput& operator=(const ChunkedInput&) = delete;
+
+    // Recorre todo el archivo desde el principio: handler(line, has_newline, triggers)
+    // con la misma semantica que KeywordPrefilter::forEachLine. Una linea mas
+    // larga que el tramo hace crecer el buffer
+    template <typename LineHandler>
+    void forEachLine(LineHandler&& handler);
+
+private:
+    void spoolToTemporary();
+};
+
+// Salida acumulada en un buffer que se escribe al archivo al superar un umbral
+class ChunkedOutput {
+private:
+    std::FILE* file;
+    size_t flush_threshold;
+    std::string buffer;
+
+public:
+    ChunkedOutput(std::FILE* output, size_t flush_threshold);
+
+    // Texto pendiente; las etapas escriben directamente aqui
+    std::string& text() { return buffer; }
+
+    void flushIfFull();
+
+    void flush();
+};
+
+// Abre un archivo temporal que se borra al cerrarlo
+inline std::FILE* openTemporaryFile()
+{
+    std::FILE* file = std::tmpfile();
+    if (file == nullptr) {
+        throw std::runtime_error("No se pudo crear un archivo temporal");
+    }
+    return file;
+}
+
+
+inline ChunkedInput::ChunkedInput(std::FILE* input, size_t chunk_size, bool take_ownership)
+    : file(input), owned(take_ownership), chunk_size(chunk_size == 0 ? 1 : chunk_size)
+{
+    if (std::fseek(file, 0, SEEK_SET) != 0) {
+        spoolToTemporary();
+    }
+}
+
+inline ChunkedInput::~ChunkedInput()
+{
+    if (owned) std::fclose(file);
+}
+
+inline void ChunkedInput::spoolToTemporary()
+{
+    std::FILE* spool = openTemporaryFile();
+
+    buffer.resize(chunk_size);
+    size_t count;
+    while ((count = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+        if (std::fwrite(buffer.data(), 1, count, spool) != count) {
+            std::fclose(spool);
+            throw std::runtime_error("No se pudo escribir el archivo temporal");
+        }
+    }
+
+    if (std::ferror(file)) {
+        std::fclose(spool);
+        throw std::runtime_error("Error al leer la entrada");
+    }
+
+    if (owned) std::fclose(file);
+    file = spool;
+    owned = true;
+}
+
+template <typename LineHandler>
+void ChunkedInput::forEachLine(LineHandler&& handler)
+{
+    if (std::fseek(file, 0, SEEK_SET) != 0) {
+        throw std::runtime_error("No se pudo volver al inicio de la entrada");
+    }
+
+    const KeywordPrefilter& prefilter = KeywordPrefilter::shared();
+
+    // buffer[0, carried) es el final incompleto del tramo anterior
+    size_t carried = 0;
+    size_t capacity = chunk_size;
+
+    for (;;) {
+        buffer.resize(capacity);
+        size_t count = std::fread(buffer.data() + carried, 1, capacity - carried, file);
+        if (count == 0 && std::ferror(file)) {
+            throw std::runtime_error("Error al leer la entrada");
+        }
+
+        size_t filled = carried + count;
+        bool at_end = count == 0;
+
+        if (at_end) {
+            // Ultima linea sin '\n'
+            if (filled > 0) {
+                prefilter.forEachLine(std::string_view(buffer.data(), filled), bitmaps, handler);
+            }
+            return;
+        }
+
+        size_t last_newline = std::string_view(buffer.data(), filled).rfind('\n');
+        if (last_newline == std::string_view::npos) {
+            // Ninguna linea completa en el tramo: se amplia
+            carried = filled;
+            if (carried == capacity) capacity *= 2;
+            continue;
+        }
+
+        prefilter.forEachLine(std::string_view(buffer.data(), last_newline + 1), bitmaps, handler);
+
+        carried = filled - (last_newline + 1);
+        std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(last_newline + 1),
+            buffer.begin() + static_cast<std::ptrdiff_t>(filled), buffer.begin());
+        capacity = std::max(chunk_size, carried * 2);
+    }
+}
+
+inline ChunkedOutput::ChunkedOutput(std::FILE* output, size_t flush_threshold)
+    : file(output), flush_threshold(flush_threshold)
+{
+    buffer.reserve(flush_threshold + flush_threshold / 8);
+}
+
+inline void ChunkedOutput::flushIfFull()
+{
+    if (buffer.size() >= flush_threshold) {
+        flush();
+    }
+}
+
+inline void ChunkedOutput::flush()
+{
+    if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        throw std::runtime_error("No se pudo escribir la salida");
+    }
+    buffer.clear();
+
+    if (std::fflush(file) != 0) {
+        throw std::runtime_error("No se pudo escribir la salida");
+    }
+}
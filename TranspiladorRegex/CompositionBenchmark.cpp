@@ -0,0 +1,135 @@
+// Composicion estatica (StaticPipeline) frente a dinamica (DynamicPipeline) de las
+// etapas, con TranspilerPipeline en modo secuencial como referencia. Se miden las
+// cinco etapas y el subconjunto define,null,printf, donde la version estatica lleva
+// EmptyPass en los lugares de arreglos y cadenas. Las entradas son las muestras de
+// AfinamientoLLM (muchos archivos chicos: pesa el costo por llamada) y un archivo
+// sintetico grande (pesa el recorrido). Termina con error si alguna composicion da
+// una salida distinta de la referencia.
+//
+// Uso: CompositionBenchmark [repeticiones] [MB del archivo sintetico]
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "BenchmarkTools.hpp"
+#include "PassComposition.hpp"
+#include "SyntheticSource.hpp"
+
+#if !defined(CORPUS_DIR)
+#define CORPUS_DIR "AfinamientoLLM"
+#endif
+
+namespace {
+
+    using Clock = BenchmarkTools::Clock;
+
+    struct Input {
+        const char* name;
+        std::vector<std::string> files;
+        size_t bytes = 0;
+    };
+
+    struct Composition {
+        const char* name;
+        std::function<std::string(const std::string&)> transpile;
+    };
+
+    // Mediana y mejor tiempo de 'repetitions' pasadas por todos los archivos de 'input'
+    std::pair<double, double> measure(const Composition& composition, const Input& input, size_t repetitions,
+        std::vector<std::string>& outputs)
+    {
+        std::vector<double> times;
+        outputs.resize(input.files.size());
+
+        for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+            auto start = Clock::now();
+            for (size_t i = 0; i < input.files.size(); ++i) {
+                outputs[i] = composition.transpile(input.files[i]);
+            }
+            times.push_back(BenchmarkTools::seconds(start, Clock::now()));
+        }
+
+        return { BenchmarkTools::median(times), BenchmarkTools::best(times) };
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t repetitions = argc > 1 ? std::stoul(argv[1]) : 10;
+    if (repetitions == 0) repetitions = 1;
+
+    size_t synthetic_size = (argc > 2 ? std::stoul(argv[2]) : 8) << 20;
+    if (synthetic_size == 0) synthetic_size = size_t{ 8 } << 20;
+
+    std::vector<Input> inputs{ { "corpus", {}, 0 }, { "sintetico", {}, 0 } };
+    for (const char* path : { CORPUS_DIR "/train.jsonl", CORPUS_DIR "/test.jsonl" }) {
+        if (!BenchmarkTools::loadSamples(path, inputs[0].files)) std::cerr << "No se pudo abrir el archivo: " << path << "\n";
+    }
+    inputs[1].files.push_back(SyntheticSource().generate(synthetic_size));
+    if (inputs[0].files.empty()) inputs.erase(inputs.begin());
+
+    for (auto& input : inputs) {
+        for (const auto& file : input.files) input.bytes += file.size();
+    }
+
+    const TranspilerRules& rules = TranspilerRules::shared();
+    TranspilerPipeline pipeline(rules, nullptr);
+
+    constexpr unsigned subset = pass_define | pass_null | pass_printf;
+
+    auto all_static = standardStaticPipeline(rules);
+    auto all_dynamic = standardDynamicPipeline(all_passes, rules);
+
+    StaticPipeline<PipelineStage<0, DefineTranspiler>, PipelineStage<1, NullTranspiler>, EmptyPass, EmptyPass,
+        PipelineStage<4, PrintfTranspiler>> subset_static(
+            PipelineStage<0, DefineTranspiler>(rules.defineTranspiler),
+            PipelineStage<1, NullTranspiler>(rules.nullTranspiler), EmptyPass{}, EmptyPass{},
+            PipelineStage<4, PrintfTranspiler>(rules.printfTranspiler));
+    auto subset_dynamic = standardDynamicPipeline(subset, rules);
+
+    // Cada grupo empieza por la referencia
+    std::vector<std::vector<Composition>> groups{
+        {
+            { "5 etapas: TranspilerPipeline", [&](const std::string& in) { return pipeline.transpile(in, PipelineMode::Sequential); } },
+            { "5 etapas: estatica", [&](const std::string& in) { return all_static.transpile(in); } },
+            { "5 etapas: dinamica", [&](const std::string& in) { return all_dynamic.transpile(in); } },
+        },
+        {
+            { "define,null,printf: transpilePasses", [&](const std::string& in) { return pipeline.transpilePasses(in, subset); } },
+            { "define,null,printf: estatica", [&](const std::string& in) { return subset_static.transpile(in); } },
+            { "define,null,printf: dinamica", [&](const std::string& in) { return subset_dynamic.transpile(in); } },
+        },
+    };
+
+    std::cout << repetitions << " repeticiones; etapas en la composicion estatica: " << all_static.size << " y "
+        << subset_static.size << "\n";
+
+    size_t mismatches = 0;
+    for (const auto& input : inputs) {
+        double megabytes = static_cast<double>(input.bytes) / (1024.0 * 1024.0);
+        std::cout << "\n" << input.name << ": " << input.files.size() << " archivos, " << std::fixed
+            << std::setprecision(2) << megabytes << " MB\n";
+
+        for (const auto& group : groups) {
+            std::vector<std::string> expected, outputs;
+            double reference = 0;
+
+            for (size_t i = 0; i < group.size(); ++i) {
+                auto [typical, best] = measure(group[i], input, repetitions, i == 0 ? expected : outputs);
+                if (i == 0) reference = typical;
+
+                bool same = i == 0 || outputs == expected;
+                if (!same) ++mismatches;
+
+                std::cout << "  " << std::left << std::setw(38) << group[i].name << std::right << std::fixed
+                    << std::setprecision(2) << std::setw(8) << megabytes / typical << " MB/s (mejor "
+                    << megabytes / best << "), " << std::setprecision(3) << typical / reference << "x"
+                    << (same ? "" : "  SALIDA DISTINTA") << "\n";
+            }
+        }
+    }
+
+    std::cout << "\nComposiciones con salida distinta: " << mismatches << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+// Rendimiento sobre codigo C real: toma el campo "source_code" de cada muestra de
+// los conjuntos JSONL de AfinamientoLLM (train.jsonl y test.jsonl) y transpila todo
+// el corpus N veces con el pipeline fusionado y con el secuencial. Informa MB/s y
+// muestras/s (mediana y mejor repeticion), la parte del tiempo de cada etapa (medida
+// en el modo secuencial, donde las etapas corren por separado) y las asignaciones de
+// memoria por muestra. Termina con error si algun modo produce una salida distinta.
+//
+// Uso: CorpusBenchmark [repeticiones] [archivo.jsonl ...]
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "AllocationCounter.hpp"
+#include "BenchmarkTools.hpp"
+#include "TranspilerPipeline.hpp"
+
+#if !defined(CORPUS_DIR)
+#define CORPUS_DIR "AfinamientoLLM"
+#endif
+
+// Cuenta las asignaciones del hilo principal; se mide la diferencia alrededor de
+// cada repeticion
+TRANSPILER_COUNT_ALLOCATIONS();
+
+namespace {
+
+    using Clock = BenchmarkTools::Clock;
+
+    constexpr const char* stage_names[TranspilerPipeline::stage_count] = {
+        "define", "NULL", "arreglos", "cadenas", "printf"
+    };
+
+    struct Repetition {
+        double seconds = 0;
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Allocations {
+        uint64_t count = AllocationCounter::current().count;
+        uint64_t bytes = AllocationCounter::current().bytes;
+    };
+
+    void report(const char* name, const std::vector<Repetition>& runs, size_t samples, uint64_t corpus_bytes)
+    {
+        std::vector<double> times;
+        for (const auto& run : runs) times.push_back(run.seconds);
+
+        double typical = BenchmarkTools::median(times);
+        double best = BenchmarkTools::best(times);
+        double megabytes = static_cast<double>(corpus_bytes) / (1024.0 * 1024.0);
+        const Repetition& last = runs.back();
+
+        std::cout << std::fixed << std::setprecision(2)
+            << name << ": mediana " << megabytes / typical << " MB/s (mejor " << megabytes / best << "), "
+            << std::setprecision(0) << static_cast<double>(samples) / typical << " muestras/s; "
+            << std::setprecision(1) << static_cast<double>(last.allocations) / static_cast<double>(samples)
+            << " asignaciones y " << static_cast<double>(last.bytes) / static_cast<double>(samples) / 1024.0
+            << " KB por muestra\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t repetitions = argc > 1 ? std::stoul(argv[1]) : 20;
+    if (repetitions == 0) repetitions = 1;
+
+    AllocationCounter::enable();
+
+    std::vector<std::string> files;
+    for (int i = 2; i < argc; ++i) files.push_back(argv[i]);
+    if (files.empty()) {
+        files.push_back(CORPUS_DIR "/train.jsonl");
+        files.push_back(CORPUS_DIR "/test.jsonl");
+    }
+
+    std::vector<std::string> samples;
+    for (const auto& file : files) {
+        if (!BenchmarkTools::loadSamples(file, samples)) {
+            std::cerr << "No se pudo abrir el archivo: " << file << "\n";
+            return 1;
+        }
+    }
+    if (samples.empty()) {
+        std::cerr << "El corpus no tiene muestras\n";
+        return 1;
+    }
+
+    uint64_t corpus_bytes = 0;
+    for (const auto& sample : samples) corpus_bytes += sample.size();
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "Corpus: " << samples.size() << " muestras, " << static_cast<double>(corpus_bytes) / (1024.0 * 1024.0)
+        << " MB; " << repetitions << " repeticiones\n";
+
+    const TranspilerRules& rules = TranspilerRules::shared();
+    TranspilerPipeline pipeline;
+
+    std::vector<std::string> fused_outputs(samples.size());
+    std::vector<Repetition> fused_runs;
+    std::vector<Repetition> sequential_runs;
+    std::array<double, TranspilerPipeline::stage_count> stage_seconds{};
+    size_t mismatches = 0;
+
+    for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+        // Pipeline fusionado, como lo usa el programa
+        Allocations before;
+        auto start = Clock::now();
+        for (size_t i = 0; i < samples.size(); ++i) {
+            fused_outputs[i] = pipeline.transpile(samples[i], PipelineMode::Fused);
+        }
+        auto end = Clock::now();
+        Allocations after;
+        fused_runs.push_back(Repetition{ BenchmarkTools::seconds(start, end), after.count - before.count, after.bytes - before.bytes });
+
+        // Secuencial, midiendo cada etapa por separado
+        before = Allocations{};
+        double total = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            std::array<Clock::time_point, TranspilerPipeline::stage_count + 1> marks;
+
+            marks[0] = Clock::now();
+            std::string result = rules.defineTranspiler.transpileFile(samples[i]);
+            marks[1] = Clock::now();
+            result = rules.nullTranspiler.transpileFile(result);
+            marks[2] = Clock::now();
+            result = rules.arrayTranspiler.transpileFile(result);
+            marks[3] = Clock::now();
+            result = rules.stringTranspiler.transpileFile(result);
+            marks[4] = Clock::now();
+            result = rules.printfTranspiler.transpileFile(result);
+            marks[5] = Clock::now();
+
+            for (size_t stage = 0; stage < stage_seconds.size(); ++stage) {
+                stage_seconds[stage] += BenchmarkTools::seconds(marks[stage], marks[stage + 1]);
+            }
+            total += BenchmarkTools::seconds(marks[0], marks.back());
+
+            if (repetition == 0 && result != fused_outputs[i]) ++mismatches;
+        }
+        after = Allocations{};
+        sequential_runs.push_back(Repetition{ total, after.count - before.count, after.bytes - before.bytes });
+    }
+
+    report("Fusionado", fused_runs, samples.size(), corpus_bytes);
+    report("Secuencial", sequential_runs, samples.size(), corpus_bytes);
+
+    double stage_total = 0;
+    for (double value : stage_seconds) stage_total += value;
+
+    std::cout << "Tiempo por etapa (secuencial):";
+    for (size_t stage = 0; stage < stage_seconds.size(); ++stage) {
+        std::cout << (stage == 0 ? " " : ", ") << stage_names[stage] << " " << std::setprecision(1)
+            << stage_seconds[stage] / stage_total * 100.0 << "%";
+    }
+    std::cout << "\n";
+
+    LineMemo::shared().printSummary(std::cout);
+    std::cout << "Muestras con salida distinta entre modos: " << mismatches << "\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -1,100 +1,183 @@
 #pragma once
-#include <regex>
 #include <sstream>
-
+#include <climits>
+#include "CLexer.hpp"
+#include "KeywordPrefilter.hpp"
+#include "LineMemo.hpp"
+#include "PatternMatchers.hpp"
+#include "SourceLines.hpp"
+#include "TranspilerStats.hpp"
+
+// Las reglas no cambian durante un recorrido: el estado vive en un Context, y un
+// mismo DefineTranspiler puede usarse desde varios hilos a la vez
 class DefineTranspiler {
-private:
-    // Expresion regular para capturar #define con diferentes patrones
-    std::regex define_pattern{
-        R"(#define\s+([A-Za-z_][A-Za-z0-9_]*)\s+(.+))"
-    };
+public:
+    // Estado de un recorrido
+    struct Context {
+        // Estado del lexer entre lineas del archivo en curso
+        LexState lex_state;
+        std::vector<Token> line_tokens;
 
-    // Expresion regular para #define sin valor (solo nombre)
-    std::regex define_no_value_pattern{
-        R"(#define\s+([A-Za-z_][A-Za-z0-9_]*)\s*$)"
-    };
+        // Memoria de lineas ya convertidas (opcional, puede compartirse entre hilos)
+        LineMemo* memo = nullptr;
 
-    // Expresion regular para #define con parametros (macros funcion)
-    std::regex define_function_pattern{
-        R"(#define\s+([A-Za-z_][A-Za-z0-9_]*)\s*\(([^)]*)\)\s+(.+))"
+        // Verdadero si ningun estado pasa de la ultima linea procesada a la siguiente
+        bool idle() const { return lex_state == LexState{}; }
     };
 
+private:
+    // Lexer compartido: solo se examinan lineas que empiezan con la directiva #define
+    CLexer lexer;
+
 public:
-    std::string transpileFile(const std::string& content);
+    std::string transpileFile(std::string_view content) const;
+
+    // Procesamiento linea a linea para el pipeline fusionado: cada linea
+    // convertida se agrega a 'out' terminada en '\n'
+    void beginStream(Context& context) const;
+
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const;
+
+    // 'triggers' son los bits de KeywordPrefilter ya calculados para la linea
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
+
+    void endStream(Context& context, std::string& out) const;
+
+    // Tipo de la constante que se declara para el valor de un #define ("3.14" ->
+    // "double"). Publico para medirlo en transpiler_bench
+    std::string deduceType(const std::string& value) const;
 
 private:
-    std::string transpileDefineStatements(const std::string& content);
+    std::string transpileDefineStatements(std::string_view content) const;
 
-    std::string processDefineLine(const std::string& line);
+    std::string processDefineLine(const std::string& line) const;
 
-    std::string convertDefineToConstexpr(const std::string& name, const std::string& value);
+    bool isDefineDirective(std::string_view line, const Token& token) const;
 
-    std::string convertFunctionMacro(const std::string& name, const std::string& params, const std::string& body);
+    std::string convertDefineToConstexpr(const std::string& name, const std::string& value) const;
 
-    std::string deduceType(const std::string& value);
+    std::string convertFunctionMacro(const std::string& name, const std::string& params, const std::string& body) const;
 
-    std::string deduceReturnType(const std::string& body);
+    std::string deduceReturnType(const std::string& body) const;
 
-    std::string convertParameters(const std::string& params);
+    std::string convertParameters(const std::string& params) const;
 
-    std::string trim(const std::string& str);
+    std::string trim(const std::string& str) const;
 };
 
 
-std::string DefineTranspiler::transpileFile(const std::string& content)
+inline std::string DefineTranspiler::transpileFile(std::string_view content) const
 {
-    std::string result = content;
+    return transpileDefineStatements(content);
+}
 
-    result = transpileDefineStatements(result);
+inline std::string DefineTranspiler::transpileDefineStatements(std::string_view content) const
+{
+    std::string processed_content;
+    processed_content.reserve(content.size() + content.size() / 16);
 
-    return result;
+    Context context;
+    beginStream(context);
+    KeywordPrefilter::shared().forEachLine(content, [&](std::string_view line, bool has_newline, unsigned triggers) {
+        transpileLine(context, line, has_newline, processed_content, triggers);
+    });
+    endStream(context, processed_content);
+
+    return processed_content;
 }
 
-std::string DefineTranspiler::transpileDefineStatements(const std::string& content)
+inline void DefineTranspiler::beginStream(Context& context) const
 {
-    std::string result = content;
-    std::smatch match;
+    context.lex_state = LexState{};
+}
 
-    std::istringstream iss(content);
-    std::string line;
-    std::string processed_content;
+inline void DefineTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const
+{
+    transpileLine(context, line, has_newline, out, KeywordPrefilter::shared().scan(line));
+}
 
-    while (std::getline(iss, line)) {
-        std::string processed_line = processDefineLine(line);
-        processed_content += processed_line + "\n";
+inline void DefineTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+    unsigned triggers) const
+{
+    auto& line_tokens = context.line_tokens;
+
+    // Sin "#define" en la linea solo hace falta mantener el estado del lexer
+    if ((triggers & trigger_define) == 0) {
+        lexer.skipLine(line, has_newline, context.lex_state, (triggers & trigger_lexer) == 0);
+        out.append(line);
+        out += '\n';
+        return;
     }
 
-    return processed_content;
+    // Desde el estado inicial del lexer el resultado depende solo de la linea
+    bool memoizable = context.memo != nullptr && context.lex_state == LexState{};
+    if (memoizable && context.memo->lookup(MemoPass::Define, line, has_newline, out, context.lex_state)) {
+        return;
+    }
+    size_t output_start = out.size();
+    LineMemo::RuleMark rules;
+
+    line_tokens.clear();
+    lexer.tokenizeLine(line, has_newline, context.lex_state, line_tokens);
+
+    // Las lineas dentro de comentarios o que no empiezan con #define se copian tal cual
+    if (!line_tokens.empty() && isDefineDirective(line, line_tokens.front())) {
+        out += processDefineLine(std::string(line));
+    }
+    else {
+        out.append(line);
+    }
+    out += '\n';
+
+    if (memoizable) {
+        context.memo->store(MemoPass::Define, line, has_newline, std::string_view(out).substr(output_start),
+            context.lex_state, rules);
+    }
+}
+
+inline void DefineTranspiler::endStream(Context&, std::string&) const
+{
+}
+
+inline bool DefineTranspiler::isDefineDirective(std::string_view line, const Token& token) const
+{
+    return token.kind == TokenKind::Preprocessor &&
+        token.offset == 0 &&
+        line.substr(token.offset, token.length) == "#define";
 }
 
-std::string DefineTranspiler::processDefineLine(const std::string& line)
+inline std::string DefineTranspiler::processDefineLine(const std::string& line) const
 {
-    std::smatch match;
+    PatternMatch match;
 
-    if (std::regex_match(line, match, define_function_pattern)) {
-        std::string name = match[1].str();
-        std::string params = match[2].str();
-        std::string body = match[3].str();
+    if (DefineFunctionPattern::matchFull(line, match)) {
+        std::string name = match.str(1);
+        std::string params = match.str(2);
+        std::string body = match.str(3);
 
+        TranspilerStats::countRule(StatsRule::DefineFunction);
         return convertFunctionMacro(name, params, body);
     }
 
-    if (std::regex_match(line, match, define_no_value_pattern)) {
-        std::string name = match[1].str();
+    if (DefineFlagPattern::matchFull(line, match)) {
+        std::string name = match.str(1);
+        TranspilerStats::countRule(StatsRule::DefineFlag);
         return "constexpr bool " + name + " = true; // Convertido de #define";
     }
 
-    if (std::regex_match(line, match, define_pattern)) {
-        std::string name = match[1].str();
-        std::string value = match[2].str();
+    if (DefineValuePattern::matchFull(line, match)) {
+        std::string name = match.str(1);
+        std::string value = match.str(2);
 
+        TranspilerStats::countRule(StatsRule::DefineValue);
         return convertDefineToConstexpr(name, value);
     }
 
     return line;
 }
 
-std::string DefineTranspiler::convertDefineToConstexpr(const std::string& name, const std::string& value)
+inline std::string DefineTranspiler::convertDefineToConstexpr(const std::string& name, const std::string& value) const
 {
     std::string trimmed_value = trim(value);
 
@@ -106,7 +189,7 @@ std::string DefineTranspiler::convertDefineToConstexpr(const std::string& name,
     return result;
 }
 
-std::string DefineTranspiler::convertFunctionMacro(const std::string& name, const std::string& params, const std::string& body)
+inline std::string DefineTranspiler::convertFunctionMacro(const std::string& name, const std::string& params, const std::string& body) const
 {
     std::string param_list = convertParameters(params);
     std::string return_type = deduceReturnType(body);
@@ -118,7 +201,7 @@ std::string DefineTranspiler::convertFunctionMacro(const std::string& name, cons
     return result;
 }
 
-std::string DefineTranspiler::deduceType(const std::string& value)
+inline std::string DefineTranspiler::deduceType(const std::string& value) const
 {
     std::string trimmed = trim(value);
 
@@ -175,7 +258,7 @@ std::string DefineTranspiler::deduceType(const std::string& value)
     return "auto";
 }
 
-std::string DefineTranspiler::deduceReturnType(const std::string& body)
+inline std::string DefineTranspiler::deduceReturnType(const std::string& body) const
 {
     std::string trimmed = trim(body);
 
@@ -189,7 +272,7 @@ std::string DefineTranspiler::deduceReturnType(const std::string& body)
     return deduceType(trimmed);
 }
 
-std::string DefineTranspiler::convertParameters(const std::string& params)
+inline std::string DefineTranspiler::convertParameters(const std::string& params) const
 {
     if (params.empty()) {
         return "";
@@ -215,7 +298,7 @@ std::string DefineTranspiler::convertParameters(const std::string& params)
     return result;
 }
 
-std::string DefineTranspiler::trim(const std::string& str)
+inline std::string DefineTranspiler::trim(const std::string& str) const
 {
     size_t start = str.find_first_not_of(" \t\r\n");
     if (start == std::string::npos) return "";
@@ -0,0 +1,141 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Reemplazo de un tramo del texto original: [offset, offset + length) -> replacement
+struct TextEdit {
+    size_t offset;
+    size_t length;
+    std::string replacement;
+
+    size_t end() const { return offset + length; }
+};
+
+// Lista de reemplazos sobre un texto que no se modifica mientras se buscan
+// coincidencias. Los reemplazos se mantienen ordenados y sin solapamientos: uno
+// que se solape con otro ya registrado por otra regla de la misma etapa se
+// rechaza y se cuenta como conflicto (ver conflicts). El resultado se construye
+// de una sola vez con apply().
+//
+// Alcance: cada lista cubre una linea (o una llamada a printf) de una sola etapa.
+// No hay un aplicador comun a todas las etapas ni se detectan conflictos entre
+// ellas: cada etapa trabaja sobre la salida de la anterior, y que reescriba texto
+// producido por otra es parte del encadenamiento, no un error
+class EditList {
+private:
+    std::vector<TextEdit> edits;
+
+public:
+    // Devuelve false (y no registra nada) si el tramo se solapa con otro reemplazo
+    bool replace(size_t offset, size_t length, std::string replacement);
+
+    // Reemplazos rechazados en el hilo actual desde que empezo, siempre entre reglas
+    // de una misma etapa. --stats mide la diferencia alrededor de cada etapa (ver
+    // TranspilerPipeline::measureStageLine)
+    static uint64_t& conflicts() {
+        thread_local uint64_t count = 0;
+        return count;
+    }
+
+    // Verdadero si algun reemplazo se solapa con [offset, offset + length)
+    bool overlaps(size_t offset, size_t length) const;
+
+    // Verdadero si algun reemplazo empieza en [from, to)
+    bool hasEditBetween(size_t from, size_t to) const;
+
+    // Agrega a 'out' el texto resultante de aplicar a source[begin, end) los
+    // reemplazos que empiezan en ese tramo
+    void applyRange(std::string_view source, size_t begin, size_t end, std::string& out) const;
+
+    void apply(std::string_view source, std::string& out) const;
+
+    std::string apply(std::string_view source) const;
+
+    bool empty() const { return edits.empty(); }
+    size_t size() const { return edits.size(); }
+
+    void clear();
+
+private:
+    std::vector<TextEdit>::const_iterator firstStartingAt(size_t offset) const;
+};
+
+
+inline std::vector<TextEdit>::const_iterator EditList::firstStartingAt(size_t offset) const
+{
+    return std::lower_bound(edits.begin(), edits.end(), offset,
+        [](const TextEdit& edit, size_t value) { return edit.offset < value; });
+}
+
+inline bool EditList::overlaps(size_t offset, size_t length) const
+{
+    auto next = firstStartingAt(offset);
+
+    // Dos reemplazos que empiezan en la misma posicion tambien entran en conflicto
+    if (next != edits.end() && (next->offset == offset || next->offset < offset + length)) {
+        return true;
+    }
+
+    return next != edits.begin() && std::prev(next)->end() > offset;
+}
+
+inline bool EditList::replace(size_t offset, size_t length, std::string replacement)
+{
+    if (overlaps(offset, length)) {
+        ++conflicts();
+        return false;
+    }
+
+    edits.insert(firstStartingAt(offset), TextEdit{ offset, length, std::move(replacement) });
+
+    return true;
+}
+
+inline bool EditList::hasEditBetween(size_t from, size_t to) const
+{
+    auto it = firstStartingAt(from);
+    return it != edits.end() && it->offset < to;
+}
+
+inline void EditList::applyRange(std::string_view source, size_t begin, size_t end, std::string& out) const
+{
+    size_t copied = begin;
+
+    for (auto it = firstStartingAt(begin); it != edits.end() && it->offset < end; ++it) {
+        out.append(source.substr(copied, it->offset - copied));
+        out += it->replacement;
+        copied = it->end();
+    }
+
+    if (copied < end) {
+        out.append(source.substr(copied, end - copied));
+    }
+}
+
+inline void EditList::apply(std::string_view source, std::string& out) const
+{
+    size_t result_size = source.size();
+    for (const auto& edit : edits) {
+        result_size += edit.replacement.size();
+        result_size -= edit.length;
+    }
+    out.reserve(out.size() + result_size);
+
+    applyRange(source, 0, source.size(), out);
+}
+
+inline std::string EditList::apply(std::string_view source) const
+{
+    std::string result;
+    apply(source, result);
+    return result;
+}
+
+inline void EditList::clear()
+{
+    edits.clear();
+}
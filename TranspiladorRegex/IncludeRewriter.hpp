@@ -0,0 +1,123 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CLexer.hpp"
+#include "KeywordPrefilter.hpp"
+
+// Reescribe las directivas #include de un archivo procesado linea a linea:
+// inserta una directiva nueva despues de la primera (o al inicio del archivo si
+// no hay ninguna) y reemplaza las directivas de un encabezado dado por un texto fijo.
+// La configuracion no cambia durante un recorrido; el estado vive en un Context.
+class IncludeRewriter {
+public:
+    // Estado de un recorrido
+    struct Context {
+        LexState lex_state;
+        std::vector<Token> line_tokens;
+
+        bool insert_pending = false;
+
+        std::string first_line;
+        std::string second_line;
+
+        // Sin insercion pendiente ni estado del lexer que pase a la linea siguiente
+        bool idle() const { return !insert_pending && lex_state == LexState{}; }
+    };
+
+private:
+    std::string include_line;      // directiva a insertar, p. ej. "#include <array>"
+    std::string replaced_header;   // encabezado a reemplazar, p. ej. "<stdio.h>"
+    std::string replacement;
+
+    CLexer lexer;
+
+public:
+    IncludeRewriter(std::string include, std::string header = "", std::string header_replacement = "")
+        : include_line(std::move(include)),
+          replaced_header(std::move(header)),
+          replacement(std::move(header_replacement)) {}
+
+    // Con 'prepend' la directiva se agrega como primera linea del archivo
+    template <typename LineHandler>
+    void begin(Context& context, bool insert_include, bool prepend, LineHandler&& emit) const;
+
+    // Entrega a 'emit' la linea (o las dos lineas, si se inserto la directiva) resultantes.
+    // 'triggers' son los bits de KeywordPrefilter de la linea; sin trigger_include
+    // la linea se entrega tal cual (la misma vista)
+    template <typename LineHandler>
+    void rewriteLine(Context& context, std::string_view line, bool has_newline, unsigned triggers,
+        LineHandler&& emit) const;
+};
+
+
+template <typename LineHandler>
+void IncludeRewriter::begin(Context& context, bool insert_include, bool prepend, LineHandler&& emit) const
+{
+    context.lex_state = LexState{};
+    context.insert_pending = insert_include && !prepend && !include_line.empty();
+
+    if (insert_include && prepend && !include_line.empty()) {
+        emit(std::string_view(include_line), true);
+    }
+}
+
+template <typename LineHandler>
+void IncludeRewriter::rewriteLine(Context& context, std::string_view line, bool has_newline, unsigned triggers,
+    LineHandler&& emit) const
+{
+    LexState& lex_state = context.lex_state;
+    std::vector<Token>& line_tokens = context.line_tokens;
+    bool& insert_pending = context.insert_pending;
+    std::string& first_line = context.first_line;
+    std::string& second_line = context.second_line;
+
+    // Sin insercion pendiente ni reemplazos no hace falta seguir analizando
+    if (!insert_pending && replaced_header.empty()) {
+        emit(line, has_newline);
+        return;
+    }
+
+    if ((triggers & trigger_include) == 0) {
+        lexer.skipLine(line, has_newline, lex_state, (triggers & trigger_lexer) == 0);
+        emit(line, has_newline);
+        return;
+    }
+
+    line_tokens.clear();
+    lexer.tokenizeLine(line, has_newline, lex_state, line_tokens);
+
+    IncludeDirective directive;
+    if (!CLexer::findIncludeDirective(line, line_tokens, directive)) {
+        emit(line, has_newline);
+        return;
+    }
+
+    bool replace = !replaced_header.empty() && directive.header == replaced_header;
+    if (!replace && !insert_pending) {
+        emit(line, has_newline);
+        return;
+    }
+
+    first_line.assign(line.substr(0, directive.start));
+    if (replace) {
+        first_line += replacement;
+    }
+    else {
+        first_line.append(line.substr(directive.start, directive.end - directive.start));
+    }
+
+    if (insert_pending) {
+        insert_pending = false;
+
+        second_line.assign(include_line);
+        second_line.append(line.substr(directive.end));
+
+        emit(std::string_view(first_line), true);
+        emit(std::string_view(second_line), has_newline);
+        return;
+    }
+
+    first_line.append(line.substr(directive.end));
+    emit(std::string_view(first_line), has_newline);
+}
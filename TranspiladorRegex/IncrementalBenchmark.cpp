@@ -0,0 +1,189 @@
+// Aplica una serie de cambios pequenos (del tamano de unas pulsaciones) a un
+// archivo con IncrementalTranspiler y compara cada salida con la de transpilar el
+// archivo completo. Informa la latencia de cada cambio frente a la del archivo
+// completo y cuantos cambios obligaron a repetir todo; termina con error si alguna
+// salida difiere. Sin archivo se genera uno repitiendo funciones de ejemplo.
+//
+// Uso: IncrementalBenchmark [cambios] [archivo.c]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "IncrementalTranspiler.hpp"
+#include "MappedFile.hpp"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    const char* sample_header = R"(#include <stdio.h>
+#include <string.h>
+
+#define PI 3.1416
+#define SQUARE(x) ((x) * (x))
+
+)";
+
+    const char* sample_function = R"(int funcion_N(int n) {
+    char* nombre_N = "mike";
+    char copia_N[32];
+    int valores_N[] = { 1, 2, 3, 4, 5 };
+    int* ptr_N = NULL;
+
+    strcpy(copia_N, nombre_N);
+    if (strcmp(nombre_N, "john") == 0) {
+        printf("iguales %s\n", nombre_N);
+    }
+
+    /* comentario de bloque
+       de varias lineas */
+    printf("hola %s, tienes %d soles y %f de radio\n",
+        nombre_N, valores_N[2], PI * SQUARE(n));
+
+    return n + 1;
+}
+
+)";
+
+    std::string generate(size_t target_size)
+    {
+        std::string content = sample_header;
+        for (size_t i = 0; content.size() < target_size; ++i) {
+            std::string function = sample_function;
+            for (size_t pos = function.find("_N"); pos != std::string::npos; pos = function.find("_N", pos)) {
+                function.replace(pos + 1, 1, std::to_string(i));
+            }
+            content += function;
+        }
+        return content;
+    }
+
+    // Generador lineal congruente: los mismos cambios en cada ejecucion
+    struct Random {
+        uint64_t state = 0x2545F4914F6CDD1Dull;
+
+        size_t next(size_t bound) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<size_t>((state >> 33) % bound);
+        }
+    };
+
+    // Cambios tipicos de un editor, incluidos algunos que cambian el estado global
+    TextEdit randomEdit(const std::string& source, Random& random)
+    {
+        static const std::vector<std::string> insertions{
+            "    n = n * 2;\n", "x", ";", "    printf(\"valor %d\\n\", n);\n", "    int* q = NULL;\n",
+            "    int tabla[4];\n", "/*", "*/", "    char* extra = \"nuevo\";\n", "#include <array>\n", "\"", "{", "}"
+        };
+
+        TextEdit edit{ 0, 0, {} };
+        size_t kind = random.next(100);
+
+        // Las inserciones de lineas van al inicio de una linea
+        size_t pos = random.next(source.size() + 1);
+        if (kind < 60) {
+            size_t line_start = source.rfind('\n', pos == 0 ? 0 : pos - 1);
+            edit.offset = line_start == std::string::npos || pos == 0 ? 0 : line_start + 1;
+
+            // Los cambios que rompen la estructura son menos frecuentes
+            size_t choice = random.next(kind < 55 ? 6 : insertions.size());
+            edit.replacement = insertions[choice];
+            if (edit.replacement.size() <= 2) edit.offset = pos;
+        }
+        else if (kind < 90) {
+            edit.offset = std::min(pos, source.size());
+            edit.length = std::min<size_t>(1 + random.next(3), source.size() - edit.offset);
+        }
+        else {
+            edit.offset = std::min(pos, source.size());
+            edit.length = std::min<size_t>(random.next(2), source.size() - edit.offset);
+            edit.replacement = insertions[random.next(insertions.size())];
+        }
+
+        return edit;
+    }
+
+    double percentile(std::vector<double> values, double fraction)
+    {
+        if (values.empty()) return 0;
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())))];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t edit_count = argc > 1 ? std::stoul(argv[1]) : 300;
+
+    std::string content;
+    if (argc > 2) {
+        MappedFile file;
+        if (!file.open(argv[2])) {
+            std::cerr << "No se pudo abrir el archivo: " << argv[2] << "\n";
+            return 1;
+        }
+        content.assign(file.view());
+    }
+    else {
+        content = generate(size_t{ 2 } << 20);
+    }
+
+    IncrementalTranspiler incremental;
+    TranspilerPipeline reference;
+
+    auto start = Clock::now();
+    incremental.reset(content);
+    double initial_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::vector<double> edit_ms;
+    std::vector<double> full_ms;
+    size_t full_reruns = 0;
+    size_t mismatches = 0;
+    size_t bytes_transpiled = 0;
+
+    Random random;
+    for (size_t i = 0; i < edit_count; ++i) {
+        TextEdit edit = randomEdit(incremental.source(), random);
+
+        start = Clock::now();
+        incremental.apply({ edit });
+        double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        const IncrementalUpdate& update = incremental.lastUpdate();
+        if (update.full_rerun) {
+            ++full_reruns;
+        }
+        else {
+            edit_ms.push_back(elapsed);
+            bytes_transpiled += update.bytes_transpiled;
+        }
+
+        start = Clock::now();
+        std::string expected = reference.transpile(incremental.source());
+        full_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+        if (expected != incremental.output()) {
+            if (mismatches == 0) {
+                std::cerr << "Salida distinta tras el cambio " << i << " en " << edit.offset << " (-"
+                    << edit.length << " +\"" << edit.replacement << "\")\n";
+            }
+            ++mismatches;
+            incremental.reset(incremental.source());
+        }
+    }
+
+    size_t incremental_edits = edit_ms.size();
+    std::cout << std::fixed << std::setprecision(3)
+        << "Archivo de " << content.size() / 1024 << " KB, " << incremental.mapping().size() << " tramos; "
+        << "transpilacion inicial " << initial_ms << " ms\n"
+        << "Cambios: " << edit_count << " (" << full_reruns << " repitieron todo)\n"
+        << "Incremental: p50 " << percentile(edit_ms, 0.5) << " ms, p99 " << percentile(edit_ms, 0.99) << " ms, "
+        << (incremental_edits == 0 ? 0 : bytes_transpiled / incremental_edits) << " bytes por cambio\n"
+        << "Archivo completo: p50 " << percentile(full_ms, 0.5) << " ms\n"
+        << "Salidas distintas a la completa: " << mismatches << "\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
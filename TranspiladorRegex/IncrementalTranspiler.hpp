@@ -0,0 +1,509 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "EditList.hpp"
+#include "TopLevelSplitter.hpp"
+#include "TranspilerPipeline.hpp"
+
+// Un tramo de la fuente y el tramo de la salida que produce
+struct SectionSpan {
+    size_t source_offset = 0;
+    size_t source_size = 0;
+    size_t output_offset = 0;
+    size_t output_size = 0;
+};
+
+// Lo que hizo la ultima actualizacion
+struct IncrementalUpdate {
+    bool full_rerun = false;
+    size_t sections_transpiled = 0;
+    size_t bytes_transpiled = 0;
+};
+
+// Mantiene la fuente, la salida y el mapa de tramos de un archivo para volver a
+// transpilar solo lo que cambia. Los tramos empiezan en limites de nivel superior
+// (ver TopLevelSplitter) y cada uno pasa solo por el pipeline fusionado, como en
+// ParallelTranspiler. Un cambio vuelve a dividir y transpilar los tramos que toca
+// (y los siguientes si el ultimo ya no termina limpio) y reemplaza su salida.
+//
+// El estado de todo el archivo se lleva con conteos por tramo: si cambian las
+// decisiones sobre includes o el tramo donde se insertan, se repite todo; si cambian
+// las variables std::string declaradas, se repiten los tramos que consultan alguna
+// de las que cambiaron. Salvo esos casos el trabajo depende del tamano del cambio,
+// no del archivo (solo se copian los textos para aplicarlo).
+class IncrementalTranspiler {
+public:
+    static constexpr size_t section_size = size_t{ 8 } << 10;
+
+private:
+    static constexpr size_t stage_count = TranspilerPipeline::stage_count;
+
+    struct Section {
+        size_t source_size = 0;
+        size_t output_size = 0;
+
+        TranspilerPipeline::IncludeFacts include_facts;
+        std::array<bool, stage_count> needle_found{};
+        std::set<std::string> declared_strings;
+        std::set<std::string> string_lookups;
+    };
+
+    // Conteos por tramo de lo que decide el estado de todo el archivo
+    struct GlobalCounts {
+        size_t has_include = 0;
+        std::array<size_t, 3> has_needle{};
+        std::array<size_t, stage_count> needle_found{};
+        std::map<std::string, size_t> declarations;
+
+        void add(const Section& section, long sign);
+
+        TranspilerPipeline::IncludeFacts includeFacts() const;
+    };
+
+    TranspilerPipeline pipeline;
+    TopLevelSplitter splitter;
+
+    std::string source_text;
+    std::string output_text;
+    std::vector<Section> sections;
+
+    GlobalCounts counts;
+    TranspilerPipeline::IncludePlan includes;
+    size_t include_section = 0;
+    std::set<std::string> declared_strings;
+
+    // Si los tramos no terminan limpios (p. ej. un comentario sin cerrar) el archivo
+    // se transpila entero en cada cambio
+    bool sectioned = false;
+
+    IncrementalUpdate last_update;
+
+public:
+    // Transpila 'content' completo y guarda su mapa de tramos
+    const std::string& reset(std::string_view content);
+
+    // Aplica cambios (ver TextEdit) sobre la fuente actual; no deben solaparse
+    const std::string& apply(std::vector<TextEdit> edits);
+
+    // Como apply(), con un solo cambio deducido del prefijo y el sufijo comunes
+    const std::string& update(std::string_view content);
+
+    const std::string& source() const { return source_text; }
+    const std::string& output() const { return output_text; }
+
+    std::vector<SectionSpan> mapping() const;
+
+    const IncrementalUpdate& lastUpdate() const { return last_update; }
+
+private:
+    const std::string& rerun();
+
+    // Devuelve si el tramo termina limpio
+    bool transpileSection(std::string_view text, bool with_includes, Section& section, std::string& output);
+
+    static Section scanSection(const TranspilerPipeline& pipeline, std::string_view text);
+
+    // Primer tramo con una directiva #include (0 si no hay ninguna)
+    static size_t firstIncludeSection(const std::vector<Section>& list);
+};
+
+
+inline void IncrementalTranspiler::GlobalCounts::add(const Section& section, long sign)
+{
+    auto adjust = [&](size_t& count, bool present) {
+        if (present) count += sign;
+    };
+
+    adjust(has_include, section.include_facts.has_include);
+    for (size_t i = 0; i < has_needle.size(); ++i) adjust(has_needle[i], section.include_facts.has_needle[i]);
+    for (size_t i = 0; i < needle_found.size(); ++i) adjust(needle_found[i], section.needle_found[i]);
+
+    for (const auto& name : section.declared_strings) {
+        size_t& count = declarations[name];
+        count += sign;
+        if (count == 0) declarations.erase(name);
+    }
+}
+
+inline TranspilerPipeline::IncludeFacts IncrementalTranspiler::GlobalCounts::includeFacts() const
+{
+    TranspilerPipeline::IncludeFacts facts;
+    facts.has_include = has_include > 0;
+    for (size_t i = 0; i < has_needle.size(); ++i) facts.has_needle[i] = has_needle[i] > 0;
+    return facts;
+}
+
+inline IncrementalTranspiler::Section IncrementalTranspiler::scanSection(const TranspilerPipeline& pipeline,
+    std::string_view text)
+{
+    Section section;
+    section.source_size = text.size();
+    section.include_facts = pipeline.scanIncludeFacts(text);
+    return section;
+}
+
+inline size_t IncrementalTranspiler::firstIncludeSection(const std::vector<Section>& list)
+{
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (list[i].include_facts.has_include) return i;
+    }
+    return 0;
+}
+
+inline bool IncrementalTranspiler::transpileSection(std::string_view text, bool with_includes, Section& section,
+    std::string& output)
+{
+    TranspilerPipeline::SectionResult result = pipeline.transpileSection(text,
+        with_includes ? includes : TranspilerPipeline::IncludePlan{}, declared_strings);
+
+    section = scanSection(pipeline, text);
+    section.output_size = result.output.size();
+    section.needle_found = result.needle_found;
+    section.declared_strings = std::move(result.declared_strings);
+    section.string_lookups = std::move(result.string_lookups);
+
+    ++last_update.sections_transpiled;
+    last_update.bytes_transpiled += text.size();
+
+    output = std::move(result.output);
+    return result.ends_idle;
+}
+
+inline const std::string& IncrementalTranspiler::reset(std::string_view content)
+{
+    source_text.assign(content);
+    return rerun();
+}
+
+inline const std::string& IncrementalTranspiler::rerun()
+{
+    last_update = IncrementalUpdate{};
+    last_update.full_rerun = true;
+
+    sections.clear();
+    counts = GlobalCounts{};
+    declared_strings.clear();
+
+    std::vector<std::string_view> declaration_lines;
+    std::vector<std::string_view> pieces = splitter.split(source_text, section_size, declaration_lines);
+
+    // Las decisiones sobre includes se toman con los datos de todos los tramos
+    std::vector<Section> scanned;
+    TranspilerPipeline::IncludeFacts facts;
+    for (std::string_view piece : pieces) {
+        scanned.push_back(scanSection(pipeline, piece));
+        facts.merge(scanned.back().include_facts);
+    }
+
+    includes = TranspilerPipeline::planIncludes(facts);
+    include_section = firstIncludeSection(scanned);
+
+    // Primera aproximacion de las variables std::string, como en ParallelTranspiler
+    for (std::string_view line : declaration_lines) {
+        bool has_newline = line.data() + line.size() < source_text.data() + source_text.size();
+        pipeline.collectDeclarations(line, has_newline, declared_strings);
+    }
+
+    // El ultimo tramo puede terminar con estado: no hay texto despues
+    std::vector<std::string> outputs(pieces.size());
+    sections.resize(pieces.size());
+    bool valid = true;
+    for (size_t i = 0; i < pieces.size() && valid; ++i) {
+        valid = transpileSection(pieces[i], i == include_section, sections[i], outputs[i]) || i + 1 == pieces.size();
+    }
+
+    if (valid) {
+        for (const auto& section : sections) counts.add(section, 1);
+
+        // Se repiten los tramos que consultaron una variable mal clasificada
+        std::set<std::string> actual;
+        for (const auto& entry : counts.declarations) actual.insert(entry.first);
+
+        if (actual != declared_strings) {
+            std::set<std::string> previous;
+            previous.swap(declared_strings);
+            declared_strings = actual;
+
+            for (size_t i = 0; i < sections.size() && valid; ++i) {
+                bool mismatched = std::any_of(sections[i].string_lookups.begin(), sections[i].string_lookups.end(),
+                    [&](const std::string& name) { return actual.count(name) != previous.count(name); });
+                if (!mismatched) continue;
+
+                counts.add(sections[i], -1);
+                valid = transpileSection(pieces[i], i == include_section, sections[i], outputs[i]) ||
+                    i + 1 == pieces.size();
+                counts.add(sections[i], 1);
+            }
+
+            std::set<std::string> rerun_declarations;
+            for (const auto& entry : counts.declarations) rerun_declarations.insert(entry.first);
+            valid = valid && rerun_declarations == declared_strings;
+        }
+    }
+
+    std::array<bool, stage_count> found{};
+    for (size_t i = 0; i < found.size(); ++i) found[i] = counts.needle_found[i] > 0;
+    valid = valid && found == TranspilerPipeline::expectedNeedles(includes);
+
+    sectioned = valid;
+    if (!sectioned) {
+        sections.clear();
+        counts = GlobalCounts{};
+        output_text = pipeline.transpile(source_text);
+        return output_text;
+    }
+
+    size_t total = 0;
+    for (const auto& output : outputs) total += output.size();
+
+    output_text.clear();
+    output_text.reserve(total);
+    for (const auto& output : outputs) output_text += output;
+
+    return output_text;
+}
+
+inline const std::string& IncrementalTranspiler::update(std::string_view content)
+{
+    std::string_view previous = source_text;
+
+    size_t prefix = 0;
+    size_t limit = std::min(previous.size(), content.size());
+    while (prefix < limit && previous[prefix] == content[prefix]) ++prefix;
+
+    size_t suffix = 0;
+    while (suffix < limit - prefix &&
+        previous[previous.size() - 1 - suffix] == content[content.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    TextEdit edit{ prefix, previous.size() - prefix - suffix,
+        std::string(content.substr(prefix, content.size() - prefix - suffix)) };
+
+    return apply({ std::move(edit) });
+}
+
+inline const std::string& IncrementalTranspiler::apply(std::vector<TextEdit> edits)
+{
+    std::sort(edits.begin(), edits.end(), [](const TextEdit& a, const TextEdit& b) { return a.offset < b.offset; });
+
+    for (size_t i = 0; i < edits.size(); ++i) {
+        if (edits[i].offset + edits[i].length > source_text.size() ||
+            (i > 0 && edits[i].offset < edits[i - 1].offset + edits[i - 1].length)) {
+            throw std::invalid_argument("Cambios fuera del texto o superpuestos");
+        }
+    }
+
+    last_update = IncrementalUpdate{};
+
+    edits.erase(std::remove_if(edits.begin(), edits.end(),
+        [](const TextEdit& edit) { return edit.length == 0 && edit.replacement.empty(); }), edits.end());
+    if (edits.empty()) return output_text;
+
+    size_t change_begin = edits.front().offset;
+    size_t change_end = edits.back().offset + edits.back().length;
+
+    long delta = 0;
+    for (auto it = edits.rbegin(); it != edits.rend(); ++it) {
+        source_text.replace(it->offset, it->length, it->replacement);
+        delta += static_cast<long>(it->replacement.size()) - static_cast<long>(it->length);
+    }
+
+    if (!sectioned) return rerun();
+
+    // Tramos que tocan [change_begin, change_end]; un cambio en un limite tambien
+    // incluye el tramo anterior
+    size_t first = sections.size();
+    size_t last = 0;
+    size_t region_begin = 0;
+    size_t region_end = 0;
+    size_t output_begin = 0;
+    size_t output_end = 0;
+
+    size_t source_offset = 0;
+    size_t output_offset = 0;
+    for (size_t i = 0; i < sections.size(); ++i) {
+        size_t section_end = source_offset + sections[i].source_size;
+        if (source_offset <= change_end && section_end >= change_begin) {
+            if (first == sections.size()) {
+                first = i;
+                region_begin = source_offset;
+                output_begin = output_offset;
+            }
+            last = i;
+            region_end = section_end;
+            output_end = output_offset + sections[i].output_size;
+        }
+        else if (source_offset > change_end) {
+            break;
+        }
+
+        source_offset = section_end;
+        output_offset += sections[i].output_size;
+    }
+
+    if (first == sections.size()) return rerun();
+
+    size_t old_region_size = region_end - region_begin;
+
+    // Solo las variables declaradas en la region pueden aparecer o desaparecer
+    std::set<std::string> candidates;
+
+    while (true) {
+        size_t new_region_size = static_cast<size_t>(static_cast<long>(old_region_size) + delta);
+        std::string_view region = std::string_view(source_text).substr(region_begin, new_region_size);
+        bool region_at_end = last + 1 == sections.size();
+
+        std::vector<std::string_view> unused;
+        std::vector<std::string_view> pieces = splitter.split(region, section_size, unused);
+
+        std::vector<Section> replacement;
+        for (std::string_view piece : pieces) replacement.push_back(scanSection(pipeline, piece));
+
+        // Decisiones sobre includes con el tramo reemplazado
+        GlobalCounts updated_includes;
+        updated_includes.has_include = counts.has_include;
+        updated_includes.has_needle = counts.has_needle;
+        for (size_t i = first; i <= last; ++i) updated_includes.add(sections[i], -1);
+        for (const auto& section : replacement) updated_includes.add(section, 1);
+
+        if (TranspilerPipeline::planIncludes(updated_includes.includeFacts()) != includes) return rerun();
+
+        // El tramo de las directivas nuevas solo puede cambiar dentro de la region
+        size_t new_include_section;
+        if (include_section < first && sections[include_section].include_facts.has_include) {
+            new_include_section = include_section;
+        }
+        else {
+            size_t inside = firstIncludeSection(replacement);
+            if (replacement[inside].include_facts.has_include) {
+                new_include_section = first + inside;
+            }
+            else {
+                new_include_section = 0;
+                for (size_t i = last + 1; i < sections.size(); ++i) {
+                    if (sections[i].include_facts.has_include) {
+                        new_include_section = i - (last + 1) + first + replacement.size();
+                        break;
+                    }
+                }
+            }
+        }
+
+        auto in_region = [&](size_t index, size_t count) { return index >= first && index < first + count; };
+        size_t mapped_old = include_section > last ? include_section - (last + 1) + first + replacement.size()
+            : include_section;
+        if (!in_region(new_include_section, replacement.size()) || !in_region(include_section, last + 1 - first)) {
+            if (new_include_section != mapped_old) return rerun();
+        }
+
+        std::vector<std::string> outputs(pieces.size());
+        size_t unclean = pieces.size();
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            if (!transpileSection(pieces[i], first + i == new_include_section, replacement[i], outputs[i])) {
+                unclean = i;
+                break;
+            }
+        }
+
+        // Un corte mal elegido dentro de la region obliga a repetir todo; si la region
+        // ya no termina limpia, se extiende al tramo siguiente
+        if (unclean + 1 < pieces.size()) return rerun();
+        if (unclean + 1 == pieces.size() && !region_at_end) {
+            ++last;
+            old_region_size += sections[last].source_size;
+            output_end += sections[last].output_size;
+            continue;
+        }
+
+        for (size_t i = first; i <= last; ++i) {
+            counts.add(sections[i], -1);
+            candidates.insert(sections[i].declared_strings.begin(), sections[i].declared_strings.end());
+        }
+        for (const auto& section : replacement) {
+            counts.add(section, 1);
+            candidates.insert(section.declared_strings.begin(), section.declared_strings.end());
+        }
+
+        std::string patch;
+        for (const auto& output : outputs) patch += output;
+        output_text.replace(output_begin, output_end - output_begin, patch);
+
+        sections.erase(sections.begin() + first, sections.begin() + last + 1);
+        sections.insert(sections.begin() + first, replacement.begin(), replacement.end());
+        include_section = new_include_section;
+        break;
+    }
+
+    // Variables std::string que aparecieron o desaparecieron: se repiten los tramos
+    // que consultan alguna
+    std::set<std::string> changed;
+    for (const auto& name : candidates) {
+        bool declared = counts.declarations.count(name) != 0;
+        if (declared != (declared_strings.count(name) != 0)) {
+            changed.insert(name);
+            if (declared) declared_strings.insert(name);
+            else declared_strings.erase(name);
+        }
+    }
+
+    if (!changed.empty()) {
+        size_t source_at = 0;
+        size_t output_at = 0;
+        for (size_t i = 0; i < sections.size(); ++i) {
+            Section& section = sections[i];
+            bool affected = std::any_of(section.string_lookups.begin(), section.string_lookups.end(),
+                [&](const std::string& name) { return changed.count(name) != 0; });
+
+            if (affected) {
+                std::string output;
+                Section redone;
+                bool ends_idle = transpileSection(std::string_view(source_text).substr(source_at, section.source_size),
+                    i == include_section, redone, output) || i + 1 == sections.size();
+                if (!ends_idle || redone.declared_strings != section.declared_strings) return rerun();
+
+                output_text.replace(output_at, section.output_size, output);
+
+                counts.add(section, -1);
+                section = std::move(redone);
+                counts.add(section, 1);
+            }
+
+            source_at += section.source_size;
+            output_at += section.output_size;
+        }
+    }
+
+    std::array<bool, stage_count> found{};
+    for (size_t i = 0; i < found.size(); ++i) found[i] = counts.needle_found[i] > 0;
+    if (found != TranspilerPipeline::expectedNeedles(includes)) return rerun();
+
+    return output_text;
+}
+
+inline std::vector<SectionSpan> IncrementalTranspiler::mapping() const
+{
+    if (!sectioned) {
+        return { SectionSpan{ 0, source_text.size(), 0, output_text.size() } };
+    }
+
+    std::vector<SectionSpan> spans;
+    spans.reserve(sections.size());
+
+    SectionSpan span;
+    for (const auto& section : sections) {
+        span.source_size = section.source_size;
+        span.output_size = section.output_size;
+        spans.push_back(span);
+
+        span.source_offset += section.source_size;
+        span.output_offset += section.output_size;
+    }
+    return spans;
+}
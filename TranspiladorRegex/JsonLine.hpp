@@ -0,0 +1,247 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Lectura minima de JSON Lines: cada linea es un objeto y solo interesan algunos
+// campos de texto de primer nivel (p. ej. "source_code" en los conjuntos de
+// AfinamientoLLM). Los demas valores, incluidos objetos y arreglos anidados, se
+// saltan sin interpretarlos. Una linea mal formada hace fallar la busqueda.
+// appendString() escribe el caso inverso: un texto como cadena JSON.
+class JsonLine {
+public:
+    // Busca 'field' en el objeto de 'line' y deja su texto ya sin escapes en
+    // 'value'. Devuelve false si no esta, si no es una cadena o si el JSON es invalido
+    static bool findString(std::string_view line, std::string_view field, std::string& value);
+
+    // Ubica el valor de 'field' tal como esta escrito (cadena con comillas, numero,
+    // objeto...): line[begin, end). Devuelve false si no esta o si el JSON es invalido
+    static bool findValue(std::string_view line, std::string_view field, size_t& begin, size_t& end);
+
+    // Agrega 'text' entre comillas, con los escapes que exige JSON
+    static void appendString(std::string& out, std::string_view text);
+
+private:
+    static size_t skipSpaces(std::string_view text, size_t pos);
+
+    // 'pos' apunta a la comilla inicial; deja 'pos' despues de la final. Si
+    // 'value' no es nulo se agrega el texto decodificado
+    static bool parseString(std::string_view text, size_t& pos, std::string* value);
+
+    static bool skipValue(std::string_view text, size_t& pos);
+
+    static bool parseHex4(std::string_view text, size_t pos, uint32_t& code);
+
+    static void appendUtf8(std::string& out, uint32_t code);
+};
+
+
+inline size_t JsonLine::skipSpaces(std::string_view text, size_t pos)
+{
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n')) {
+        ++pos;
+    }
+    return pos;
+}
+
+inline bool JsonLine::findString(std::string_view line, std::string_view field, std::string& value)
+{
+    size_t begin, end;
+    if (!findValue(line, field, begin, end) || line[begin] != '"') return false;
+
+    value.clear();
+    return parseString(line, begin, &value);
+}
+
+inline bool JsonLine::findValue(std::string_view line, std::string_view field, size_t& begin, size_t& end)
+{
+    size_t pos = skipSpaces(line, 0);
+    if (pos >= line.size() || line[pos] != '{') return false;
+    pos = skipSpaces(line, pos + 1);
+
+    std::string key;
+    while (pos < line.size() && line[pos] != '}') {
+        key.clear();
+        if (line[pos] != '"' || !parseString(line, pos, &key)) return false;
+
+        pos = skipSpaces(line, pos);
+        if (pos >= line.size() || line[pos] != ':') return false;
+        pos = skipSpaces(line, pos + 1);
+
+        if (key == field) {
+            begin = pos;
+            if (!skipValue(line, pos)) return false;
+            end = pos;
+            return true;
+        }
+
+        if (!skipValue(line, pos)) return false;
+
+        pos = skipSpaces(line, pos);
+        if (pos < line.size() && line[pos] == ',') pos = skipSpaces(line, pos + 1);
+    }
+
+    return false;
+}
+
+inline void JsonLine::appendString(std::string& out, std::string_view text)
+{
+    static constexpr char digits[] = "0123456789abcdef";
+
+    out += '"';
+    size_t copied = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        out.append(text.substr(copied, i - copied));
+        copied = i + 1;
+
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            out += "\\u00";
+            out += digits[c >> 4];
+            out += digits[c & 0xf];
+            break;
+        }
+    }
+    out.append(text.substr(copied));
+    out += '"';
+}
+
+inline bool JsonLine::parseString(std::string_view text, size_t& pos, std::string* value)
+{
+    ++pos;
+    while (pos < text.size()) {
+        // Los tramos sin escapes se copian de una vez
+        size_t end = text.find_first_of("\"\\", pos);
+        if (end == std::string_view::npos) return false;
+        if (value) value->append(text.substr(pos, end - pos));
+        pos = end;
+
+        if (text[pos] == '"') {
+            ++pos;
+            return true;
+        }
+
+        if (pos + 1 >= text.size()) return false;
+        char escape = text[pos + 1];
+        pos += 2;
+
+        char decoded;
+        switch (escape) {
+        case '"': decoded = '"'; break;
+        case '\\': decoded = '\\'; break;
+        case '/': decoded = '/'; break;
+        case 'b': decoded = '\b'; break;
+        case 'f': decoded = '\f'; break;
+        case 'n': decoded = '\n'; break;
+        case 'r': decoded = '\r'; break;
+        case 't': decoded = '\t'; break;
+        case 'u': {
+            uint32_t code;
+            if (!parseHex4(text, pos, code)) return false;
+            pos += 4;
+
+            // Par sustituto de UTF-16: el segundo \uXXXX completa el caracter
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                uint32_t low;
+                if (pos + 1 >= text.size() || text[pos] != '\\' || text[pos + 1] != 'u' ||
+                    !parseHex4(text, pos + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                    return false;
+                }
+                pos += 6;
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+
+            if (value) appendUtf8(*value, code);
+            continue;
+        }
+        default:
+            return false;
+        }
+
+        if (value) value->push_back(decoded);
+    }
+
+    return false;
+}
+
+inline bool JsonLine::skipValue(std::string_view text, size_t& pos)
+{
+    if (pos >= text.size()) return false;
+
+    if (text[pos] == '"') return parseString(text, pos, nullptr);
+
+    if (text[pos] == '{' || text[pos] == '[') {
+        // Solo importa el anidamiento; las cadenas se saltan para no contar sus llaves
+        size_t depth = 0;
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '"') {
+                if (!parseString(text, pos, nullptr)) return false;
+                continue;
+            }
+            if (c == '{' || c == '[') ++depth;
+            else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    ++pos;
+                    return true;
+                }
+            }
+            ++pos;
+        }
+        return false;
+    }
+
+    // Numero, true, false o null
+    size_t start = pos;
+    while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ']' &&
+        text[pos] != ' ' && text[pos] != '\t' && text[pos] != '\r' && text[pos] != '\n') {
+        ++pos;
+    }
+    return pos > start;
+}
+
+inline bool JsonLine::parseHex4(std::string_view text, size_t pos, uint32_t& code)
+{
+    if (pos + 4 > text.size()) return false;
+
+    code = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        char c = text[pos + i];
+        code <<= 4;
+        if (c >= '0' && c <= '9') code |= static_cast<uint32_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') code |= static_cast<uint32_t>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') code |= static_cast<uint32_t>(c - 'A' + 10);
+        else return false;
+    }
+    return true;
+}
+
+inline void JsonLine::appendUtf8(std::string& out, uint32_t code)
+{
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    }
+    else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+    else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+    else {
+        out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonLine.hpp"
+#include "MappedFile.hpp"
+#include "TranspilerPipeline.hpp"
+#include "WorkStealingPool.hpp"
+
+struct JsonlSummary {
+    size_t records = 0;
+
+    // Registros sin el campo de entrada como cadena, con JSON invalido o cuya
+    // transpilacion fallo: se copian sin cambios
+    size_t skipped = 0;
+
+    uintmax_t bytes = 0;
+    double seconds = 0;
+
+    void print(std::ostream& out) const;
+};
+
+// Preprocesa conjuntos JSON Lines como los de AfinamientoLLM: cada registro es un
+// objeto en una linea. Se transpila su campo "source_code" y el resultado se
+// escribe como un campo nuevo ("regex_code" por omision) al final del objeto, o en
+// lugar del valor anterior si el campo ya existe. El resto de la linea se copia tal
+// cual y los registros conservan su orden.
+//
+// La entrada se proyecta en memoria y se recorre por bloques: los registros de un
+// bloque se reparten entre los hilos (un pipeline por hilo) y el bloque se escribe
+// completo antes de pasar al siguiente, asi que la memoria no crece con el archivo.
+// La salida va a un temporal que reemplaza al destino al terminar.
+class JsonlTranspiler {
+private:
+    enum class RecordStatus : unsigned char { Converted, Blank, MissingSource, Failed };
+
+    // Limites de un bloque: registros y bytes de entrada
+    static constexpr size_t block_records = 4096;
+    static constexpr size_t block_bytes = size_t{ 8 } << 20;
+
+    PipelineMode mode;
+    WorkStealingPool pool;
+    std::vector<TranspilerPipeline> pipelines;
+
+    std::string source_field = "source_code";
+    std::string output_field;
+
+public:
+    explicit JsonlTranspiler(PipelineMode mode = PipelineMode::Fused, size_t workers = 0,
+        std::string output_field = "regex_code", const Instrumentation& instrumentation = {});
+
+    // Los registros omitidos se informan en 'errors' con su numero de linea
+    JsonlSummary run(const std::string& input_path, const std::string& output_path, std::ostream& errors);
+
+    // 'record' con 'field' igual a 'code'; false si 'record' no es un objeto
+    static bool setStringField(std::string_view record, std::string_view field, std::string_view code,
+        std::string& out);
+
+private:
+    // Agrega a 'out' el registro (convertido o sin cambios) y su '\n'
+    RecordStatus transpileRecord(TranspilerPipeline& pipeline, std::string_view record, std::string& source,
+        std::string& out) const;
+};
+
+
+inline void JsonlSummary::print(std::ostream& out) const
+{
+    double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    double elapsed = seconds > 0 ? seconds : 1e-9;
+
+    out << std::fixed << std::setprecision(2)
+        << "Registros: " << records << " (" << skipped << " sin convertir), "
+        << megabytes << " MB en " << seconds << " s: "
+        << static_cast<double>(records) / elapsed << " registros/s, "
+        << megabytes / elapsed << " MB/s\n";
+}
+
+inline JsonlTranspiler::JsonlTranspiler(PipelineMode mode, size_t workers, std::string output_field,
+    const Instrumentation& instrumentation)
+    : mode(mode), pool(workers), pipelines(pool.size()), output_field(std::move(output_field))
+{
+    if (instrumentation.enabled()) {
+        for (auto& pipeline : pipelines) pipeline.instrument(instrumentation);
+    }
+}
+
+inline bool JsonlTranspiler::setStringField(std::string_view record, std::string_view field, std::string_view code,
+    std::string& out)
+{
+    size_t begin, end;
+    if (JsonLine::findValue(record, field, begin, end)) {
+        out.append(record.substr(0, begin));
+        JsonLine::appendString(out, code);
+        out.append(record.substr(end));
+        return true;
+    }
+
+    // Campo nuevo antes de la llave de cierre
+    size_t close = record.find_last_not_of(" \t\r");
+    if (close == std::string_view::npos || close == 0 || record[close] != '}') return false;
+
+    size_t last = record.find_last_not_of(" \t\r", close - 1);
+    if (last == std::string_view::npos) return false;
+
+    out.append(record.substr(0, close));
+    if (record[last] != '{') out += ", ";
+    JsonLine::appendString(out, field);
+    out += ": ";
+    JsonLine::appendString(out, code);
+    out.append(record.substr(close));
+    return true;
+}
+
+inline JsonlTranspiler::RecordStatus JsonlTranspiler::transpileRecord(TranspilerPipeline& pipeline,
+    std::string_view record, std::string& source, std::string& out) const
+{
+    RecordStatus status = RecordStatus::MissingSource;
+
+    if (record.find_first_not_of(" \t\r") == std::string_view::npos) {
+        status = RecordStatus::Blank;
+    }
+    else if (JsonLine::findString(record, source_field, source)) {
+        size_t out_start = out.size();
+        try {
+            std::string code = pipeline.transpile(source, mode);
+            if (setStringField(record, output_field, code, out)) {
+                out += '\n';
+                return RecordStatus::Converted;
+            }
+        }
+        catch (const std::exception&) {
+            status = RecordStatus::Failed;
+        }
+        out.resize(out_start);
+    }
+
+    out.append(record);
+    out += '\n';
+    return status;
+}
+
+inline JsonlSummary JsonlTranspiler::run(const std::string& input_path, const std::string& output_path,
+    std::ostream& errors)
+{
+    namespace fs = std::filesystem;
+    auto start = std::chrono::steady_clock::now();
+
+    MappedFile input;
+    if (!input.open(input_path)) {
+        throw std::runtime_error("No se pudo abrir el archivo: " + input_path);
+    }
+    std::string_view content = input.view();
+
+    // El temporal va junto al destino: rename() no cruza sistemas de archivos y la
+    // entrada puede ser el mismo archivo que la salida
+    std::string temp_path = output_path + ".tmp";
+    std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        throw std::runtime_error("No se pudo escribir el archivo: " + temp_path);
+    }
+
+    JsonlSummary summary;
+    summary.bytes = content.size();
+
+    std::vector<std::string_view> records;
+    std::vector<std::string> results;
+    std::vector<RecordStatus> statuses;
+    std::vector<std::string> sources(pool.size());
+    std::vector<size_t> order;
+    size_t first_line = 1;
+
+    for (size_t pos = 0; pos < content.size();) {
+        // Siguiente bloque de lineas completas
+        records.clear();
+        size_t block_start = pos;
+        while (pos < content.size() && records.size() < block_records && pos - block_start < block_bytes) {
+            size_t end = content.find('\n', pos);
+            if (end == std::string_view::npos) end = content.size();
+
+            records.push_back(content.substr(pos, end - pos));
+            pos = end + 1;
+        }
+
+        results.assign(records.size(), std::string());
+        statuses.assign(records.size(), RecordStatus::Converted);
+        order.resize(records.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+
+        pool.run(order, [&](size_t worker, size_t index) {
+            statuses[index] = transpileRecord(pipelines[worker], records[index], sources[worker], results[index]);
+        });
+
+        for (size_t i = 0; i < records.size(); ++i) {
+            output.write(results[i].data(), static_cast<std::streamsize>(results[i].size()));
+
+            // Las lineas en blanco se conservan y no cuentan como registros
+            if (statuses[i] == RecordStatus::Blank) continue;
+            ++summary.records;
+
+            if (statuses[i] == RecordStatus::Converted) continue;
+            ++summary.skipped;
+            errors << input_path << ":" << first_line + i << ": "
+                << (statuses[i] == RecordStatus::Failed ? "no se pudo transpilar"
+                    : "sin \"" + source_field + "\" como cadena o JSON invalido")
+                << ", se copia sin cambios\n";
+        }
+        first_line += records.size();
+    }
+
+    output.close();
+    if (!output) {
+        std::error_code error;
+        fs::remove(temp_path, error);
+        throw std::runtime_error("No se pudo escribir el archivo: " + temp_path);
+    }
+
+    // La proyeccion se libera antes de reemplazar un destino que puede ser la entrada
+    input.close();
+
+    std::error_code error;
+    fs::rename(temp_path, output_path, error);
+    if (error) {
+        fs::remove(temp_path, error);
+        throw std::runtime_error("No se pudo escribir el archivo: " + output_path);
+    }
+
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
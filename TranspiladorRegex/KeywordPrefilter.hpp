@@ -0,0 +1,247 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ByteClassScanner.hpp"
+
+// Bits de disparo: que etapas necesitan examinar una linea
+enum PassTrigger : unsigned {
+    trigger_define = 1u << 0,               // "#define"
+    trigger_null = 1u << 1,                 // "NULL"
+    trigger_array = 1u << 2,                // "["
+    trigger_string_declaration = 1u << 3,   // "char"
+    trigger_string_operation = 1u << 4,     // "strcpy", "strcmp"
+    trigger_printf = 1u << 5,               // "printf"
+    trigger_include = 1u << 6,              // "#include"
+    trigger_lexer = 1u << 7,                // caracteres que cambian el estado del lexer
+    all_triggers = (1u << 8) - 1
+};
+
+// Automata de Aho-Corasick sobre las palabras clave de todas las etapas. Un solo
+// recorrido de la linea devuelve la union de los bits de las palabras que aparecen;
+// las lineas sin ningun bit de una etapa pueden copiarse sin analizarlas.
+// Para un archivo completo, forEachLine clasifica todo el buffer con
+// ByteClassScanner y solo compara palabras donde empieza alguna.
+class KeywordPrefilter {
+private:
+    struct Keyword {
+        std::string_view text;
+        unsigned triggers;
+    };
+
+    // La tabla de transiciones es completa (un DFA): cada byte cuesta un acceso
+    std::vector<std::array<uint16_t, 256>> transitions;
+    std::vector<unsigned> outputs;
+
+    // Palabras ordenadas por su primer byte, que es lo que marca el escaner:
+    // las que empiezan con b son keywords[first_keyword[b] .. first_keyword[b + 1])
+    std::vector<Keyword> keywords;
+    std::array<uint8_t, 257> first_keyword{};
+    ByteClassScanner first_byte_scanner;
+
+public:
+    KeywordPrefilter();
+
+    unsigned scan(std::string_view text) const;
+
+    // Recorre 'content' como ::forEachLine y entrega ademas los bits de cada linea:
+    // handler(line, has_newline, triggers)
+    template <typename LineHandler>
+    void forEachLine(std::string_view content, LineHandler&& handler) const;
+
+    // Igual, reutilizando los mapas de bits del llamador
+    template <typename LineHandler>
+    void forEachLine(std::string_view content, ByteClassBitmaps& bitmaps, LineHandler&& handler) const;
+
+    // Instancia compartida e inmutable, construida una sola vez
+    static const KeywordPrefilter& shared();
+
+    // Reutiliza los bits de 'original' si una etapa entrego la misma vista sin
+    // cambios; si la reescribio, vuelve a analizarla
+    static unsigned rescanIfChanged(std::string_view original, std::string_view result, unsigned triggers);
+
+private:
+    void build();
+
+    static std::vector<Keyword> defaultKeywords();
+
+    static std::string firstBytes(const std::vector<Keyword>& keywords);
+
+    // Bits de las palabras que empiezan en 'pos' y terminan antes de 'end'
+    unsigned triggersAt(std::string_view content, size_t pos, size_t end) const;
+};
+
+
+inline KeywordPrefilter::KeywordPrefilter()
+    : keywords(defaultKeywords()), first_byte_scanner(firstBytes(keywords))
+{
+    std::stable_sort(keywords.begin(), keywords.end(), [](const Keyword& a, const Keyword& b) {
+        return static_cast<unsigned char>(a.text[0]) < static_cast<unsigned char>(b.text[0]);
+    });
+
+    size_t index = 0;
+    for (size_t byte = 0; byte < 256; ++byte) {
+        first_keyword[byte] = static_cast<uint8_t>(index);
+        while (index < keywords.size() && static_cast<unsigned char>(keywords[index].text[0]) == byte) ++index;
+    }
+    first_keyword[256] = static_cast<uint8_t>(index);
+
+    build();
+}
+
+inline std::vector<KeywordPrefilter::Keyword> KeywordPrefilter::defaultKeywords()
+{
+    return {
+        { "#define", trigger_define },
+        { "NULL", trigger_null },
+        { "[", trigger_array },
+        { "char", trigger_string_declaration },
+        { "strcpy", trigger_string_operation },
+        { "strcmp", trigger_string_operation },
+        { "printf", trigger_printf },
+        { "#include", trigger_include },
+        { "/", trigger_lexer },
+        { "\"", trigger_lexer },
+        { "'", trigger_lexer },
+        { "\\", trigger_lexer },
+        { "#", trigger_lexer },
+    };
+}
+
+inline std::string KeywordPrefilter::firstBytes(const std::vector<Keyword>& keywords)
+{
+    std::string bytes;
+    for (const auto& keyword : keywords) {
+        if (bytes.find(keyword.text[0]) == std::string::npos) {
+            bytes += keyword.text[0];
+        }
+    }
+    return bytes;
+}
+
+inline const KeywordPrefilter& KeywordPrefilter::shared()
+{
+    static const KeywordPrefilter prefilter;
+    return prefilter;
+}
+
+inline unsigned KeywordPrefilter::rescanIfChanged(std::string_view original, std::string_view result,
+    unsigned triggers)
+{
+    if (result.data() == original.data() && result.size() == original.size()) {
+        return triggers;
+    }
+    return shared().scan(result);
+}
+
+inline void KeywordPrefilter::build()
+{
+    // Trie de las palabras clave; 0 marca "sin transicion" (la raiz nunca es destino)
+    transitions.assign(1, {});
+    outputs.assign(1, 0);
+
+    for (const auto& keyword : keywords) {
+        uint16_t state = 0;
+        for (char c : keyword.text) {
+            auto byte = static_cast<unsigned char>(c);
+            if (transitions[state][byte] == 0) {
+                transitions[state][byte] = static_cast<uint16_t>(transitions.size());
+                transitions.emplace_back();
+                outputs.push_back(0);
+            }
+            state = transitions[state][byte];
+        }
+        outputs[state] |= keyword.triggers;
+    }
+
+    // Recorrido en anchura: los enlaces de falla completan las transiciones
+    // faltantes y propagan las salidas de los sufijos
+    std::vector<uint16_t> failure(transitions.size(), 0);
+    std::vector<uint16_t> queue;
+    queue.reserve(transitions.size());
+
+    for (auto& next : transitions[0]) {
+        if (next != 0) queue.push_back(next);
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint16_t state = queue[head];
+        outputs[state] |= outputs[failure[state]];
+
+        for (size_t byte = 0; byte < 256; ++byte) {
+            uint16_t next = transitions[state][byte];
+            uint16_t fallback = transitions[failure[state]][byte];
+
+            if (next == 0) {
+                transitions[state][byte] = fallback;
+            }
+            else {
+                failure[next] = fallback;
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+inline unsigned KeywordPrefilter::scan(std::string_view text) const
+{
+    unsigned found = 0;
+    uint16_t state = 0;
+
+    for (char c : text) {
+        state = transitions[state][static_cast<unsigned char>(c)];
+        found |= outputs[state];
+    }
+
+    return found;
+}
+
+inline unsigned KeywordPrefilter::triggersAt(std::string_view content, size_t pos, size_t end) const
+{
+    auto byte = static_cast<unsigned char>(content[pos]);
+    unsigned found = 0;
+
+    // El primer byte ya coincide; se compara el resto sin llamar a memcmp
+    for (size_t index = first_keyword[byte]; index < first_keyword[byte + 1]; ++index) {
+        std::string_view text = keywords[index].text;
+        if (text.size() > end - pos) continue;
+
+        size_t i = 1;
+        while (i < text.size() && content[pos + i] == text[i]) ++i;
+        if (i == text.size()) found |= keywords[index].triggers;
+    }
+
+    return found;
+}
+
+template <typename LineHandler>
+void KeywordPrefilter::forEachLine(std::string_view content, LineHandler&& handler) const
+{
+    ByteClassBitmaps bitmaps;
+    forEachLine(content, bitmaps, handler);
+}
+
+template <typename LineHandler>
+void KeywordPrefilter::forEachLine(std::string_view content, ByteClassBitmaps& bitmaps, LineHandler&& handler) const
+{
+    first_byte_scanner.scan(content, bitmaps);
+
+    size_t line_start = 0;
+
+    while (line_start < content.size()) {
+        size_t line_end = bitmaps.nextNewline(line_start);
+        bool has_newline = line_end < content.size();
+
+        unsigned triggers = 0;
+        bitmaps.forEachSpecial(line_start, line_end, [&](size_t pos) {
+            triggers |= triggersAt(content, pos, line_end);
+        });
+
+        handler(content.substr(line_start, line_end - line_start), has_newline, triggers);
+
+        line_start = line_end + 1;
+    }
+}
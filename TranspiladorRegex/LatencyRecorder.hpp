@@ -0,0 +1,65 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Latencias de las ultimas mediciones (solicitudes del servidor, lotes del modo
+// de vigilancia); los percentiles se calculan al pedirlos
+class LatencyRecorder {
+private:
+    static constexpr size_t window = 8192;
+
+    mutable std::mutex mutex;
+    std::vector<double> samples;
+    size_t next = 0;
+    uint64_t count = 0;
+
+public:
+    struct Summary {
+        uint64_t count = 0;
+        double p50 = 0;
+        double p99 = 0;
+        double max = 0;
+    };
+
+    void record(double microseconds);
+
+    Summary summary() const;
+};
+
+
+inline void LatencyRecorder::record(double microseconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (samples.size() < window) {
+        samples.push_back(microseconds);
+    }
+    else {
+        samples[next] = microseconds;
+    }
+    next = (next + 1) % window;
+    ++count;
+}
+
+inline LatencyRecorder::Summary LatencyRecorder::summary() const
+{
+    std::vector<double> sorted;
+    Summary result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted = samples;
+        result.count = count;
+    }
+    if (sorted.empty()) return result;
+
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double fraction) {
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * static_cast<double>(sorted.size())))];
+    };
+
+    result.p50 = percentile(0.50);
+    result.p99 = percentile(0.99);
+    result.max = sorted.back();
+    return result;
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include "ByteHash.hpp"
+#include "CLexer.hpp"
+#include "EditList.hpp"
+#include "TranspilerStats.hpp"
+
+// Etapas que consultan la memoria de lineas
+enum class MemoPass : unsigned char { Define, Null, Array, Printf };
+
+// Resultados ya calculados de las etapas que trabajan linea a linea. Si una linea
+// empieza con el lexer en su estado inicial, lo que la etapa agrega a su salida y
+// el estado en que deja al lexer dependen solo de sus bytes: las lineas repetidas
+// ("#include <stdio.h>", "int* p = NULL;", los printf habituales) se copian de
+// aqui sin analizarlas.
+//
+// La tabla tiene un tamano fijo: cada linea va a una sola casilla segun su hash y
+// reemplaza a la que estuviera. Se divide en grupos con su propio mutex para que
+// varios hilos la usen a la vez.
+//
+// Con --stats cada casilla guarda ademas las coincidencias por regla que se
+// contaron al analizar la linea, y una linea que sale de la memoria las vuelve a
+// sumar: los contadores por regla no dependen de la memoria
+class LineMemo {
+public:
+    static constexpr size_t shard_count = 64;
+    static constexpr size_t default_slots_per_shard = 256;
+
+    // Las lineas mas largas casi nunca se repiten; no se guardan
+    static constexpr size_t max_line_size = 256;
+    static constexpr size_t max_output_size = 4 * max_line_size;
+
+    struct Stats {
+        uint64_t lookups = 0;
+        uint64_t hits = 0;
+        uint64_t stores = 0;
+
+        double hitRate() const { return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups); }
+    };
+
+    // Contadores de reglas del hilo al empezar a analizar una linea (ver
+    // TranspilerStats::activeRules). Sin medicion no copia nada
+    class RuleMark {
+    private:
+        friend class LineMemo;
+
+        uint64_t* rules;
+        std::array<uint64_t, stats_rule_count> before{};
+        uint64_t conflicts = 0;
+
+    public:
+        RuleMark();
+    };
+
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        MemoPass pass = MemoPass::Define;
+        bool has_newline = false;
+        bool used = false;
+
+        // Verdadero si 'rules' se conto: sin medicion no se cuenta nada
+        bool counted = false;
+        std::array<uint8_t, stats_rule_count> rules{};
+        LexState end_state;
+
+        std::string line;
+        std::string output;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unique_ptr<Slot[]> slots;
+
+        std::atomic<uint64_t> lookups{ 0 };
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> stores{ 0 };
+    };
+
+    size_t slots_per_shard;
+    std::array<Shard, shard_count> shards;
+
+public:
+    explicit LineMemo(size_t slots_per_shard = default_slots_per_shard);
+
+    // Tabla del proceso, compartida por todos los pipelines
+    static LineMemo& shared();
+
+    // Si hay una entrada para la linea agrega su salida a 'out', deja en 'state' el
+    // estado final del lexer y devuelve true. Mientras se miden estadisticas una
+    // entrada guardada sin contar sus reglas no sirve
+    bool lookup(MemoPass pass, std::string_view line, bool has_newline, std::string& out, LexState& state);
+
+    // 'output' es lo que la etapa agrego para la linea y 'end_state' el estado del
+    // lexer al terminarla; 'mark' se tomo antes de analizarla
+    void store(MemoPass pass, std::string_view line, bool has_newline, std::string_view output,
+        const LexState& end_state, const RuleMark& mark);
+
+    Stats stats() const;
+
+    void printSummary(std::ostream& out) const;
+
+private:
+    static uint64_t hashLine(MemoPass pass, std::string_view line, bool has_newline) {
+        return hashBytes(line, static_cast<uint64_t>(pass) * 2 + (has_newline ? 1 : 0));
+    }
+};
+
+
+inline LineMemo::RuleMark::RuleMark()
+    : rules(TranspilerStats::activeRules())
+{
+    if (rules == nullptr) return;
+
+    std::copy(rules, rules + stats_rule_count, before.begin());
+    conflicts = EditList::conflicts();
+}
+
+inline LineMemo::LineMemo(size_t slots)
+    : slots_per_shard(slots)
+{
+    for (auto& shard : shards) {
+        shard.slots = std::make_unique<Slot[]>(slots_per_shard);
+    }
+}
+
+inline LineMemo& LineMemo::shared()
+{
+    static LineMemo memo;
+    return memo;
+}
+
+inline bool LineMemo::lookup(MemoPass pass, std::string_view line, bool has_newline, std::string& out,
+    LexState& state)
+{
+    if (line.size() > max_line_size) return false;
+
+    uint64_t hash = hashLine(pass, line, has_newline);
+    Shard& shard = shards[hash % shard_count];
+    shard.lookups.fetch_add(1, std::memory_order_relaxed);
+
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    const Slot& slot = shard.slots[(hash / shard_count) % slots_per_shard];
+    if (!slot.used || slot.hash != hash || slot.pass != pass || slot.has_newline != has_newline || slot.line != line) {
+        return false;
+    }
+
+    uint64_t* rules = TranspilerStats::activeRules();
+    if (rules != nullptr) {
+        if (!slot.counted) return false;
+        for (size_t i = 0; i < stats_rule_count; ++i) rules[i] += slot.rules[i];
+    }
+
+    out += slot.output;
+    state = slot.end_state;
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+inline void LineMemo::store(MemoPass pass, std::string_view line, bool has_newline, std::string_view output,
+    const LexState& end_state, const RuleMark& mark)
+{
+    if (line.size() > max_line_size || output.size() > max_output_size) return;
+
+    // Las lineas con reemplazos rechazados se vuelven a analizar para contarlos
+    std::array<uint8_t, stats_rule_count> rules{};
+    if (mark.rules != nullptr) {
+        if (EditList::conflicts() != mark.conflicts) return;
+        for (size_t i = 0; i < stats_rule_count; ++i) {
+            uint64_t matches = mark.rules[i] - mark.before[i];
+            if (matches > UINT8_MAX) return;
+            rules[i] = static_cast<uint8_t>(matches);
+        }
+    }
+
+    uint64_t hash = hashLine(pass, line, has_newline);
+    Shard& shard = shards[hash % shard_count];
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    Slot& slot = shard.slots[(hash / shard_count) % slots_per_shard];
+
+    slot.hash = hash;
+    slot.pass = pass;
+    slot.has_newline = has_newline;
+    slot.used = true;
+    slot.counted = mark.rules != nullptr;
+    slot.rules = rules;
+    slot.end_state = end_state;
+    slot.line.assign(line);
+    slot.output.assign(output);
+
+    shard.stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline LineMemo::Stats LineMemo::stats() const
+{
+    Stats total;
+    for (const auto& shard : shards) {
+        total.lookups += shard.lookups.load(std::memory_order_relaxed);
+        total.hits += shard.hits.load(std::memory_order_relaxed);
+        total.stores += shard.stores.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+inline void LineMemo::printSummary(std::ostream& out) const
+{
+    Stats total = stats();
+    out << std::fixed << std::setprecision(1)
+        << "Memoria de lineas: " << total.hits << " aciertos en " << total.lookups << " consultas ("
+        << total.hitRate() * 100.0 << "%), " << total.stores << " lineas guardadas\n";
+}
@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Archivo de entrada proyectado en memoria de solo lectura: el contenido se lee
+// como std::string_view sin copiarlo. Un archivo vacio se abre sin proyeccion, y
+// lo que no se puede proyectar (una tuberia, /dev/stdin, <(...)) se lee completo
+// en un buffer.
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+
+    // Contenido leido sin proyeccion; vacio si 'data' apunta a una proyeccion
+    std::string buffered;
+
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Devuelve false si el archivo no existe, es un directorio o no se puede leer
+    bool open(const std::string& path);
+
+    void close();
+
+    bool is_open() const { return opened; }
+
+    std::string_view view() const { return std::string_view(data, size); }
+
+private:
+    // Lee completa una entrada que no se puede proyectar
+#if defined(_WIN32)
+    bool openBuffered();
+#else
+    bool openBuffered(int fd);
+#endif
+};
+
+// Escribe las partes en 'path' (truncandolo) con una sola llamada writev/WriteFile
+// mientras el sistema acepte todo; devuelve false si falla
+bool writeFile(const std::string& path, std::initializer_list<std::string_view> parts);
+
+inline bool writeFile(const std::string& path, std::string_view content)
+{
+    return writeFile(path, { content });
+}
+
+
+#if defined(_WIN32)
+
+inline bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    if (GetFileType(file) != FILE_TYPE_DISK) return openBuffered();
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        close();
+        return false;
+    }
+
+    size = static_cast<size_t>(file_size.QuadPart);
+    opened = true;
+    if (size == 0) return true;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+        data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    if (data == nullptr) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+inline bool MappedFile::openBuffered()
+{
+    char chunk[64 * 1024];
+    for (;;) {
+        DWORD received = 0;
+        if (!ReadFile(file, chunk, sizeof(chunk), &received, nullptr)) {
+            // Una tuberia cuyo extremo de escritura se cerro termina asi
+            if (GetLastError() == ERROR_BROKEN_PIPE) break;
+            close();
+            return false;
+        }
+        if (received == 0) break;
+        buffered.append(chunk, received);
+    }
+
+    CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+
+    data = buffered.empty() ? nullptr : buffered.data();
+    size = buffered.size();
+    opened = true;
+    return true;
+}
+
+inline void MappedFile::close()
+{
+    if (data != nullptr && buffered.empty()) UnmapViewOfFile(data);
+    if (mapping != nullptr) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+    data = nullptr;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+    size = 0;
+    opened = false;
+    std::string().swap(buffered);
+}
+
+inline bool writeFile(const std::string& path, std::initializer_list<std::string_view> parts)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    bool ok = true;
+    for (std::string_view part : parts) {
+        while (ok && !part.empty()) {
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(part.size(), 1u << 30));
+            DWORD written = 0;
+            ok = WriteFile(file, part.data(), chunk, &written, nullptr) != 0;
+            part.remove_prefix(written);
+        }
+    }
+
+    return CloseHandle(file) != 0 && ok;
+}
+
+#else
+
+inline bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || S_ISDIR(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    if (!S_ISREG(info.st_mode)) {
+        bool ok = openBuffered(fd);
+        ::close(fd);
+        return ok;
+    }
+
+    size = static_cast<size_t>(info.st_size);
+    if (size > 0) {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            size = 0;
+            return false;
+        }
+
+        // La entrada se recorre una sola vez de principio a fin
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+
+    // La proyeccion sigue siendo valida sin el descriptor
+    ::close(fd);
+    opened = true;
+
+    return true;
+}
+
+inline bool MappedFile::openBuffered(int fd)
+{
+    char chunk[64 * 1024];
+    for (;;) {
+        ssize_t received = ::read(fd, chunk, sizeof(chunk));
+        if (received == 0) break;
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            close();
+            return false;
+        }
+        buffered.append(chunk, static_cast<size_t>(received));
+    }
+
+    data = buffered.empty() ? nullptr : buffered.data();
+    size = buffered.size();
+    opened = true;
+    return true;
+}
+
+inline void MappedFile::close()
+{
+    if (data != nullptr && buffered.empty()) {
+        munmap(const_cast<char*>(data), size);
+    }
+
+    data = nullptr;
+    size = 0;
+    opened = false;
+    std::string().swap(buffered);
+}
+
+inline bool writeFile(const std::string& path, std::initializer_list<std::string_view> parts)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    std::vector<iovec> buffers;
+    for (std::string_view part : parts) {
+        if (!part.empty()) {
+            buffers.push_back(iovec{ const_cast<char*>(part.data()), part.size() });
+        }
+    }
+
+    // Normalmente basta una llamada; si el sistema escribe menos, se continua
+    // desde el primer byte pendiente
+    size_t first = 0;
+    bool ok = true;
+    while (ok && first < buffers.size()) {
+        ssize_t written = writev(fd, buffers.data() + first, static_cast<int>(std::min<size_t>(buffers.size() - first, IOV_MAX)));
+        if (written < 0) {
+            ok = errno == EINTR;
+            continue;
+        }
+
+        auto remaining = static_cast<size_t>(written);
+        while (first < buffers.size() && remaining >= buffers[first].iov_len) {
+            remaining -= buffers[first].iov_len;
+            ++first;
+        }
+        if (remaining > 0) {
+            buffers[first].iov_base = static_cast<char*>(buffers[first].iov_base) + remaining;
+            buffers[first].iov_len -= remaining;
+        }
+    }
+
+    return ::close(fd) == 0 && ok;
+}
+
+#endif
@@ -1,118 +1,152 @@
 #pragma once
-#include <regex>
 #include <string>
 #include <sstream>
-
+#include "CLexer.hpp"
+#include "KeywordPrefilter.hpp"
+#include "LineMemo.hpp"
+#include "PatternMatchers.hpp"
+#include "SourceLines.hpp"
+#include "TranspilerStats.hpp"
+
+// Las reglas no cambian durante un recorrido: el estado vive en un Context, y un
+// mismo NullTranspiler puede usarse desde varios hilos a la vez
 class NullTranspiler {
-
-    struct StringRegion {
-        size_t start;
-        size_t length;
-
-        StringRegion(size_t s, size_t l) : start(s), length(l) {}
+public:
+    // Estado de un recorrido
+    struct Context {
+        // Estado del lexer entre lineas del archivo en curso
+        LexState lex_state;
+        std::vector<Token> line_tokens;
+        std::vector<ProtectedRegion> protected_regions;
+
+        // Memoria de lineas ya convertidas (opcional, puede compartirse entre hilos)
+        LineMemo* memo = nullptr;
+
+        // Verdadero si ningun estado pasa de la ultima linea procesada a la siguiente
+        bool idle() const { return lex_state == LexState{}; }
     };
 
 private:
-    // Expresion regular para capturar NULL como palabra completa
-    // Evita reemplazar NULL dentro de strings o como parte de otras palabras
-    std::regex null_pattern{
-        R"(\bNULL\b)"
-    };
+    // Lexer compartido: los literales y comentarios se detectan una sola vez por archivo
+    CLexer lexer;
 
-    // Expresion regular para detectar strings literales (para evitar reemplazar NULL dentro de ellos)
-    std::regex string_literal_pattern{
-        R"("([^"\\]|\\.)*")"
-    };
+public:
+    std::string transpileFile(std::string_view content) const;
 
-    // Expresion regular para detectar comentarios de linea
-    std::regex line_comment_pattern{
-        R"(//.*$)"
-    };
+    // Procesamiento linea a linea para el pipeline fusionado
+    void beginStream(Context& context) const;
 
-    // Expresion regular para detectar comentarios de bloque
-    std::regex block_comment_pattern{
-        R"(/\*.*?\*/)"
-    };
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const;
 
-public:
-    std::string transpileFile(const std::string& content);
+    // 'triggers' son los bits de KeywordPrefilter ya calculados para la linea
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
+
+    void endStream(Context& context, std::string& out) const;
 
 private:
-    std::string transpileNullStatements(const std::string& content);
+    std::string transpileNullStatements(std::string_view content) const;
 
-    std::string processNullLine(const std::string& line);
+    std::string processNullLine(const std::string& line, const std::vector<ProtectedRegion>& protected_regions) const;
 
-    bool containsStringLiteralOrComment(const std::string& line);
+    std::string processLineWithLiterals(const std::string& line, const std::vector<ProtectedRegion>& protected_regions) const;
 
-    std::string processLineWithLiterals(const std::string& line);
+    // Reemplaza NULL como palabra completa (NullPattern); evita tocar
+    // NULL como parte de otras palabras
+    void replaceNull(std::string_view segment, std::string& out) const;
 
-    std::vector<NullTranspiler::StringRegion> findProtectedRegions(const std::string& line);
+    void findProtectedRegions(const std::vector<Token>& tokens, size_t line_length,
+        std::vector<ProtectedRegion>& protected_regions) const;
 
-    std::string trim(const std::string& str);
+    std::string trim(const std::string& str) const;
 };
 
 
 
-std::string NullTranspiler::transpileFile(const std::string& content) {
-    std::string result = content;
-
-    result = transpileNullStatements(result);
-
-    return result;
+inline std::string NullTranspiler::transpileFile(std::string_view content) const {
+    return transpileNullStatements(content);
 }
 
-std::string NullTranspiler::transpileNullStatements(const std::string& content)
+inline std::string NullTranspiler::transpileNullStatements(std::string_view content) const
 {
-    std::istringstream iss(content);
-    std::string line;
     std::string processed_content;
+    processed_content.reserve(content.size() + content.size() / 16);
 
-    while (std::getline(iss, line)) {
-        std::string processed_line = processNullLine(line);
-        processed_content += processed_line + "\n";
-    }
+    Context context;
+    beginStream(context);
+    KeywordPrefilter::shared().forEachLine(content, [&](std::string_view line, bool has_newline, unsigned triggers) {
+        transpileLine(context, line, has_newline, processed_content, triggers);
+    });
+    endStream(context, processed_content);
 
     return processed_content;
 }
 
-std::string NullTranspiler::processNullLine(const std::string& line)
+inline void NullTranspiler::beginStream(Context& context) const
 {
-    if (containsStringLiteralOrComment(line)) {
-        return processLineWithLiterals(line);
-    }
+    context.lex_state = LexState{};
+}
 
-    return std::regex_replace(line, null_pattern, "nullptr");
+inline void NullTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const
+{
+    transpileLine(context, line, has_newline, out, KeywordPrefilter::shared().scan(line));
 }
 
-bool NullTranspiler::containsStringLiteralOrComment(const std::string& line)
+inline void NullTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+    unsigned triggers) const
 {
-    std::smatch match;
+    // Sin "NULL" en la linea solo hace falta mantener el estado del lexer
+    if ((triggers & trigger_null) == 0) {
+        lexer.skipLine(line, has_newline, context.lex_state, (triggers & trigger_lexer) == 0);
+        out.append(line);
+        out += '\n';
+        return;
+    }
 
-    if (std::regex_search(line, match, string_literal_pattern)) {
-        return true;
+    // Desde el estado inicial del lexer el resultado depende solo de la linea
+    bool memoizable = context.memo != nullptr && context.lex_state == LexState{};
+    if (memoizable && context.memo->lookup(MemoPass::Null, line, has_newline, out, context.lex_state)) {
+        return;
     }
+    size_t output_start = out.size();
+    LineMemo::RuleMark rules;
+
+    context.line_tokens.clear();
+    lexer.tokenizeLine(line, has_newline, context.lex_state, context.line_tokens);
+    findProtectedRegions(context.line_tokens, line.size(), context.protected_regions);
 
-    if (std::regex_search(line, match, line_comment_pattern) ||
-        std::regex_search(line, match, block_comment_pattern)) {
-        return true;
+    out += processNullLine(std::string(line), context.protected_regions);
+    out += '\n';
+
+    if (memoizable) {
+        context.memo->store(MemoPass::Null, line, has_newline, std::string_view(out).substr(output_start),
+            context.lex_state, rules);
     }
+}
 
-    return false;
+inline void NullTranspiler::endStream(Context&, std::string&) const
+{
 }
 
-std::string NullTranspiler::processLineWithLiterals(const std::string& line)
+inline std::string NullTranspiler::processNullLine(const std::string& line, const std::vector<ProtectedRegion>& protected_regions) const
 {
-    std::string result = line;
-    std::vector<NullTranspiler::StringRegion> protected_regions = findProtectedRegions(line);
+    if (!protected_regions.empty()) {
+        return processLineWithLiterals(line, protected_regions);
+    }
+
+    std::string processed_line;
+    replaceNull(line, processed_line);
+    return processed_line;
+}
 
+inline std::string NullTranspiler::processLineWithLiterals(const std::string& line, const std::vector<ProtectedRegion>& protected_regions) const
+{
     std::string processed_line;
     size_t last_pos = 0;
 
     for (const auto& region : protected_regions) {
         if (region.start > last_pos) {
-            std::string segment = line.substr(last_pos, region.start - last_pos);
-            segment = std::regex_replace(segment, null_pattern, "nullptr");
-            processed_line += segment;
+            replaceNull(std::string_view(line).substr(last_pos, region.start - last_pos), processed_line);
         }
 
         processed_line += line.substr(region.start, region.length);
@@ -120,51 +154,35 @@ std::string NullTranspiler::processLineWithLiterals(const std::string& line)
     }
 
     if (last_pos < line.length()) {
-        std::string segment = line.substr(last_pos);
-        segment = std::regex_replace(segment, null_pattern, "nullptr");
-        processed_line += segment;
+        replaceNull(std::string_view(line).substr(last_pos), processed_line);
     }
 
     return processed_line;
 }
 
-std::vector<NullTranspiler::StringRegion> NullTranspiler::findProtectedRegions(const std::string& line)
+inline void NullTranspiler::replaceNull(std::string_view segment, std::string& out) const
 {
-    std::vector<StringRegion> regions;
+    size_t copied = 0;
 
-    std::sregex_iterator string_iter(line.begin(), line.end(), string_literal_pattern);
-    std::sregex_iterator string_end;
+    forEachPatternMatch<NullPattern>(segment, [&](const PatternMatch& match) {
+        out.append(segment.substr(copied, match.position - copied));
+        out += "nullptr";
+        copied = match.end();
+        TranspilerStats::countRule(StatsRule::NullPointer);
+    });
 
-    for (; string_iter != string_end; ++string_iter) {
-        const std::smatch& match = *string_iter;
-        regions.emplace_back(match.position(), match.length());
-    }
-
-    std::sregex_iterator comment_iter(line.begin(), line.end(), line_comment_pattern);
-    std::sregex_iterator comment_end;
-
-    for (; comment_iter != comment_end; ++comment_iter) {
-        const std::smatch& match = *comment_iter;
-        regions.emplace_back(match.position(), match.length());
-    }
-
-    std::sregex_iterator block_iter(line.begin(), line.end(), block_comment_pattern);
-    std::sregex_iterator block_end;
-
-    for (; block_iter != block_end; ++block_iter) {
-        const std::smatch& match = *block_iter;
-        regions.emplace_back(match.position(), match.length());
-    }
-
-    std::sort(regions.begin(), regions.end(),
-        [](const NullTranspiler::StringRegion& a, const NullTranspiler::StringRegion& b) {
-            return a.start < b.start;
-        });
+    out.append(segment.substr(copied));
+}
 
-    return regions;
+inline void NullTranspiler::findProtectedRegions(const std::vector<Token>& tokens, size_t line_length,
+    std::vector<ProtectedRegion>& protected_regions) const
+{
+    size_t cursor = 0;
+    CLexer::collectProtectedRegions(tokens, cursor, 0, line_length,
+        CLexer::protect_strings_and_comments, protected_regions);
 }
 
-std::string NullTranspiler::trim(const std::string& str) {
+inline std::string NullTranspiler::trim(const std::string& str) const {
     size_t start = str.find_first_not_of(" \t\r\n");
     if (start == std::string::npos) return "";
 
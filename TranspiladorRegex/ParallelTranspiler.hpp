@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CLexer.hpp"
+#include "TopLevelSplitter.hpp"
+#include "TranspilerPipeline.hpp"
+#include "WorkStealingPool.hpp"
+
+// Transpila un solo archivo grande en paralelo. Un recorrido previo de solo
+// lectura divide el archivo en tramos que empiezan en un limite de nivel superior
+// (fuera de funciones, comentarios y directivas), ubica las lineas con "char" y
+// decide los includes con el archivo completo. Luego se reunen en paralelo las
+// variables que esas lineas convierten a std::string, que son el unico estado que
+// cruza tramos. Cada tramo pasa por el pipeline fusionado en su propio hilo con
+// ese estado compartido de solo lectura, y las salidas se concatenan en orden.
+//
+// Si una variable que consulto un tramo no coincide con las que declaran los
+// tramos, ese tramo se repite con las reales. Si algun tramo no termina limpio
+// (p. ej. un printf a medias), el archivo se procesa entero en un solo hilo.
+class ParallelTranspiler {
+private:
+    // Por debajo de este tamano el archivo se procesa en un solo hilo
+    static constexpr size_t min_parallel_size = size_t{ 1 } << 20;
+    static constexpr size_t min_section_size = size_t{ 256 } << 10;
+
+    // Tramos por hilo, para que el robo de trabajo compense tramos mas lentos
+    static constexpr size_t sections_per_worker = 8;
+
+    PipelineMode mode;
+    WorkStealingPool pool;
+    std::vector<TranspilerPipeline> pipelines;
+
+    CLexer lexer;
+    TopLevelSplitter splitter;
+
+    TraceWriter* trace;
+
+public:
+    // Con 'instrumentation' cada pipeline registra sus tramos (ver TranspilerPipeline::instrument)
+    explicit ParallelTranspiler(PipelineMode mode = PipelineMode::Fused, size_t workers = 0,
+        const Instrumentation& instrumentation = {});
+
+    // Misma salida que TranspilerPipeline::transpile(content, mode)
+    std::string transpile(std::string_view content);
+};
+
+
+inline ParallelTranspiler::ParallelTranspiler(PipelineMode mode, size_t workers, const Instrumentation& instrumentation)
+    : mode(mode), pool(workers), pipelines(pool.size()), trace(instrumentation.trace)
+{
+    if (instrumentation.enabled()) {
+        for (auto& pipeline : pipelines) pipeline.instrument(instrumentation);
+    }
+}
+
+inline std::string ParallelTranspiler::transpile(std::string_view content)
+{
+    if (mode != PipelineMode::Fused || pool.size() == 1 || content.size() < min_parallel_size) {
+        return pipelines[0].transpile(content, mode);
+    }
+
+    auto split_start = TraceWriter::Clock::now();
+    std::vector<std::string_view> declaration_lines;
+    size_t target_size = std::max(min_section_size, content.size() / (pool.size() * sections_per_worker));
+    std::vector<std::string_view> sections = splitter.split(content, target_size, declaration_lines);
+    if (trace) {
+        trace->complete("division", "paralelo", split_start, TraceWriter::Clock::now(),
+            "\"tramos\":" + std::to_string(sections.size()));
+    }
+    if (sections.size() < 2) {
+        return pipelines[0].transpile(content, mode);
+    }
+
+    // Solo el tramo de la primera directiva inserta las nuevas (el primero si no hay ninguna)
+    TranspilerPipeline::IncludePlan includes = pipelines[0].planIncludes(content);
+    size_t first_include = lexer.findFirstIncludeLine(content);
+    size_t include_section = 0;
+    if (first_include != std::string_view::npos) {
+        while (include_section + 1 < sections.size() &&
+            static_cast<size_t>(sections[include_section + 1].data() - content.data()) <= first_include) {
+            ++include_section;
+        }
+    }
+
+    std::vector<size_t> order(sections.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+
+    // Las lineas con declaraciones se reparten en el mismo numero de grupos que los tramos
+    size_t group_size = declaration_lines.size() / sections.size() + 1;
+    std::vector<std::set<std::string>> group_declarations(sections.size());
+    pool.run(order, [&](size_t worker, size_t group) {
+        auto group_start = TraceWriter::Clock::now();
+        size_t end = std::min(declaration_lines.size(), (group + 1) * group_size);
+        for (size_t i = group * group_size; i < end; ++i) {
+            std::string_view line = declaration_lines[i];
+            bool has_newline = line.data() + line.size() < content.data() + content.size();
+            pipelines[worker].collectDeclarations(line, has_newline, group_declarations[group]);
+        }
+        if (trace) trace->complete("declaraciones", "paralelo", group_start, TraceWriter::Clock::now());
+    });
+
+    std::set<std::string> declared_strings;
+    for (const auto& declarations : group_declarations) {
+        declared_strings.insert(declarations.begin(), declarations.end());
+    }
+
+    std::vector<TranspilerPipeline::SectionResult> results(sections.size());
+    auto run_sections = [&](const std::vector<size_t>& indices) {
+        pool.run(indices, [&](size_t worker, size_t index) {
+            results[index] = pipelines[worker].transpileSection(sections[index],
+                index == include_section ? includes : TranspilerPipeline::IncludePlan{}, declared_strings);
+        });
+    };
+
+    run_sections(order);
+
+    std::set<std::string> actual_declarations;
+    for (const auto& result : results) {
+        actual_declarations.insert(result.declared_strings.begin(), result.declared_strings.end());
+    }
+
+    // Se repiten, con las declaraciones reales, los tramos que consultaron una
+    // variable que el recorrido previo clasifico mal
+    if (actual_declarations != declared_strings) {
+        std::vector<size_t> mismatched;
+        for (size_t i = 0; i < results.size(); ++i) {
+            for (const auto& name : results[i].string_lookups) {
+                if (actual_declarations.count(name) != declared_strings.count(name)) {
+                    mismatched.push_back(i);
+                    break;
+                }
+            }
+        }
+
+        declared_strings.swap(actual_declarations);
+        run_sections(mismatched);
+    }
+
+    std::array<bool, TranspilerPipeline::stage_count> needle_found{};
+    size_t total_size = 0;
+    bool sections_valid = true;
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        for (size_t stage = 0; stage < needle_found.size(); ++stage) {
+            needle_found[stage] = needle_found[stage] || results[i].needle_found[stage];
+        }
+        total_size += results[i].output.size();
+
+        // El ultimo tramo puede terminar con estado: no hay texto despues
+        if (i + 1 < results.size() && !results[i].ends_idle) {
+            sections_valid = false;
+        }
+    }
+
+    if (!sections_valid || needle_found != TranspilerPipeline::expectedNeedles(includes)) {
+        return pipelines[0].transpile(content, mode);
+    }
+
+    std::string output;
+    output.reserve(total_size);
+    for (auto& result : results) {
+        output += result.output;
+        result.output = std::string();
+    }
+
+    return output;
+}
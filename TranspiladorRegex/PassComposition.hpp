@@ -0,0 +1,162 @@
+#pragma once
+#include <concepts>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "TranspilerPipeline.hpp"
+
+// Interfaz que comparten las cinco etapas: transpilan un archivo completo sin
+// modificar sus reglas
+template <typename Pass>
+concept TranspilerPass = requires(const Pass& pass, std::string_view input) {
+    { pass.transpileFile(input) } -> std::convertible_to<std::string>;
+};
+
+// Una etapa que ademas sabe si puede omitirse sobre su entrada (ver
+// TranspilerPipeline::skipPass)
+template <typename Pass>
+concept SkippablePass = TranspilerPass<Pass> && requires(const Pass& pass, std::string_view input) {
+    { pass.skip(input) } -> std::same_as<TranspilerPipeline::Skip>;
+};
+
+static_assert(TranspilerPass<DefineTranspiler> && TranspilerPass<NullTranspiler> && TranspilerPass<ArrayTranspiler> &&
+    TranspilerPass<StringTranspiler> && TranspilerPass<PrintfTranspiler>);
+
+// Etapa vacia: ocupa un lugar en StaticPipeline y no genera codigo
+struct EmptyPass {
+    std::string transpileFile(std::string_view input) const { return std::string(input); }
+};
+
+template <typename Pass>
+inline constexpr bool is_empty_pass = std::is_same_v<std::remove_cvref_t<Pass>, EmptyPass>;
+
+// Una etapa del pipeline con el criterio de TranspilerPipeline para omitirla
+template <size_t Stage, TranspilerPass Transpiler>
+class PipelineStage {
+private:
+    const Transpiler& transpiler;
+
+public:
+    static constexpr bool ends_last_line = Stage + 1 < TranspilerPipeline::stage_count;
+
+    explicit PipelineStage(const Transpiler& transpiler) : transpiler(transpiler) {}
+
+    std::string transpileFile(std::string_view input) const { return transpiler.transpileFile(input); }
+
+    TranspilerPipeline::Skip skip(std::string_view input) const
+    {
+        return TranspilerPipeline::skipPass(input, TranspilerPipeline::stage_triggers[Stage],
+            TranspilerPipeline::include_needles[Stage], ends_last_line);
+    }
+};
+
+// Aplica 'pass' a 'text'. Es la pieza comun de StaticPipeline y DynamicPipeline, y
+// por lo tanto de PassPlan::run
+template <TranspilerPass Pass>
+void applyPass(const Pass& pass, std::string& text)
+{
+    if constexpr (is_empty_pass<Pass>) {
+        return;
+    }
+    else {
+        if constexpr (SkippablePass<Pass>) {
+            TranspilerPipeline::Skip skip = pass.skip(text);
+            if (skip == TranspilerPipeline::Skip::EndLastLine) text += '\n';
+            if (skip != TranspilerPipeline::Skip::No) return;
+        }
+        text = pass.transpileFile(text);
+    }
+}
+
+// Composicion fija en compilacion: cada etapa se llama sin indireccion, de modo que
+// el compilador puede expandir applyPass y las llamadas de una etapa a la siguiente,
+// y las EmptyPass desaparecen
+template <TranspilerPass... Passes>
+class StaticPipeline {
+private:
+    std::tuple<Passes...> passes;
+
+public:
+    static constexpr size_t size = (0 + ... + (is_empty_pass<Passes> ? 0 : 1));
+
+    explicit StaticPipeline(Passes... passes) : passes(std::move(passes)...) {}
+
+    std::string transpile(std::string_view content) const;
+};
+
+// Composicion elegida al ejecutar, con las mismas piezas: cada
+// etapa queda detras de una std::function
+class DynamicPipeline {
+private:
+    std::vector<std::function<void(std::string&)>> passes;
+
+public:
+    template <TranspilerPass Pass>
+    void add(Pass pass);
+
+    size_t size() const { return passes.size(); }
+
+    std::string transpile(std::string_view content) const;
+};
+
+using StandardStaticPipeline = StaticPipeline<
+    PipelineStage<0, DefineTranspiler>,
+    PipelineStage<1, NullTranspiler>,
+    PipelineStage<2, ArrayTranspiler>,
+    PipelineStage<3, StringTranspiler>,
+    PipelineStage<4, PrintfTranspiler>>;
+
+// Las cinco etapas en su orden; equivale a TranspilerPipeline en modo secuencial
+StandardStaticPipeline standardStaticPipeline(const TranspilerRules& rules = TranspilerRules::shared());
+
+// Las etapas de 'passes' (bits PipelinePass) en su orden; equivale a transpilePasses
+DynamicPipeline standardDynamicPipeline(unsigned passes, const TranspilerRules& rules = TranspilerRules::shared());
+
+
+template <TranspilerPass... Passes>
+std::string StaticPipeline<Passes...>::transpile(std::string_view content) const
+{
+    std::string text(content);
+    std::apply([&](const auto&... pass) { (applyPass(pass, text), ...); }, passes);
+    return text;
+}
+
+template <TranspilerPass Pass>
+void DynamicPipeline::add(Pass pass)
+{
+    if constexpr (!is_empty_pass<Pass>) {
+        passes.emplace_back([pass = std::move(pass)](std::string& text) { applyPass(pass, text); });
+    }
+}
+
+inline std::string DynamicPipeline::transpile(std::string_view content) const
+{
+    std::string text(content);
+    for (const auto& pass : passes) pass(text);
+    return text;
+}
+
+inline StandardStaticPipeline standardStaticPipeline(const TranspilerRules& rules)
+{
+    return StandardStaticPipeline(
+        PipelineStage<0, DefineTranspiler>(rules.defineTranspiler),
+        PipelineStage<1, NullTranspiler>(rules.nullTranspiler),
+        PipelineStage<2, ArrayTranspiler>(rules.arrayTranspiler),
+        PipelineStage<3, StringTranspiler>(rules.stringTranspiler),
+        PipelineStage<4, PrintfTranspiler>(rules.printfTranspiler));
+}
+
+inline DynamicPipeline standardDynamicPipeline(unsigned passes, const TranspilerRules& rules)
+{
+    DynamicPipeline pipeline;
+    if (passes & pass_define) pipeline.add(PipelineStage<0, DefineTranspiler>(rules.defineTranspiler));
+    if (passes & pass_null) pipeline.add(PipelineStage<1, NullTranspiler>(rules.nullTranspiler));
+    if (passes & pass_array) pipeline.add(PipelineStage<2, ArrayTranspiler>(rules.arrayTranspiler));
+    if (passes & pass_string) pipeline.add(PipelineStage<3, StringTranspiler>(rules.stringTranspiler));
+    if (passes & pass_printf) pipeline.add(PipelineStage<4, PrintfTranspiler>(rules.printfTranspiler));
+    return pipeline;
+}
@@ -0,0 +1,336 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "PassComposition.hpp"
+#include "TranspilerPipeline.hpp"
+#include "TranspilerStats.hpp"
+
+// Un pase del transpilador tal como lo describe el registro
+struct PassInfo {
+    std::string name;
+
+    // Palabras que el pase necesita encontrar en su entrada para cambiarla; vacio si
+    // se aplica siempre
+    std::vector<std::string> triggers;
+
+    // Directiva que el pase agrega si su entrada no la tiene
+    std::string inserted_include;
+
+    // Pases que se activan junto con este
+    std::vector<std::string> dependencies;
+
+    // Pases que, si estan activos, se aplican antes que este
+    std::vector<std::string> after;
+
+    // Pases que, si estan activos, se aplican despues de este
+    std::vector<std::string> before;
+
+    // false si "all" no lo incluye y solo se aplica pidiendolo por nombre
+    bool in_all = true;
+
+    // Si el pase termina con '\n' una ultima linea que no lo tiene, como las etapas
+    // intermedias del pipeline. Al omitirlo se hace lo mismo
+    bool ends_last_line = false;
+
+    // Bit PipelinePass de las etapas del pipeline; 0 en los pases registrados desde fuera
+    unsigned stage_bit = 0;
+
+    // Aplica el pase a un archivo completo. PassPlan lo omite si no cambiaria su
+    // entrada (ver TranspilerPipeline::skipPass)
+    std::function<std::string(TranspilerPipeline&, std::string_view)> run;
+};
+
+// Pases activos en el orden en que se aplican
+class PassPlan {
+private:
+    std::vector<PassInfo> passes;
+    bool complete = false;
+
+public:
+    PassPlan() = default;
+    PassPlan(std::vector<PassInfo> passes, bool complete) : passes(std::move(passes)), complete(complete) {}
+
+    const std::vector<PassInfo>& steps() const { return passes; }
+
+    // Bits PipelinePass de las etapas incluidas
+    unsigned stagePasses() const;
+
+    // Exactamente las cinco etapas del pipeline: se pueden aplicar en modo fusionado
+    // (y en paralelo, ver ParallelTranspiler)
+    bool isPipeline() const { return complete; }
+
+    // Aplica los pases uno tras otro en un DynamicPipeline, omitiendo los que no
+    // cambiarian su entrada; una etapa suelta se aplica con transpileStage, sin
+    // volver a decidir si hace falta. Las cinco etapas juntas usan transpile().
+    // 'skipped' recibe cuantos pases se omitieron aqui
+    std::string run(TranspilerPipeline& pipeline, std::string_view content, PipelineMode mode,
+        size_t* skipped = nullptr) const;
+
+    // "define,null,printf"
+    std::string names() const;
+};
+
+// Un pase del plan como etapa de DynamicPipeline; cuenta en 'skipped' los que omite
+class PlannedPass {
+private:
+    const PassInfo& info;
+    TranspilerPipeline& pipeline;
+    size_t* skipped;
+
+public:
+    PlannedPass(const PassInfo& info, TranspilerPipeline& pipeline, size_t* skipped)
+        : info(info), pipeline(pipeline), skipped(skipped) {}
+
+    std::string transpileFile(std::string_view input) const { return info.run(pipeline, input); }
+
+    TranspilerPipeline::Skip skip(std::string_view input) const;
+};
+
+// Catalogo de pases. Las cinco etapas del pipeline se registran al construirlo; un
+// pase nuevo se registra desde su propio .cpp con PassRegistration (ver StdboolPass.cpp),
+// que se agrega al ejecutable en CMakeLists.txt sin tocar Transpiler.cpp, y queda
+// disponible para --passes
+class PassRegistry {
+private:
+    mutable std::mutex mutex;
+    std::vector<PassInfo> passes;
+
+public:
+    PassRegistry();
+
+    static PassRegistry& shared();
+
+    // Lanza std::invalid_argument si falta el nombre o la funcion, o si el nombre ya existe
+    void add(PassInfo pass);
+
+    std::vector<PassInfo> list() const;
+
+    // Nombres separados por comas o "all" (los registrados con in_all). Agrega los pases
+    // requeridos y ordena segun 'after' y 'before' y, a igualdad, por orden de registro.
+    // Lanza std::invalid_argument si un nombre no existe o el orden es circular
+    PassPlan plan(std::string_view list) const;
+
+    void print(std::ostream& out) const;
+
+private:
+    size_t indexOf(std::string_view name) const;
+};
+
+// Registra un pase al iniciar el programa, desde cualquier .cpp del ejecutable (los
+// encabezados solo tienen definiciones inline, asi que pueden incluirse en varios):
+//   PassInfo miPase() { PassInfo pass; pass.name = "mi_pase"; pass.run = transpilar; return pass; }
+//   const PassRegistration registration{ miPase() };
+// El registro es un objeto estatico: el enlazador debe incluir su .cpp, por eso va
+// entre las fuentes del ejecutable y no en una biblioteca estatica
+struct PassRegistration {
+    explicit PassRegistration(PassInfo pass) { PassRegistry::shared().add(std::move(pass)); }
+};
+
+
+inline unsigned PassPlan::stagePasses() const
+{
+    unsigned bits = 0;
+    for (const auto& pass : passes) bits |= pass.stage_bit;
+    return bits;
+}
+
+inline std::string PassPlan::run(TranspilerPipeline& pipeline, std::string_view content, PipelineMode mode,
+    size_t* skipped) const
+{
+    if (skipped) *skipped = 0;
+    if (complete) {
+        return pipeline.transpile(content, mode);
+    }
+
+    DynamicPipeline steps;
+    for (const auto& pass : passes) steps.add(PlannedPass(pass, pipeline, skipped));
+    return steps.transpile(content);
+}
+
+inline TranspilerPipeline::Skip PlannedPass::skip(std::string_view input) const
+{
+    auto result = TranspilerPipeline::skipPass(input, info.triggers, info.inserted_include, info.ends_last_line);
+    if (result != TranspilerPipeline::Skip::No && skipped) ++*skipped;
+    return result;
+}
+
+inline std::string PassPlan::names() const
+{
+    std::string text;
+    for (const auto& pass : passes) {
+        if (!text.empty()) text += ',';
+        text += pass.name;
+    }
+    return text;
+}
+
+inline PassRegistry::PassRegistry()
+{
+    // Etapas del pipeline en su orden: cada una despues de la anterior
+    for (size_t stage = 0; stage < TranspilerPipeline::stage_count; ++stage) {
+        PassInfo pass;
+        pass.name = TranspilerStats::pass_names[stage];
+        for (std::string_view trigger : TranspilerPipeline::stage_triggers[stage]) {
+            if (!trigger.empty()) pass.triggers.emplace_back(trigger);
+        }
+        pass.inserted_include = TranspilerPipeline::include_needles[stage];
+        if (stage > 0) pass.after.emplace_back(TranspilerStats::pass_names[stage - 1]);
+        pass.ends_last_line = stage + 1 < TranspilerPipeline::stage_count;
+        pass.stage_bit = 1u << stage;
+        pass.run = [stage](TranspilerPipeline& pipeline, std::string_view input) {
+            return pipeline.transpileStage(stage, input);
+        };
+        passes.push_back(std::move(pass));
+    }
+}
+
+inline PassRegistry& PassRegistry::shared()
+{
+    static PassRegistry registry;
+    return registry;
+}
+
+inline void PassRegistry::add(PassInfo pass)
+{
+    if (pass.name.empty() || !pass.run) {
+        throw std::invalid_argument("Pase sin nombre o sin funcion");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (indexOf(pass.name) != passes.size()) {
+        throw std::invalid_argument("Pase registrado dos veces: " + pass.name);
+    }
+
+    // Los pases externos no son etapas del pipeline aunque declaren un bit
+    pass.stage_bit = 0;
+    passes.push_back(std::move(pass));
+}
+
+inline std::vector<PassInfo> PassRegistry::list() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return passes;
+}
+
+inline size_t PassRegistry::indexOf(std::string_view name) const
+{
+    for (size_t i = 0; i < passes.size(); ++i) {
+        if (passes[i].name == name) return i;
+    }
+    return passes.size();
+}
+
+inline PassPlan PassRegistry::plan(std::string_view list) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<bool> selected(passes.size(), false);
+
+    // Nombres pedidos; "all" equivale a todos
+    std::vector<size_t> pending;
+    for (;;) {
+        size_t comma = list.find(',');
+        std::string_view name = list.substr(0, comma);
+
+        size_t first = indexOf(name), last = first + 1;
+        if (name == "all") {
+            first = 0;
+            last = passes.size();
+        }
+        else if (first == passes.size()) {
+            throw std::invalid_argument("Pase desconocido: " + std::string(name));
+        }
+
+        for (size_t index = first; index < last; ++index) {
+            if (selected[index] || (name == "all" && !passes[index].in_all)) continue;
+            selected[index] = true;
+            pending.push_back(index);
+        }
+
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+
+    // Requeridos, transitivamente
+    while (!pending.empty()) {
+        size_t index = pending.back();
+        pending.pop_back();
+
+        for (const auto& name : passes[index].dependencies) {
+            size_t required = indexOf(name);
+            if (required == passes.size()) {
+                throw std::invalid_argument("El pase " + passes[index].name + " requiere uno desconocido: " + name);
+            }
+            if (!selected[required]) {
+                selected[required] = true;
+                pending.push_back(required);
+            }
+        }
+    }
+
+    // Orden topologico estable: en cada paso, el primer pase registrado cuyos
+    // predecesores activos ya estan en el plan
+    std::vector<PassInfo> ordered;
+    std::vector<bool> placed(passes.size(), false);
+    size_t remaining = std::count(selected.begin(), selected.end(), true);
+
+    while (ordered.size() < remaining) {
+        size_t next = passes.size();
+        for (size_t i = 0; i < passes.size() && next == passes.size(); ++i) {
+            if (!selected[i] || placed[i]) continue;
+
+            bool ready = std::all_of(passes[i].after.begin(), passes[i].after.end(), [&](const std::string& name) {
+                size_t before = indexOf(name);
+                return before == passes.size() || !selected[before] || placed[before];
+            });
+            for (size_t j = 0; ready && j < passes.size(); ++j) {
+                if (!selected[j] || placed[j] || j == i) continue;
+
+                const auto& later = passes[j].before;
+                ready = std::find(later.begin(), later.end(), passes[i].name) == later.end();
+            }
+            if (ready) next = i;
+        }
+
+        if (next == passes.size()) {
+            throw std::invalid_argument("Orden circular entre los pases pedidos");
+        }
+        placed[next] = true;
+        ordered.push_back(passes[next]);
+    }
+
+    bool complete = ordered.size() == TranspilerPipeline::stage_count;
+    for (size_t i = 0; complete && i < ordered.size(); ++i) {
+        complete = ordered[i].stage_bit == (1u << i);
+    }
+
+    return PassPlan(std::move(ordered), complete);
+}
+
+inline void PassRegistry::print(std::ostream& out) const
+{
+    for (const auto& pass : list()) {
+        out << pass.name << ":";
+        for (const auto& trigger : pass.triggers) out << " " << trigger;
+        if (!pass.inserted_include.empty()) out << " (agrega " << pass.inserted_include << ")";
+        if (!pass.after.empty()) {
+            out << " despues de";
+            for (const auto& name : pass.after) out << " " << name;
+        }
+        if (!pass.before.empty()) {
+            out << " antes de";
+            for (const auto& name : pass.before) out << " " << name;
+        }
+        if (!pass.dependencies.empty()) {
+            out << " requiere";
+            for (const auto& name : pass.dependencies) out << " " << name;
+        }
+        if (!pass.in_all) out << " (solo por nombre)";
+        out << "\n";
+    }
+}
@@ -0,0 +1,151 @@
+// Compara cada reconocedor de PatternMatchers.hpp con la expresion regular
+// std::regex que reemplaza: tiempo de compilacion de la expresion y tiempo por
+// busqueda sobre una linea representativa.
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+#include "PatternMatchers.hpp"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    // Evita que el compilador descarte los resultados
+    volatile size_t benchmark_sink = 0;
+
+    template <typename Operation>
+    double nanosecondsPerCall(size_t iterations, Operation&& operation)
+    {
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            benchmark_sink = benchmark_sink + operation();
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+        return elapsed.count() / static_cast<double>(iterations);
+    }
+
+    struct BenchmarkCase {
+        const char* name;
+        const char* expression;
+        std::string input;
+        size_t (*matcher)(const std::string&);
+        bool anchored;
+    };
+
+    template <typename Pattern>
+    size_t countMatches(const std::string& input)
+    {
+        size_t count = 0;
+        forEachPatternMatch<Pattern>(input, [&](const PatternMatch& match) { count += match.length; });
+        return count;
+    }
+
+    template <typename Pattern>
+    size_t matchFull(const std::string& input)
+    {
+        PatternMatch match;
+        return Pattern::matchFull(input, match) ? match.length : 0;
+    }
+
+    template <typename Pattern>
+    size_t matchAnchored(const std::string& input)
+    {
+        PatternMatch match;
+        return Pattern::matchAt(input, 0, match) ? match.length : 0;
+    }
+
+    size_t regexMatches(const std::regex& expression, const std::string& input, bool anchored)
+    {
+        if (anchored) {
+            std::smatch match;
+            return std::regex_match(input, match, expression) ? static_cast<size_t>(match.length()) : 0;
+        }
+
+        size_t count = 0;
+        for (std::sregex_iterator iter(input.begin(), input.end(), expression), end; iter != end; ++iter) {
+            count += iter->length();
+        }
+        return count;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 20000;
+
+    std::vector<BenchmarkCase> cases{
+        { "define funcion", R"(#define\s+([A-Za-z_][A-Za-z0-9_]*)\s*\(([^)]*)\)\s+(.+))",
+            "#define MAX(a, b) ((a) > (b) ? (a) : (b))", matchFull<DefineFunctionPattern>, true },
+        { "define sin valor", R"(#define\s+([A-Za-z_][A-Za-z0-9_]*)\s*$)",
+            "#define DEBUG_ENABLED   ", matchFull<DefineFlagPattern>, true },
+        { "define valor", R"(#define\s+([A-Za-z_][A-Za-z0-9_]*)\s+(.+))",
+            "#define BUFFER_SIZE 1024", matchFull<DefineValuePattern>, true },
+        { "NULL", R"(\bNULL\b)",
+            "if (ptr == NULL || next != NULL) { node->left = NULL; NULLABLE = 0; }", countMatches<NullPattern>, false },
+        { "arreglo simple", R"(([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\])",
+            "    int values[100]; double weights[32]; char *names[16];", countMatches<ArrayDeclarationPattern>, false },
+        { "arreglo inicializado", R"(([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\]\s*=\s*(\{[^}]*\}))",
+            "    int primes[5] = {2, 3, 5, 7, 11};", countMatches<InitializedArrayPattern>, false },
+        { "arreglo auto", R"(([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*\]\s*=\s*(\{[^}]*\}))",
+            "    double samples[] = {1.5, 2.5, 3.5, 4.5};", countMatches<AutoInitArrayPattern>, false },
+        { "arreglos multiples", R"(([A-Za-z_][A-Za-z0-9_]*\s+)([A-Za-z_][A-Za-z0-9_]*\s*\[\s*\d+\s*\](?:\s*,\s*[A-Za-z_][A-Za-z0-9_]*\s*\[\s*\d+\s*\])*)\s*;)",
+            "    int a[10], b[20], c[30];", countMatches<MultipleArrayPattern>, false },
+        { "declarador", R"(([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\])",
+            "a[10], b[20], c[30]", countMatches<SizedDeclaratorPattern>, false },
+        { "char[] = \"...\"", R"(\bchar\s+([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d*)\s*\]\s*=\s*("[^"]*"))",
+            "    char greeting[32] = \"hola mundo\";", countMatches<CharArrayInitPattern>, false },
+        { "char* = \"...\"", R"(\bchar\s*\*\s*([A-Za-z_][A-Za-z0-9_]*)\s*=\s*("[^"]*"))",
+            "    char *name = \"mike\"; char* last = \"perez\";", countMatches<CharPointerInitPattern>, false },
+        { "strcpy", R"(\bstrcpy\s*\(\s*([A-Za-z_][A-Za-z0-9_]*)\s*,\s*([^)]+)\s*\))",
+            "    strcpy(buffer, source); strcpy(name, \"nuevo\");", countMatches<StrcpyCallPattern>, false },
+        { "strcmp", R"(\bstrcmp\s*\(\s*([^,]+)\s*,\s*([^)]+)\s*\))",
+            "    if (strcmp(command, \"salir\") == 0 && strcmp(a, b) != 0) {", countMatches<StrcmpCallPattern>, false },
+        { "printf", "printf\\s*\\(\\s*\"([^\"]*)\"\\s*(?:,\\s*([^)]*))?\\s*\\)",
+            "printf(\"hola %s %s, tienes %d soles?\", firstname, lastname, money)", matchAnchored<PrintfCallPattern>, true },
+        { "especificador %", R"(%([-+ #0]*)([0-9]*)(\.?[0-9]*)([diouxXfFeEgGcs]))",
+            "Total: %-8d Promedio: %6.2f Hex: %#x Nombre: %s", countMatches<FormatSpecPattern>, false },
+    };
+
+    std::cout << std::left << std::setw(24) << "patron"
+        << std::right << std::setw(16) << "compilar (ns)"
+        << std::setw(16) << "regex (ns)"
+        << std::setw(16) << "matcher (ns)"
+        << std::setw(12) << "mejora" << "\n";
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (const auto& benchmark : cases) {
+        double compile_ns = nanosecondsPerCall(iterations / 10 + 1, [&] {
+            std::regex expression(benchmark.expression);
+            return static_cast<size_t>(expression.mark_count());
+        });
+
+        std::regex expression(benchmark.expression);
+
+        size_t regex_result = regexMatches(expression, benchmark.input, benchmark.anchored);
+        size_t matcher_result = benchmark.matcher(benchmark.input);
+        if (regex_result != matcher_result) {
+            std::cerr << "Resultado distinto para '" << benchmark.name << "': "
+                << regex_result << " != " << matcher_result << "\n";
+            return 1;
+        }
+
+        double regex_ns = nanosecondsPerCall(iterations, [&] {
+            return regexMatches(expression, benchmark.input, benchmark.anchored);
+        });
+        double matcher_ns = nanosecondsPerCall(iterations, [&] {
+            return benchmark.matcher(benchmark.input);
+        });
+
+        std::cout << std::left << std::setw(24) << benchmark.name
+            << std::right << std::setw(16) << compile_ns
+            << std::setw(16) << regex_ns
+            << std::setw(16) << matcher_ns
+            << std::setw(11) << regex_ns / matcher_ns << "x\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,695 @@
+#pragma once
+#include <array>
+#include <string>
+#include <string_view>
+
+// Reconocedores de los patrones fijos de los transpiladores. Cada uno reproduce
+// exactamente la coincidencia (posicion, longitud y grupos) que daba la expresion
+// regular ECMAScript indicada en su comentario, pero sin compilar expresiones en
+// tiempo de ejecucion ni retroceder: las clases de caracteres son tablas constexpr
+// y cada patron es un recorrido deterministico sobre el texto.
+//
+// Cota de tiempo: recorrer todas las coincidencias de un texto de n bytes con
+// forEachPatternMatch (o searchPattern con inicios crecientes) cuesta O(n), sin
+// recursion. Un intento en una posicion solo avanza por clases de caracteres
+// (espacios, identificadores, digitos) que terminan en el primer caracter ajeno, y
+// por busquedas del cierre de un grupo ([^"]*", [^}]*}, [^)]*), [^,]+,). Esas
+// busquedas pasan por PatternMatch::closers: intentos fallidos sobre el mismo
+// texto que buscan el mismo cierre lo encuentran sin recorrer de nuevo el tramo.
+
+// Conjunto de caracteres como tabla de 256 entradas generada en compilacion
+struct CharClass {
+    std::array<bool, 256> members{};
+
+    constexpr bool contains(char c) const { return members[static_cast<unsigned char>(c)]; }
+};
+
+constexpr CharClass makeCharClass(std::string_view chars, bool alpha = false, bool digits = false)
+{
+    CharClass result;
+    for (char c : chars) result.members[static_cast<unsigned char>(c)] = true;
+
+    for (int c = 0; c < 256; ++c) {
+        if (alpha && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) result.members[c] = true;
+        if (digits && c >= '0' && c <= '9') result.members[c] = true;
+    }
+
+    return result;
+}
+
+inline constexpr CharClass space_chars = makeCharClass(" \t\n\v\f\r");       // \s
+inline constexpr CharClass digit_chars = makeCharClass("", false, true);       // \d
+inline constexpr CharClass identifier_start_chars = makeCharClass("_", true);  // [A-Za-z_]
+inline constexpr CharClass identifier_chars = makeCharClass("_", true, true);  // [A-Za-z0-9_], tambien \w
+inline constexpr CharClass format_flag_chars = makeCharClass("-+ #0");
+inline constexpr CharClass format_spec_chars = makeCharClass("diouxXfFeEgGcs");
+
+// Busquedas hacia adelante de los caracteres que cierran grupos. Si text.find(c, from)
+// dio 'at', cualquier inicio en [from, at] da el mismo resultado; guardar la ultima
+// respuesta por caracter vuelve lineal la suma de las busquedas con inicios
+// crecientes. Vale mientras el texto no cambie: se descarta si cambia su direccion
+// o su tamano, y quien reutiliza un PatternMatch no debe modificar el texto entre
+// busquedas (los transpiladores buscan en vistas fijas y aplican los cambios despues)
+class CloserFinder {
+private:
+    static constexpr std::string_view closers = "\"}),";
+
+    struct Entry {
+        size_t from = std::string_view::npos;
+        size_t at = std::string_view::npos;
+    };
+
+    const char* data = nullptr;
+    size_t size = 0;
+    std::array<Entry, closers.size()> entries{};
+
+public:
+    constexpr size_t find(std::string_view text, char c, size_t from)
+    {
+        size_t slot = closers.find(c);
+        if (slot == std::string_view::npos) return text.find(c, from);
+
+        if (text.data() != data || text.size() != size) {
+            data = text.data();
+            size = text.size();
+            entries = {};
+        }
+
+        Entry& entry = entries[slot];
+        if (entry.from == std::string_view::npos || from < entry.from || (entry.at != std::string_view::npos && from > entry.at)) {
+            entry.from = from;
+            entry.at = text.find(c, from);
+        }
+        return entry.at;
+    }
+};
+
+// Coincidencia de un patron: posicion y longitud relativas al texto buscado y
+// hasta cuatro grupos de captura (vacios si el grupo no participo)
+struct PatternMatch {
+    size_t position = 0;
+    size_t length = 0;
+    std::array<std::string_view, 5> groups{};
+
+    // Cierres ya buscados en el texto de la busqueda en curso (ver CloserFinder)
+    CloserFinder closers;
+
+    constexpr size_t end() const { return position + length; }
+
+    std::string str(size_t group) const { return std::string(groups[group]); }
+};
+
+namespace pattern_detail {
+
+    constexpr size_t skip(std::string_view text, size_t pos, const CharClass& chars)
+    {
+        while (pos < text.size() && chars.contains(text[pos])) ++pos;
+        return pos;
+    }
+
+    constexpr size_t skipSpaces(std::string_view text, size_t pos)
+    {
+        return skip(text, pos, space_chars);
+    }
+
+    constexpr bool at(std::string_view text, size_t pos, char c)
+    {
+        return pos < text.size() && text[pos] == c;
+    }
+
+    constexpr bool startsWith(std::string_view text, size_t pos, std::string_view literal)
+    {
+        return text.substr(pos < text.size() ? pos : text.size(), literal.size()) == literal;
+    }
+
+    // [A-Za-z_][A-Za-z0-9_]*: devuelve el fin del identificador o npos
+    constexpr size_t identifier(std::string_view text, size_t pos)
+    {
+        if (pos >= text.size() || !identifier_start_chars.contains(text[pos])) return std::string_view::npos;
+        return skip(text, pos + 1, identifier_chars);
+    }
+
+    // \b antes de una palabra que empieza con caracter de palabra
+    constexpr bool wordBoundaryBefore(std::string_view text, size_t pos)
+    {
+        return pos == 0 || !identifier_chars.contains(text[pos - 1]);
+    }
+
+    constexpr bool wordBoundaryAfter(std::string_view text, size_t pos)
+    {
+        return pos >= text.size() || !identifier_chars.contains(text[pos]);
+    }
+
+    constexpr bool isLineTerminator(char c)
+    {
+        return c == '\n' || c == '\r';
+    }
+
+    // \s+(.+) hasta el final del texto ('.' no acepta \n ni \r)
+    constexpr bool spacedTail(std::string_view text, size_t pos, std::string_view& tail)
+    {
+        size_t rest = skipSpaces(text, pos);
+        if (rest == pos) return false;
+
+        if (rest < text.size()) {
+            for (size_t i = rest; i < text.size(); ++i) {
+                if (isLineTerminator(text[i])) return false;
+            }
+            tail = text.substr(rest);
+            return true;
+        }
+
+        // Solo espacios: \s+ cede el ultimo caracter a (.+)
+        if (rest - pos < 2 || isLineTerminator(text.back())) return false;
+        tail = text.substr(text.size() - 1);
+        return true;
+    }
+
+    // \s*([^c]+)c : el grupo termina en el primer 'c'; si solo hay espacios antes
+    // de 'c', \s* cede el ultimo. Devuelve la posicion de 'c' o npos
+    constexpr size_t groupUntil(std::string_view text, size_t pos, char c, std::string_view& group,
+        CloserFinder& closers)
+    {
+        size_t start = skipSpaces(text, pos);
+        if (start >= text.size()) return std::string_view::npos;
+
+        if (text[start] == c) {
+            if (start == pos) return std::string_view::npos;
+            group = text.substr(start - 1, 1);
+            return start;
+        }
+
+        size_t close = closers.find(text, c, start);
+        if (close == std::string_view::npos) return std::string_view::npos;
+
+        group = text.substr(start, close - start);
+        return close;
+    }
+
+    // Tipo, nombre y '[' comunes a las declaraciones de arreglo:
+    // ([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*
+    constexpr size_t arrayHead(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        size_t type_end = identifier(text, pos);
+        if (type_end == std::string_view::npos) return std::string_view::npos;
+
+        size_t i = skipSpaces(text, type_end);
+        if (i == type_end) return std::string_view::npos;
+        if (at(text, i, '*')) i = skipSpaces(text, i + 1);
+
+        size_t name_end = identifier(text, i);
+        if (name_end == std::string_view::npos) return std::string_view::npos;
+
+        size_t bracket = skipSpaces(text, name_end);
+        if (!at(text, bracket, '[')) return std::string_view::npos;
+
+        match.groups[1] = text.substr(pos, i - pos);
+        match.groups[2] = text.substr(i, name_end - i);
+        return skipSpaces(text, bracket + 1);
+    }
+
+    // \s*=\s*(\{[^}]*\})
+    constexpr size_t braceInitializer(std::string_view text, size_t pos, std::string_view& initializer,
+        CloserFinder& closers)
+    {
+        size_t i = skipSpaces(text, pos);
+        if (!at(text, i, '=')) return std::string_view::npos;
+
+        i = skipSpaces(text, i + 1);
+        if (!at(text, i, '{')) return std::string_view::npos;
+
+        size_t close = closers.find(text, '}', i + 1);
+        if (close == std::string_view::npos) return std::string_view::npos;
+
+        initializer = text.substr(i, close - i + 1);
+        return close + 1;
+    }
+
+    // \s*=\s*("[^"]*")
+    constexpr size_t quotedInitializer(std::string_view text, size_t pos, std::string_view& literal,
+        CloserFinder& closers)
+    {
+        size_t i = skipSpaces(text, pos);
+        if (!at(text, i, '=')) return std::string_view::npos;
+
+        i = skipSpaces(text, i + 1);
+        if (!at(text, i, '"')) return std::string_view::npos;
+
+        size_t close = closers.find(text, '"', i + 1);
+        if (close == std::string_view::npos) return std::string_view::npos;
+
+        literal = text.substr(i, close - i + 1);
+        return close + 1;
+    }
+
+    // ([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\] : devuelve el fin o npos
+    constexpr size_t sizedDeclarator(std::string_view text, size_t pos, std::string_view& name, std::string_view& size)
+    {
+        size_t name_end = identifier(text, pos);
+        if (name_end == std::string_view::npos) return std::string_view::npos;
+
+        size_t i = skipSpaces(text, name_end);
+        if (!at(text, i, '[')) return std::string_view::npos;
+
+        size_t digits = skipSpaces(text, i + 1);
+        size_t digits_end = skip(text, digits, digit_chars);
+        if (digits_end == digits) return std::string_view::npos;
+
+        i = skipSpaces(text, digits_end);
+        if (!at(text, i, ']')) return std::string_view::npos;
+
+        name = text.substr(pos, name_end - pos);
+        size = text.substr(digits, digits_end - digits);
+        return i + 1;
+    }
+
+    constexpr bool finish(PatternMatch& match, size_t pos, size_t end)
+    {
+        match.position = pos;
+        match.length = end - pos;
+        return true;
+    }
+}
+
+namespace pattern_detail {
+
+    // #define\s+([A-Za-z_][A-Za-z0-9_]*) : devuelve el fin del nombre o npos
+    constexpr size_t defineName(std::string_view line, std::string_view& name)
+    {
+        constexpr std::string_view directive = "#define";
+        if (!startsWith(line, 0, directive)) return std::string_view::npos;
+
+        size_t start = skipSpaces(line, directive.size());
+        if (start == directive.size()) return std::string_view::npos;
+
+        size_t end = identifier(line, start);
+        if (end == std::string_view::npos) return std::string_view::npos;
+
+        name = line.substr(start, end - start);
+        return end;
+    }
+}
+
+// #define\s+([A-Za-z_][A-Za-z0-9_]*)\s*\(([^)]*)\)\s+(.+)   (linea completa)
+struct DefineFunctionPattern {
+    static constexpr bool matchFull(std::string_view line, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        size_t name_end = defineName(line, match.groups[1]);
+        if (name_end == std::string_view::npos) return false;
+
+        size_t paren = skipSpaces(line, name_end);
+        if (!at(line, paren, '(')) return false;
+
+        size_t close = line.find(')', paren + 1);
+        if (close == std::string_view::npos) return false;
+
+        if (!spacedTail(line, close + 1, match.groups[3])) return false;
+
+        match.groups[2] = line.substr(paren + 1, close - paren - 1);
+        return finish(match, 0, line.size());
+    }
+};
+
+// #define\s+([A-Za-z_][A-Za-z0-9_]*)\s*$   (linea completa)
+struct DefineFlagPattern {
+    static constexpr bool matchFull(std::string_view line, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        size_t name_end = defineName(line, match.groups[1]);
+        if (name_end == std::string_view::npos || skipSpaces(line, name_end) != line.size()) return false;
+
+        return finish(match, 0, line.size());
+    }
+};
+
+// #define\s+([A-Za-z_][A-Za-z0-9_]*)\s+(.+)   (linea completa)
+struct DefineValuePattern {
+    static constexpr bool matchFull(std::string_view line, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        size_t name_end = defineName(line, match.groups[1]);
+        if (name_end == std::string_view::npos) return false;
+
+        if (!spacedTail(line, name_end, match.groups[2])) return false;
+
+        return finish(match, 0, line.size());
+    }
+};
+
+// ([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\]
+struct ArrayDeclarationPattern {
+    static constexpr bool starts_with_identifier = true;
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        size_t digits = arrayHead(text, pos, match);
+        if (digits == std::string_view::npos) return false;
+
+        size_t digits_end = skip(text, digits, digit_chars);
+        if (digits_end == digits) return false;
+
+        size_t i = skipSpaces(text, digits_end);
+        if (!at(text, i, ']')) return false;
+
+        match.groups[3] = text.substr(digits, digits_end - digits);
+        return finish(match, pos, i + 1);
+    }
+};
+
+// ([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\]\s*=\s*(\{[^}]*\})
+struct InitializedArrayPattern {
+    static constexpr bool starts_with_identifier = true;
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        size_t digits = arrayHead(text, pos, match);
+        if (digits == std::string_view::npos) return false;
+
+        size_t digits_end = skip(text, digits, digit_chars);
+        if (digits_end == digits) return false;
+
+        size_t i = skipSpaces(text, digits_end);
+        if (!at(text, i, ']')) return false;
+
+        size_t end = braceInitializer(text, i + 1, match.groups[4], match.closers);
+        if (end == std::string_view::npos) return false;
+
+        match.groups[3] = text.substr(digits, digits_end - digits);
+        return finish(match, pos, end);
+    }
+};
+
+// ([A-Za-z_][A-Za-z0-9_]*\s+\*?\s*)([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*\]\s*=\s*(\{[^}]*\})
+struct AutoInitArrayPattern {
+    static constexpr bool starts_with_identifier = true;
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        size_t i = arrayHead(text, pos, match);
+        if (i == std::string_view::npos || !at(text, i, ']')) return false;
+
+        size_t end = braceInitializer(text, i + 1, match.groups[3], match.closers);
+        if (end == std::string_view::npos) return false;
+
+        return finish(match, pos, end);
+    }
+};
+
+// ([A-Za-z_][A-Za-z0-9_]*\s+)([A-Za-z_][A-Za-z0-9_]*\s*\[\s*\d+\s*\]
+//     (?:\s*,\s*[A-Za-z_][A-Za-z0-9_]*\s*\[\s*\d+\s*\])*)\s*;
+struct MultipleArrayPattern {
+    static constexpr bool starts_with_identifier = true;
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        size_t type_end = identifier(text, pos);
+        if (type_end == std::string_view::npos) return false;
+
+        size_t first = skipSpaces(text, type_end);
+        if (first == type_end) return false;
+
+        std::string_view name, size;
+        size_t list_end = sizedDeclarator(text, first, name, size);
+        if (list_end == std::string_view::npos) return false;
+
+        // La repeticion toma todas las declaraciones posibles; con menos nunca sigue ';'
+        while (true) {
+            size_t comma = skipSpaces(text, list_end);
+            if (!at(text, comma, ',')) break;
+
+            size_t next = sizedDeclarator(text, skipSpaces(text, comma + 1), name, size);
+            if (next == std::string_view::npos) break;
+            list_end = next;
+        }
+
+        size_t semicolon = skipSpaces(text, list_end);
+        if (!at(text, semicolon, ';')) return false;
+
+        match.groups[1] = text.substr(pos, first - pos);
+        match.groups[2] = text.substr(first, list_end - first);
+        return finish(match, pos, semicolon + 1);
+    }
+};
+
+// ([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d+)\s*\]
+struct SizedDeclaratorPattern {
+    static constexpr bool starts_with_identifier = true;
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        size_t end = pattern_detail::sizedDeclarator(text, pos, match.groups[1], match.groups[2]);
+        if (end == std::string_view::npos) return false;
+
+        return pattern_detail::finish(match, pos, end);
+    }
+};
+
+// \bchar\s+([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d*)\s*\]\s*=\s*("[^"]*")
+struct CharArrayInitPattern {
+    static constexpr std::string_view keyword = "char";
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        if (!startsWith(text, pos, keyword) || !wordBoundaryBefore(text, pos)) return false;
+
+        size_t name = skipSpaces(text, pos + keyword.size());
+        if (name == pos + keyword.size()) return false;
+
+        size_t name_end = identifier(text, name);
+        if (name_end == std::string_view::npos) return false;
+
+        size_t i = skipSpaces(text, name_end);
+        if (!at(text, i, '[')) return false;
+
+        size_t digits = skipSpaces(text, i + 1);
+        size_t digits_end = skip(text, digits, digit_chars);
+
+        i = skipSpaces(text, digits_end);
+        if (!at(text, i, ']')) return false;
+
+        size_t end = quotedInitializer(text, i + 1, match.groups[3], match.closers);
+        if (end == std::string_view::npos) return false;
+
+        match.groups[1] = text.substr(name, name_end - name);
+        match.groups[2] = text.substr(digits, digits_end - digits);
+        return finish(match, pos, end);
+    }
+};
+
+// \bchar\s*\*\s*([A-Za-z_][A-Za-z0-9_]*)\s*=\s*("[^"]*")
+struct CharPointerInitPattern {
+    static constexpr std::string_view keyword = "char";
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        if (!startsWith(text, pos, keyword) || !wordBoundaryBefore(text, pos)) return false;
+
+        size_t star = skipSpaces(text, pos + keyword.size());
+        if (!at(text, star, '*')) return false;
+
+        size_t name = skipSpaces(text, star + 1);
+        size_t name_end = identifier(text, name);
+        if (name_end == std::string_view::npos) return false;
+
+        size_t end = quotedInitializer(text, name_end, match.groups[2], match.closers);
+        if (end == std::string_view::npos) return false;
+
+        match.groups[1] = text.substr(name, name_end - name);
+        return finish(match, pos, end);
+    }
+};
+
+// \bstrcpy\s*\(\s*([A-Za-z_][A-Za-z0-9_]*)\s*,\s*([^)]+)\s*\)
+struct StrcpyCallPattern {
+    static constexpr std::string_view keyword = "strcpy";
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        if (!startsWith(text, pos, keyword) || !wordBoundaryBefore(text, pos)) return false;
+
+        size_t paren = skipSpaces(text, pos + keyword.size());
+        if (!at(text, paren, '(')) return false;
+
+        size_t dest = skipSpaces(text, paren + 1);
+        size_t dest_end = identifier(text, dest);
+        if (dest_end == std::string_view::npos) return false;
+
+        size_t comma = skipSpaces(text, dest_end);
+        if (!at(text, comma, ',')) return false;
+
+        size_t close = groupUntil(text, comma + 1, ')', match.groups[2], match.closers);
+        if (close == std::string_view::npos) return false;
+
+        match.groups[1] = text.substr(dest, dest_end - dest);
+        return finish(match, pos, close + 1);
+    }
+};
+
+// \bstrcmp\s*\(\s*([^,]+)\s*,\s*([^)]+)\s*\)
+struct StrcmpCallPattern {
+    static constexpr std::string_view keyword = "strcmp";
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        if (!startsWith(text, pos, keyword) || !wordBoundaryBefore(text, pos)) return false;
+
+        size_t paren = skipSpaces(text, pos + keyword.size());
+        if (!at(text, paren, '(')) return false;
+
+        size_t comma = groupUntil(text, paren + 1, ',', match.groups[1], match.closers);
+        if (comma == std::string_view::npos) return false;
+
+        size_t close = groupUntil(text, comma + 1, ')', match.groups[2], match.closers);
+        if (close == std::string_view::npos) return false;
+
+        return finish(match, pos, close + 1);
+    }
+};
+
+// \bNULL\b
+struct NullPattern {
+    static constexpr std::string_view keyword = "NULL";
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        if (!startsWith(text, pos, keyword) || !wordBoundaryBefore(text, pos) ||
+            !wordBoundaryAfter(text, pos + keyword.size())) {
+            return false;
+        }
+
+        return finish(match, pos, pos + keyword.size());
+    }
+};
+
+// printf\s*\(\s*"([^"]*)"\s*(?:,\s*([^)]*))?\s*\)   (anclado en la posicion dada)
+struct PrintfCallPattern {
+    static constexpr std::string_view keyword = "printf";
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        if (!startsWith(text, pos, keyword)) return false;
+
+        size_t paren = skipSpaces(text, pos + keyword.size());
+        if (!at(text, paren, '(')) return false;
+
+        size_t quote = skipSpaces(text, paren + 1);
+        if (!at(text, quote, '"')) return false;
+
+        size_t closing_quote = match.closers.find(text, '"', quote + 1);
+        if (closing_quote == std::string_view::npos) return false;
+
+        size_t i = skipSpaces(text, closing_quote + 1);
+        match.groups[2] = {};
+
+        if (at(text, i, ',')) {
+            size_t arguments = skipSpaces(text, i + 1);
+            size_t close = match.closers.find(text, ')', arguments);
+            if (close == std::string_view::npos) return false;
+
+            match.groups[2] = text.substr(arguments, close - arguments);
+            i = close;
+        }
+        else if (!at(text, i, ')')) {
+            return false;
+        }
+
+        match.groups[1] = text.substr(quote + 1, closing_quote - quote - 1);
+        return finish(match, pos, i + 1);
+    }
+};
+
+// %([-+ #0]*)([0-9]*)(\.?[0-9]*)([diouxXfFeEgGcs])
+struct FormatSpecPattern {
+    static constexpr std::string_view keyword = "%";
+
+    static constexpr bool matchAt(std::string_view text, size_t pos, PatternMatch& match)
+    {
+        using namespace pattern_detail;
+
+        if (!at(text, pos, '%')) return false;
+
+        size_t flags_end = skip(text, pos + 1, format_flag_chars);
+        size_t width_end = skip(text, flags_end, digit_chars);
+        size_t precision_end = width_end;
+        if (at(text, precision_end, '.')) ++precision_end;
+        precision_end = skip(text, precision_end, digit_chars);
+
+        if (precision_end >= text.size() || !format_spec_chars.contains(text[precision_end])) return false;
+
+        match.groups[1] = text.substr(pos + 1, flags_end - pos - 1);
+        match.groups[2] = text.substr(flags_end, width_end - flags_end);
+        match.groups[3] = text.substr(width_end, precision_end - width_end);
+        match.groups[4] = text.substr(precision_end, 1);
+        return finish(match, pos, precision_end + 1);
+    }
+};
+
+// Primera coincidencia del patron en text[from, ...), como std::regex_search. Los
+// caracteres anteriores a 'from' cuentan para \b (equivale a match_prev_avail).
+// Los patrones que empiezan con un identificador solo se prueban una vez por
+// palabra: dentro de la misma palabra el resultado seria el mismo.
+template <typename Pattern>
+constexpr bool searchPattern(std::string_view text, size_t from, PatternMatch& match)
+{
+    if constexpr (requires { Pattern::keyword; }) {
+        for (size_t pos = text.find(Pattern::keyword, from); pos != std::string_view::npos;
+            pos = text.find(Pattern::keyword, pos + 1)) {
+            if (Pattern::matchAt(text, pos, match)) return true;
+        }
+        return false;
+    }
+    else {
+        static_assert(Pattern::starts_with_identifier);
+
+        bool in_word = false;
+        for (size_t pos = from; pos < text.size(); ++pos) {
+            char c = text[pos];
+            if (!identifier_chars.contains(c)) {
+                in_word = false;
+                continue;
+            }
+            if (in_word || !identifier_start_chars.contains(c)) continue;
+
+            in_word = true;
+            if (Pattern::matchAt(text, pos, match)) return true;
+        }
+        return false;
+    }
+}
+
+// Recorre las coincidencias sin solapamiento, como std::sregex_iterator
+template <typename Pattern, typename MatchHandler>
+void forEachPatternMatch(std::string_view text, MatchHandler&& handler)
+{
+    PatternMatch match;
+    size_t from = 0;
+
+    while (from <= text.size() && searchPattern<Pattern>(text, from, match)) {
+        handler(match);
+        from = match.end();
+    }
+}
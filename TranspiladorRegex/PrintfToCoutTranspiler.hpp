@@ -1,109 +1,330 @@
+#pragma once
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
-#include <regex>
 #include <vector>
 #include <algorithm>
-
+#include "CLexer.hpp"
+#include "EditList.hpp"
+#include "PatternMatchers.hpp"
+#include "IncludeRewriter.hpp"
+#include "KeywordPrefilter.hpp"
+#include "LineMemo.hpp"
+#include "SourceLines.hpp"
+#include "TranspilerStats.hpp"
+
+// Las reglas no cambian durante un recorrido: el estado vive en un Context, y un
+// mismo PrintfTranspiler puede usarse desde varios hilos a la vez
 class PrintfTranspiler {
-private:
-    // Expresion regular para capturar printf con formato y argumentos
-    std::regex printf_pattern{
-        "printf\\s*\\(\\s*\"([^\"]*)\"\\s*(?:,\\s*([^)]*))?\\s*\\)"
-    };
+public:
+    // Estado de un recorrido
+    struct Context {
+        IncludeRewriter::Context include;
+
+        LexState lex_state;
+        std::vector<Token> line_tokens;
+
+        // Una llamada a printf puede abarcar varias lineas: el texto se retiene
+        // hasta que todos sus candidatos pueden decidirse
+        std::string pending;
+        std::vector<size_t> pending_candidates;
+        size_t next_candidate = 0;
+        EditList pending_edits;
+
+        // Hasta donde se reviso el candidato que todavia no puede decidirse, para
+        // no recorrer de nuevo el texto pendiente con cada linea que llega
+        struct DecisionScan {
+            size_t candidate = std::string::npos;
+            unsigned step = 0;
+            size_t next = 0;
+        } decision_scan;
+
+        // Memoria de lineas ya convertidas (opcional, puede compartirse entre hilos)
+        LineMemo* memo = nullptr;
+
+        // Verdadero si ningun estado pasa de la ultima linea procesada a la siguiente
+        // (en particular, ninguna llamada a printf quedo a medias)
+        bool idle() const {
+            return lex_state == LexState{} && pending.empty() && pending_candidates.empty() && include.idle();
+        }
 
-    // Mapeo de especificadores de formato C a manipuladores C++
-    std::vector<std::pair<std::regex, std::string>> format_replacements{
-        {std::regex(R"(%d)"), ""},           // %d -> directo
-        {std::regex(R"(%i)"), ""},           // %i -> directo
-        {std::regex(R"(%u)"), ""},           // %u -> directo
-        {std::regex(R"(%ld)"), ""},          // %ld -> directo
-        {std::regex(R"(%lu)"), ""},          // %lu -> directo
-        {std::regex(R"(%f)"), ""},           // %f -> directo
-        {std::regex(R"(%lf)"), ""},          // %lf -> directo
-        {std::regex(R"(%g)"), ""},           // %g -> directo
-        {std::regex(R"(%c)"), ""},           // %c -> directo
-        {std::regex(R"(%s)"), ""},           // %s -> directo
-        {std::regex(R"(%x)"), " << std::hex << "}, // %x -> hex
-        {std::regex(R"(%X)"), " << std::hex << std::uppercase << "}, // %X -> HEX
-        {std::regex(R"(%o)"), " << std::oct << "}, // %o -> octal
-        {std::regex(R"(\\n)"), "\\n"},       // \n se mantiene
-        {std::regex(R"(\\t)"), "\\t"},       // \t se mantiene
+        // Verdadero si hay lineas retenidas que todavia no llegaron a la salida
+        bool holdsOutput() const { return !pending.empty(); }
     };
 
+private:
+    // Las llamadas se reconocen con PrintfCallPattern (formato y argumentos) y los
+    // especificadores de formato con FormatSpecPattern
+
+    // Lexer compartido: solo los identificadores printf reales son candidatos
+    CLexer lexer;
+
+    // Inserta #include <iostream> y comenta las directivas de <stdio.h>
+    IncludeRewriter include_rewriter{ "#include <iostream>", "<stdio.h>",
+        "// #include <stdio.h> // Reemplazado por <iostream>" };
+
 public:
-    std::string transpileFile(const std::string& content);
+    std::string transpileFile(std::string_view content) const;
 
-private:
-    std::string addIncludes(const std::string& content);
+    // Procesamiento linea a linea para el pipeline fusionado
+    void beginStream(Context& context, bool insert_include, bool prepend_include, std::string& out) const;
 
-    std::string transpilePrintfStatements(const std::string& content);
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const;
 
-    std::string convertToCout(const std::string& format, const std::string& args);
+    // 'triggers' son los bits de KeywordPrefilter ya calculados para la linea
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
 
-    std::vector<std::string> splitArguments(const std::string& args);
+    void endStream(Context& context, std::string& out) const;
 
+    // Texto de cout para el formato de una llamada y sus argumentos ya separados.
+    // transpiler_bench lo mide sin pasar por el resto de la etapa
     std::string processFormatString(
         const std::string& format,
-        const std::vector<std::string>& args);
+        const std::vector<std::string>& args) const;
+
+private:
+    void transpilePrintfStatements(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
+
+    // Convierte los candidatos pendientes; con 'at_end' no llegara mas texto
+    void flushPrintfStatements(Context& context, bool at_end, std::string& out) const;
+
+    // Continua desde 'scan' si ya reviso el candidato en 'pos': cada byte pendiente
+    // se examina una vez por candidato
+    static bool isPrintfCallDecided(std::string_view text, size_t pos, Context::DecisionScan& scan,
+        CloserFinder& closers);
+
+    void findPrintfCandidates(std::string_view line, const std::vector<Token>& tokens,
+        size_t base, std::vector<size_t>& candidates) const;
+
+    std::string convertToCout(const std::string& format, const std::string& args) const;
+
+    std::vector<std::string> splitArguments(const std::string& args) const;
 };
 
 
 
-std::string PrintfTranspiler::transpileFile(const std::string& content)
+inline std::string PrintfTranspiler::transpileFile(std::string_view content) const
 {
-    std::string result = addIncludes(content);
+    std::string result;
+    result.reserve(content.size() + content.size() / 8 + 32);
 
-    result = transpilePrintfStatements(result);
+    bool insert_include = content.find("#include <iostream>") == std::string_view::npos;
+    bool prepend_include = insert_include && !lexer.hasIncludeDirective(content);
+
+    Context context;
+    beginStream(context, insert_include, prepend_include, result);
+    KeywordPrefilter::shared().forEachLine(content, [&](std::string_view line, bool has_newline, unsigned triggers) {
+        transpileLine(context, line, has_newline, result, triggers);
+    });
+    endStream(context, result);
 
     return result;
 }
 
-std::string PrintfTranspiler::addIncludes(const std::string& content)
+inline void PrintfTranspiler::beginStream(Context& context, bool insert_include, bool prepend_include, std::string& out) const
+{
+    context.lex_state = LexState{};
+    context.pending.clear();
+    context.pending_candidates.clear();
+    context.next_candidate = 0;
+    context.pending_edits.clear();
+    context.decision_scan = {};
+
+    include_rewriter.begin(context.include, insert_include, prepend_include, [&](std::string_view line, bool has_newline) {
+        transpilePrintfStatements(context, line, has_newline, out, KeywordPrefilter::shared().scan(line));
+    });
+}
+
+inline void PrintfTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const
+{
+    transpileLine(context, line, has_newline, out, KeywordPrefilter::shared().scan(line));
+}
+
+inline void PrintfTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+    unsigned triggers) const
+{
+    include_rewriter.rewriteLine(context.include, line, has_newline, triggers,
+        [&](std::string_view rewritten, bool rewritten_newline) {
+            transpilePrintfStatements(context, rewritten, rewritten_newline, out,
+                KeywordPrefilter::rescanIfChanged(line, rewritten, triggers));
+        });
+}
+
+inline void PrintfTranspiler::endStream(Context& context, std::string& out) const
+{
+    flushPrintfStatements(context, true, out);
+}
+
+inline void PrintfTranspiler::transpilePrintfStatements(Context& context, std::string_view line, bool has_newline,
+    std::string& out, unsigned triggers) const
+{
+    LexState& lex_state = context.lex_state;
+    std::vector<Token>& line_tokens = context.line_tokens;
+    std::string& pending = context.pending;
+    std::vector<size_t>& pending_candidates = context.pending_candidates;
+    size_t& next_candidate = context.next_candidate;
+
+    // Sin llamadas pendientes y desde el estado inicial del lexer, una linea cuyas
+    // llamadas se deciden en ella misma depende solo de sus bytes
+    bool memoizable = context.memo != nullptr && (triggers & trigger_printf) != 0 &&
+        lex_state == LexState{} && pending.empty() && pending_candidates.empty();
+    if (memoizable && context.memo->lookup(MemoPass::Printf, line, has_newline, out, lex_state)) {
+        return;
+    }
+    size_t output_start = out.size();
+    LineMemo::RuleMark rules;
+
+    // Sin "printf" la linea no agrega candidatos
+    if ((triggers & trigger_printf) == 0) {
+        lexer.skipLine(line, has_newline, lex_state, (triggers & trigger_lexer) == 0);
+    }
+    else {
+        line_tokens.clear();
+        lexer.tokenizeLine(line, has_newline, lex_state, line_tokens);
+
+        findPrintfCandidates(line, line_tokens, pending.size(), pending_candidates);
+    }
+
+    // Sin candidatos pendientes la linea se copia directamente
+    if (next_candidate == pending_candidates.size() && pending.empty()) {
+        pending_candidates.clear();
+        next_candidate = 0;
+        out.append(line);
+        if (has_newline) out += '\n';
+
+        if (memoizable) {
+            context.memo->store(MemoPass::Printf, line, has_newline, std::string_view(out).substr(output_start), lex_state, rules);
+        }
+        return;
+    }
+
+    pending.append(line);
+    if (has_newline) pending += '\n';
+
+    flushPrintfStatements(context, false, out);
+
+    if (memoizable && pending.empty()) {
+        context.memo->store(MemoPass::Printf, line, has_newline, std::string_view(out).substr(output_start), lex_state, rules);
+    }
+}
+
+inline void PrintfTranspiler::flushPrintfStatements(Context& context, bool at_end, std::string& out) const
 {
-    std::string result = content;
+    std::string& pending = context.pending;
+    std::vector<size_t>& pending_candidates = context.pending_candidates;
+    size_t& next_candidate = context.next_candidate;
+    EditList& pending_edits = context.pending_edits;
+
+    PatternMatch match;
+
+    for (; next_candidate < pending_candidates.size(); ++next_candidate) {
+        size_t pos = pending_candidates[next_candidate];
 
-    if (result.find("#include <iostream>") == std::string::npos) {
-        std::regex include_pattern(R"(#include\s*[<"][^>"]*[>"])");
-        std::smatch match;
+        // Candidatos dentro de una llamada ya convertida
+        if (pending_edits.overlaps(pos, 1)) continue;
 
-        if (std::regex_search(result, match, include_pattern)) {
-            size_t pos = match.position() + match.length();
-            result.insert(pos, "\n#include <iostream>");
+        // El resultado depende de texto que todavia no llega
+        if (!at_end && !isPrintfCallDecided(pending, pos, context.decision_scan, match.closers)) return;
+
+        if (!PrintfCallPattern::matchAt(pending, pos, match)) {
+            continue;
         }
-        else {
-            result = "#include <iostream>\n" + result;
+
+        std::string format_string = match.str(1);
+        std::string arguments = match.str(2);
+
+        if (pending_edits.replace(pos, match.length, convertToCout(format_string, arguments))) {
+            TranspilerStats::countRule(StatsRule::PrintfCall);
         }
     }
 
-    result = std::regex_replace(result,
-        std::regex(R"(#include\s*<stdio\.h>)"),
-        "// #include <stdio.h> // Reemplazado por <iostream>");
+    pending_edits.apply(pending, out);
 
-    return result;
+    pending.clear();
+    pending_candidates.clear();
+    next_candidate = 0;
+    pending_edits.clear();
+    context.decision_scan = {};
 }
 
-std::string PrintfTranspiler::transpilePrintfStatements(const std::string& content)
+inline bool PrintfTranspiler::isPrintfCallDecided(std::string_view text, size_t pos, Context::DecisionScan& scan,
+    CloserFinder& closers)
 {
-    std::string result = content;
-    std::smatch match;
+    // El patron solo puede coincidir hasta el primer ')' despues de la cadena de formato.
+    // Pasos: espacios y '(', espacios y '"', comilla de cierre, ')'
+    auto skip_spaces = [&](size_t i) {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+        return i;
+    };
 
-    while (std::regex_search(result, match, printf_pattern)) {
-        std::string format_string = match[1].str();
-        std::string arguments = match.length() > 2 ? match[2].str() : "";
+    if (scan.candidate != pos) {
+        scan = Context::DecisionScan{ pos, 0, pos + 6 };
+    }
+    size_t& i = scan.next;
+
+    if (scan.step == 0) {
+        i = skip_spaces(i);
+        if (i == text.size()) return false;
+        if (text[i] != '(') return true;
+        ++i;
+        scan.step = 1;
+    }
 
-        std::string cout_statement = convertToCout(format_string, arguments);
+    if (scan.step == 1) {
+        i = skip_spaces(i);
+        if (i == text.size()) return false;
+        if (text[i] != '"') return true;
+        ++i;
+        scan.step = 2;
+    }
 
-        size_t pos = match.position();
-        size_t len = match.length();
-        result.replace(pos, len, cout_statement);
+    if (scan.step == 2) {
+        size_t closing_quote = closers.find(text, '"', i);
+        if (closing_quote == std::string_view::npos) {
+            i = text.size();
+            return false;
+        }
+        i = closing_quote + 1;
+        scan.step = 3;
     }
 
-    return result;
+    size_t close = closers.find(text, ')', i);
+    if (close == std::string_view::npos) {
+        i = text.size();
+        return false;
+    }
+    return true;
 }
 
-std::string PrintfTranspiler::convertToCout(const std::string& format, const std::string& args)
+inline void PrintfTranspiler::findPrintfCandidates(std::string_view line, const std::vector<Token>& tokens,
+    size_t base, std::vector<size_t>& candidates) const
+{
+    static constexpr std::string_view keyword = "printf";
+
+    for (const Token& token : tokens) {
+        if (token.kind == TokenKind::Identifier) {
+            if (line.substr(token.offset, token.length) == keyword) {
+                candidates.push_back(base + token.offset);
+            }
+        }
+        else if (token.kind == TokenKind::Comment) {
+            // Los comentarios tambien se convierten: los pasos anteriores pueden dejar
+            // codigo detras de un "//" agregado (p. ej. "// Convertido de arreglo C")
+            std::string_view text = line.substr(token.offset, token.length);
+            for (size_t pos = text.find(keyword); pos != std::string_view::npos; pos = text.find(keyword, pos + 1)) {
+                unsigned char before = pos > 0 ? static_cast<unsigned char>(text[pos - 1]) : ' ';
+                if (!std::isalnum(before) && before != '_') {
+                    candidates.push_back(base + token.offset + pos);
+                }
+            }
+        }
+    }
+}
+
+inline std::string PrintfTranspiler::convertToCout(const std::string& format, const std::string& args) const
 {
     std::string result = "std::cout";
 
@@ -122,7 +343,7 @@ std::string PrintfTranspiler::convertToCout(const std::string& format, const std
     return result;
 }
 
-std::vector<std::string> PrintfTranspiler::splitArguments(const std::string& args)
+inline std::vector<std::string> PrintfTranspiler::splitArguments(const std::string& args) const
 {
     std::vector<std::string> result;
     if (args.empty()) return result;
@@ -145,29 +366,28 @@ std::vector<std::string> PrintfTranspiler::splitArguments(const std::string& arg
     return result;
 }
 
-std::string PrintfTranspiler::processFormatString(const std::string& format, const std::vector<std::string>& args)
+inline std::string PrintfTranspiler::processFormatString(const std::string& format, const std::vector<std::string>& args) const
 {
     std::string result;
-    std::string current_format = format;
     size_t arg_index = 0;
 
     // Buscar especificadores de formato
-    std::regex format_spec(R"(%([-+ #0]*)([0-9]*)(\.?[0-9]*)([diouxXfFeEgGcs]))");
-    std::smatch match;
-
+    PatternMatch match;
     size_t last_pos = 0;
 
-    while (std::regex_search(current_format, match, format_spec)) {
-        std::string literal = current_format.substr(last_pos, match.position());
+    while (searchPattern<FormatSpecPattern>(format, last_pos, match)) {
+        std::string_view literal = std::string_view(format).substr(last_pos, match.position - last_pos);
         if (!literal.empty()) {
             if (!result.empty()) result += " << ";
-            result += "\"" + literal + "\"";
+            result += "\"";
+            result += literal;
+            result += "\"";
         }
 
         if (arg_index < args.size()) {
             if (!result.empty()) result += " << ";
 
-            char spec = match[4].str()[0];
+            char spec = match.groups[4][0];
             if (spec == 'x') {
                 result += "std::hex << " + args[arg_index] + " << std::dec";
             }
@@ -184,14 +404,14 @@ std::string PrintfTranspiler::processFormatString(const std::string& format, con
             arg_index++;
         }
 
-        last_pos = match.position() + match.length();
-        current_format = current_format.substr(last_pos);
-        last_pos = 0;
+        last_pos = match.end();
     }
 
-    if (!current_format.empty()) {
+    if (last_pos < format.size()) {
         if (!result.empty()) result += " << ";
-        result += "\"" + current_format + "\"";
+        result += "\"";
+        result.append(format, last_pos, std::string::npos);
+        result += "\"";
     }
 
     return result;
@@ -0,0 +1,150 @@
+// Mide el clasificador de bytes (ByteClassScanner) en cada nivel de instrucciones
+// sobre buffers de 1 KB a 1 GB y lo compara con una copia de memoria (memcpy)
+// como referencia del ancho de banda. Tambien mide la division en lineas con
+// deteccion de palabras clave: mapas de bits frente al automata linea por linea.
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ByteClassScanner.hpp"
+#include "KeywordPrefilter.hpp"
+#include "SourceLines.hpp"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    volatile size_t benchmark_sink = 0;
+
+    // Repite la operacion hasta procesar al menos 'min_bytes' y devuelve GB/s
+    template <typename Operation>
+    double gigabytesPerSecond(size_t size, size_t min_bytes, Operation&& operation)
+    {
+        size_t repetitions = std::max<size_t>(1, min_bytes / size);
+
+        operation();
+        auto start = Clock::now();
+        for (size_t i = 0; i < repetitions; ++i) {
+            operation();
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+
+        return static_cast<double>(size) * static_cast<double>(repetitions) / elapsed.count() / 1e9;
+    }
+
+    std::string makeSource(size_t size)
+    {
+        static const std::string sample =
+            "#include <stdio.h>\n"
+            "#define MAX(a, b) ((a) > (b) ? (a) : (b))\n"
+            "\n"
+            "int main(void) {\n"
+            "    int values[100];\n"
+            "    char name[32] = \"mike\";\n"
+            "    for (int i = 0; i < 100; ++i) {\n"
+            "        values[i] = MAX(i, 50); // limite inferior\n"
+            "    }\n"
+            "    if (strcmp(name, \"salir\") == 0 && ptr != NULL) {\n"
+            "        printf(\"Total: %d\\n\", values[0]);\n"
+            "    }\n"
+            "    return 0;\n"
+            "}\n";
+
+        std::string source;
+        source.reserve(size);
+        while (source.size() < size) {
+            source.append(sample, 0, std::min(sample.size(), size - source.size()));
+        }
+        return source;
+    }
+
+    std::string formatSize(size_t size)
+    {
+        if (size >= (size_t{ 1 } << 30)) return std::to_string(size >> 30) + " GB";
+        if (size >= (size_t{ 1 } << 20)) return std::to_string(size >> 20) + " MB";
+        return std::to_string(size >> 10) + " KB";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // Tamano maximo en MB (1 GB por omision)
+    size_t max_size = (argc > 1 ? std::stoul(argv[1]) : 1024) << 20;
+    size_t min_bytes = size_t{ 256 } << 20;
+
+    const ByteClassScanner scanner("#N[csp/\"'\\");
+    const KeywordPrefilter& prefilter = KeywordPrefilter::shared();
+
+    std::vector<ScannerLevel> levels{ ScannerLevel::Scalar };
+    if (ByteClassScanner::detectedLevel() >= ScannerLevel::SSE42) levels.push_back(ScannerLevel::SSE42);
+    if (ByteClassScanner::detectedLevel() >= ScannerLevel::AVX2) levels.push_back(ScannerLevel::AVX2);
+
+    std::cout << "nivel detectado: " << scannerLevelName(ByteClassScanner::detectedLevel()) << "\n\n";
+
+    std::cout << std::left << std::setw(10) << "tamano" << std::right << std::setw(10) << "memcpy";
+    for (ScannerLevel level : levels) {
+        std::cout << std::setw(10) << scannerLevelName(level);
+    }
+    std::cout << std::setw(14) << "lineas+bits" << std::setw(14) << "lineas+DFA" << "   (GB/s)\n";
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (size_t size = 1024; size <= max_size; size *= 4) {
+        std::string source = makeSource(size);
+        std::string copy(size, '\0');
+
+        ByteClassBitmaps expected;
+        scanner.scan(source, expected, ScannerLevel::Scalar);
+
+        std::cout << std::left << std::setw(10) << formatSize(size) << std::right;
+
+        std::cout << std::setw(10) << gigabytesPerSecond(size, min_bytes, [&] {
+            std::memcpy(copy.data(), source.data(), size);
+            benchmark_sink = benchmark_sink + static_cast<unsigned char>(copy[size / 2]);
+        });
+
+        ByteClassBitmaps bitmaps;
+        for (ScannerLevel level : levels) {
+            scanner.scan(source, bitmaps, level);
+            if (bitmaps.newlines != expected.newlines || bitmaps.specials != expected.specials) {
+                std::cerr << "\nMapas distintos en " << scannerLevelName(level) << "\n";
+                return 1;
+            }
+
+            std::cout << std::setw(10) << gigabytesPerSecond(size, min_bytes, [&] {
+                scanner.scan(source, bitmaps, level);
+                benchmark_sink = benchmark_sink + bitmaps.specials.size();
+            });
+        }
+
+        // Los bits por linea deben coincidir con los del automata
+        std::vector<unsigned> line_triggers;
+        forEachLine(source, [&](std::string_view line, bool) { line_triggers.push_back(prefilter.scan(line)); });
+        size_t line_index = 0;
+        bool same_triggers = true;
+        prefilter.forEachLine(source, bitmaps, [&](std::string_view, bool, unsigned triggers) {
+            same_triggers = same_triggers && line_index < line_triggers.size() && line_triggers[line_index] == triggers;
+            ++line_index;
+        });
+        if (!same_triggers || line_index != line_triggers.size()) {
+            std::cerr << "\nBits de linea distintos del automata\n";
+            return 1;
+        }
+
+        std::cout << std::setw(14) << gigabytesPerSecond(size, min_bytes, [&] {
+            unsigned found = 0;
+            prefilter.forEachLine(source, bitmaps, [&](std::string_view, bool, unsigned triggers) { found |= triggers; });
+            benchmark_sink = benchmark_sink + found;
+        });
+
+        std::cout << std::setw(14) << gigabytesPerSecond(size, min_bytes, [&] {
+            unsigned found = 0;
+            forEachLine(source, [&](std::string_view line, bool) { found |= prefilter.scan(line); });
+            benchmark_sink = benchmark_sink + found;
+        }) << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Muchas transpilaciones concurrentes con un solo TranspilerRules: cada hilo usa
+// su propio TranspilerPipeline (solo estado) o llama directamente a las reglas
+// compartidas. Informa el rendimiento y compara cada salida con la de un solo
+// hilo; termina con error si alguna difiere. ctest lo ejecuta como prueba; con
+// -DTRANSPILER_SANITIZE=thread comprueba tambien que las reglas no se modifican
+// al usarlas.
+//
+// Uso: SharedRulesBenchmark [hilos] [repeticiones] [archivo.c ...]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchmarkTools.hpp"
+#include "MappedFile.hpp"
+#include "TranspilerPipeline.hpp"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    const char* sample_source = R"(#include <stdio.h>
+#include <string.h>
+
+#define PI 3.1416
+#define SQUARE(x) ((x) * (x))
+
+int main() {
+    char* firstname = "mike";
+    char lastname[] = "perez";
+    char copy[32];
+    int values[] = { 1, 2, 3, 4, 5 };
+    int* ptr = NULL;
+
+    strcpy(firstname, "john");
+    if (strcmp(firstname, lastname) == 0) {
+        printf("iguales %s\n", firstname);
+    }
+
+    printf("hola %s %s, tienes %d soles y %f de radio\n",
+        firstname, lastname, values[2], PI * SQUARE(2));
+
+    return 0;
+}
+)";
+
+    // Salida de un solo hilo con un pipeline nuevo
+    std::string reference(const std::string& source, unsigned passes)
+    {
+        TranspilerPipeline pipeline;
+        return pipeline.transpilePasses(source, passes);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    size_t repetitions = 2000;
+    if ((argc > 1 && !BenchmarkTools::parseCount(argv[1], 1, 1024, threads)) ||
+        (argc > 2 && !BenchmarkTools::parseCount(argv[2], 1, SIZE_MAX, repetitions))) {
+        std::cerr << "Uso: SharedRulesBenchmark [hilos de 1 a 1024] [repeticiones] [archivo.c ...]\n";
+        return 1;
+    }
+
+    std::vector<std::string> sources;
+    for (int i = 3; i < argc; ++i) {
+        MappedFile file;
+        if (!file.open(argv[i])) {
+            std::cerr << "No se pudo abrir el archivo: " << argv[i] << "\n";
+            return 1;
+        }
+        sources.emplace_back(file.view());
+    }
+    if (sources.empty()) {
+        sources.emplace_back(sample_source);
+    }
+
+    // Todas las etapas por el pipeline fusionado, un subconjunto por el secuencial
+    // y cada etapa sola directamente sobre las reglas compartidas
+    const std::vector<unsigned> pass_sets{ all_passes, pass_define | pass_null | pass_printf };
+
+    std::vector<std::vector<std::string>> expected(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        for (unsigned passes : pass_sets) expected[i].push_back(reference(sources[i], passes));
+        expected[i].push_back(TranspilerRules::shared().stringTranspiler.transpileFile(sources[i]));
+    }
+
+    std::atomic<size_t> mismatches{ 0 };
+    std::atomic<size_t> bytes{ 0 };
+
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            TranspilerPipeline pipeline;
+            const TranspilerRules& rules = TranspilerRules::shared();
+
+            for (size_t r = 0; r < repetitions; ++r) {
+                // Cada hilo recorre las entradas en otro orden
+                size_t index = (r + t) % sources.size();
+                const std::string& source = sources[index];
+
+                for (size_t set = 0; set < pass_sets.size(); ++set) {
+                    if (pipeline.transpilePasses(source, pass_sets[set]) != expected[index][set]) ++mismatches;
+                }
+                if (rules.stringTranspiler.transpileFile(source) != expected[index].back()) ++mismatches;
+
+                bytes += source.size() * (pass_sets.size() + 1);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    size_t transpilations = threads * repetitions * (pass_sets.size() + 1);
+
+    std::cout << std::fixed << std::setprecision(2)
+        << threads << " hilos, " << transpilations << " transpilaciones en " << seconds << " s: "
+        << static_cast<double>(transpilations) / seconds << " por segundo, "
+        << static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds << " MB/s\n"
+        << "Salidas distintas a las de un solo hilo: " << mismatches << "\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
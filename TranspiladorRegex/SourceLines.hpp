@@ -0,0 +1,21 @@
+#pragma once
+#include <string_view>
+
+// Recorre 'content' linea por linea con la misma semantica que std::getline:
+// cada linea se entrega sin el '\n', junto con un indicador de si lo tenia.
+// Si el contenido termina en '\n' no se genera una linea vacia adicional.
+template <typename LineHandler>
+void forEachLine(std::string_view content, LineHandler&& handler)
+{
+    size_t line_start = 0;
+
+    while (line_start < content.size()) {
+        size_t line_end = content.find('\n', line_start);
+        bool has_newline = line_end != std::string_view::npos;
+        if (!has_newline) line_end = content.size();
+
+        handler(content.substr(line_start, line_end - line_start), has_newline);
+
+        line_start = line_end + 1;
+    }
+}
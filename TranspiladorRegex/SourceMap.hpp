@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonLine.hpp"
+#include "SourceLines.hpp"
+
+// Linea de la entrada de la que sale cada linea del resultado, en el formato de
+// Source Map v3: 'mappings' tiene un segmento por linea de salida, separados por ';',
+// con la columna 0 y la diferencia de linea de entrada respecto del segmento anterior
+// en VLQ base64. Una linea sin cambios ocupa "AACA;" (5 bytes). Las herramientas de
+// source maps lo leen tal cual; para un diagnostico "salida.cpp:L:C" basta decodificar
+// y tomar la linea L - 1.
+//
+// Las lineas se numeran desde 0. Si una salida proviene de varias lineas de entrada
+// (una llamada a printf que abarca varias, una declaracion que se divide), todas sus
+// lineas apuntan a la primera, salvo que la cantidad coincida y se asignen una a una.
+class SourceMap {
+private:
+    std::string mappings;
+    size_t output_lines = 0;
+    int64_t previous_input = 0;
+
+    // La ultima linea de salida registrada todavia no termino
+    bool line_open = false;
+
+    // Falso si el mapa se aproximo comparando lineas (ver approximate)
+    bool exact = true;
+
+public:
+    void clear();
+
+    // Registra las lineas de salida que empiezan en 'output', que proviene de las
+    // 'input_lines' lineas de entrada a partir de 'first_input'
+    void addSpan(std::string_view output, size_t first_input, size_t input_lines);
+
+    // Mapa sin registro de las etapas: cada linea de 'output' igual a una de las
+    // siguientes lineas de 'input' apunta a ella; las demas, a la ultima encontrada
+    void approximate(std::string_view input, std::string_view output);
+
+    size_t lines() const { return output_lines; }
+
+    bool isExact() const { return exact; }
+
+    const std::string& encoded() const { return mappings; }
+
+    // Linea de entrada de cada linea de salida
+    std::vector<uint32_t> decode() const;
+
+    // Decodifica el mapa ya codificado y comprueba que tenga una linea por cada
+    // linea de 'output' y que todas apunten a lineas de 'input'
+    bool matches(std::string_view input, std::string_view output) const;
+
+    // Archivo .map; 'file' es la salida y 'source' la entrada, como se escriben en el JSON
+    std::string json(std::string_view file, std::string_view source) const;
+
+private:
+    void add(size_t input_line);
+
+    static void appendVlq(std::string& out, int64_t value);
+
+    static constexpr char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+};
+
+
+inline void SourceMap::clear()
+{
+    mappings.clear();
+    output_lines = 0;
+    previous_input = 0;
+    line_open = false;
+    exact = true;
+}
+
+inline void SourceMap::addSpan(std::string_view output, size_t first_input, size_t input_lines)
+{
+    // Lineas que empiezan en 'output'
+    size_t started = 0;
+    bool open = line_open;
+    for (size_t pos = 0; pos < output.size();) {
+        if (!open) {
+            ++started;
+            open = true;
+        }
+
+        size_t newline = output.find('\n', pos);
+        if (newline == std::string_view::npos) break;
+        open = false;
+        pos = newline + 1;
+    }
+    line_open = open;
+
+    bool one_to_one = started == input_lines;
+    for (size_t i = 0; i < started; ++i) {
+        add(first_input + (one_to_one ? i : 0));
+    }
+}
+
+inline void SourceMap::approximate(std::string_view input, std::string_view output)
+{
+    constexpr size_t lookahead = 8;
+
+    clear();
+    exact = false;
+
+    std::vector<std::string_view> input_lines;
+    forEachLine(input, [&](std::string_view line, bool) { input_lines.push_back(line); });
+
+    size_t next = 0;
+    forEachLine(output, [&](std::string_view line, bool) {
+        size_t limit = std::min(input_lines.size(), next + lookahead);
+        for (size_t i = next; i < limit; ++i) {
+            if (input_lines[i] == line) {
+                next = i + 1;
+                add(i);
+                return;
+            }
+        }
+        add(next == 0 ? 0 : next - 1);
+    });
+}
+
+inline void SourceMap::add(size_t input_line)
+{
+    if (output_lines > 0) mappings += ';';
+
+    // Columna de salida, indice de la fuente, linea y columna de entrada
+    int64_t line = static_cast<int64_t>(input_line);
+    appendVlq(mappings, 0);
+    appendVlq(mappings, 0);
+    appendVlq(mappings, line - previous_input);
+    appendVlq(mappings, 0);
+
+    previous_input = line;
+    ++output_lines;
+}
+
+inline void SourceMap::appendVlq(std::string& out, int64_t value)
+{
+    uint64_t bits = value < 0 ? (static_cast<uint64_t>(-value) << 1) | 1 : static_cast<uint64_t>(value) << 1;
+    do {
+        unsigned digit = bits & 31;
+        bits >>= 5;
+        if (bits != 0) digit |= 32;
+        out += base64[digit];
+    } while (bits != 0);
+}
+
+inline std::vector<uint32_t> SourceMap::decode() const
+{
+    std::vector<uint32_t> result;
+    int64_t line = 0;
+    size_t field = 0;
+    uint64_t bits = 0;
+    unsigned shift = 0;
+
+    for (char c : mappings) {
+        if (c == ';' || c == ',') {
+            field = 0;
+            continue;
+        }
+
+        const char* found = std::find(base64, base64 + 64, c);
+        unsigned digit = static_cast<unsigned>(found - base64);
+        bits |= static_cast<uint64_t>(digit & 31) << shift;
+        shift += 5;
+        if (digit & 32) continue;
+
+        int64_t value = (bits & 1) ? -static_cast<int64_t>(bits >> 1) : static_cast<int64_t>(bits >> 1);
+        bits = 0;
+        shift = 0;
+
+        // Solo el primer segmento de cada linea tiene la linea de entrada
+        if (field == 2) {
+            line += value;
+            result.push_back(static_cast<uint32_t>(line));
+        }
+        ++field;
+    }
+    return result;
+}
+
+inline bool SourceMap::matches(std::string_view input, std::string_view output) const
+{
+    size_t input_lines = 0;
+    size_t expected_lines = 0;
+    forEachLine(input, [&](std::string_view, bool) { ++input_lines; });
+    forEachLine(output, [&](std::string_view, bool) { ++expected_lines; });
+
+    // Una entrada vacia puede generar lineas (los #include agregados): apuntan a la 0
+    std::vector<uint32_t> lines = decode();
+    return lines.size() == expected_lines && std::all_of(lines.begin(), lines.end(), [&](uint32_t line) {
+        return line < std::max<size_t>(input_lines, 1);
+    });
+}
+
+inline std::string SourceMap::json(std::string_view file, std::string_view source) const
+{
+    std::string out = "{\"version\":3,\"file\":";
+    JsonLine::appendString(out, file);
+    out += ",\"sources\":[";
+    JsonLine::appendString(out, source);
+    out += "],\"names\":[],\"x_exact\":";
+    out += exact ? "true" : "false";
+    out += ",\"mappings\":\"";
+    out += mappings;
+    out += "\"}\n";
+    return out;
+}
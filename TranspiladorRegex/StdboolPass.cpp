@@ -0,0 +1,81 @@
+// Pase registrado fuera de Transpiler.cpp: quita "#include <stdbool.h>", que en C++
+// no hace falta porque bool, true y false son palabras clave. No forma parte de
+// "all"; se pide por nombre, p. ej. --passes=all,stdbool
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CLexer.hpp"
+#include "PassRegistry.hpp"
+#include "SourceLines.hpp"
+
+namespace {
+
+    // Tramo [start, end) de la directiva si la linea incluye <stdbool.h>. Se buscan
+    // los tokens del lexer, asi que no cuentan las directivas dentro de comentarios
+    // o literales; "# include" y "#include<stdbool.h>" tambien son directivas
+    bool findStdboolInclude(std::string_view line, const std::vector<Token>& tokens, size_t& start, size_t& end)
+    {
+        for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+            const Token& directive = tokens[i];
+            const Token& header = tokens[i + 1];
+            if (directive.kind != TokenKind::Preprocessor || header.kind != TokenKind::HeaderName ||
+                line.substr(header.offset, header.length) != "<stdbool.h>") {
+                continue;
+            }
+
+            std::string_view name = line.substr(directive.offset + 1, directive.length - 1);
+            if (name.substr(name.find_first_not_of(" \t")) != "include") continue;
+
+            start = directive.offset;
+            end = header.end();
+            return true;
+        }
+        return false;
+    }
+
+    std::string removeStdbool(TranspilerPipeline&, std::string_view input)
+    {
+        std::string result;
+        result.reserve(input.size());
+
+        CLexer lexer;
+        LexState lex_state;
+        std::vector<Token> tokens;
+
+        forEachLine(input, [&](std::string_view line, bool has_newline) {
+            tokens.clear();
+            lexer.tokenizeLine(line, has_newline, lex_state, tokens);
+
+            size_t start = 0;
+            size_t end = 0;
+            if (!findStdboolInclude(line, tokens, start, end)) {
+                result.append(line);
+                if (has_newline) result += '\n';
+                return;
+            }
+
+            // Lo que queda de la linea (un comentario al final, p. ej.) se conserva;
+            // si no queda nada, la linea desaparece
+            std::string rest(line.substr(0, start));
+            rest.append(line.substr(end));
+            if (rest.find_first_not_of(" \t\r") == std::string::npos) return;
+
+            result += rest;
+            if (has_newline) result += '\n';
+        });
+        return result;
+    }
+
+    PassInfo stdboolPass()
+    {
+        PassInfo pass;
+        pass.name = "stdbool";
+        pass.triggers = { "stdbool.h" };
+        pass.after = { "printf" };
+        pass.in_all = false;
+        pass.run = removeStdbool;
+        return pass;
+    }
+
+    const PassRegistration stdbool_registration{ stdboolPass() };
+}
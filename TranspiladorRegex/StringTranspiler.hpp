@@ -1,397 +1,555 @@
 #pragma once
-#include <regex>
+#include <array>
 #include <set>
 #include <sstream>
 #include <string>
+#include "CLexer.hpp"
+#include "EditList.hpp"
+#include "PatternMatchers.hpp"
+#include "IncludeRewriter.hpp"
+#include "KeywordPrefilter.hpp"
+#include "SourceLines.hpp"
+#include "TranspilerStats.hpp"
+
+// Como se resuelven las operaciones (strcpy/strcmp), que dependen de todas las
+// declaraciones del archivo
+enum class StringOperationMode {
+    Deferred,              // se acumulan las lineas y se procesan en endStream
+    Immediate,             // se procesan al momento; ver streamInvalidated()
+    CollectDeclarations    // solo se registran las declaraciones; no hay salida
+};
 
-
+// Las reglas no cambian durante un recorrido: el estado vive en un Context, y un
+// mismo StringTranspiler puede usarse desde varios hilos a la vez
 class StringTranspiler {
-
-    struct StringRegion {
-        size_t start;
-        size_t length;
-
-        StringRegion(size_t s, size_t l) : start(s), length(l) {}
+public:
+    // Estado de un recorrido
+    struct Context {
+        IncludeRewriter::Context include;
+        IncludeRewriter::Context header;
+
+        // Estado del lexer de cada etapa (declaraciones y operaciones) entre lineas
+        LexState declaration_lex_state;
+        LexState operation_lex_state;
+        std::vector<Token> line_tokens;
+        std::vector<ProtectedRegion> protected_regions;
+
+        // Reemplazos de la linea en curso, aplicados de una sola vez al final
+        EditList line_edits;
+
+        // Set para rastrear variables que han sido convertidas a std::string
+        std::set<std::string> converted_strings;
+
+        // Variables conocidas de antemano (ver useKnownStrings); no se copian
+        const std::set<std::string>* known_strings = nullptr;
+
+        // Las declaradas en el recorrido en curso, sin las agregadas con addConvertedStrings,
+        // y en modo inmediato todas las consultadas por alguna operacion
+        std::set<std::string> stream_declarations;
+        std::set<std::string> stream_lookups;
+
+        StringOperationMode operation_mode = StringOperationMode::Deferred;
+        std::string deferred_lines;
+
+        // En modo inmediato: variables que decidieron una operacion por no estar
+        // convertidas todavia. Si alguna se declara despues, el resultado no es valido
+        std::set<std::string> unconverted_lookups;
+
+        // Verdadero si una operacion procesada en modo inmediato habria cambiado con
+        // declaraciones posteriores; el resultado del recorrido no es valido
+        bool stream_invalidated = false;
+
+        // Verdadero si ningun estado pasa de la ultima linea procesada a la siguiente
+        bool idle() const {
+            return declaration_lex_state == LexState{} && operation_lex_state == LexState{} &&
+                include.idle() && header.idle();
+        }
     };
 
 private:
-    // Expresion regular para char array con inicializacion de string literal
-    // Ejemplo: char str[] = "hello", char name[50] = "world"
-    std::regex char_array_init_pattern{
-        R"(\bchar\s+([A-Za-z_][A-Za-z0-9_]*)\s*\[\s*(\d*)\s*\]\s*=\s*("[^"]*"))"
-    };
+    // Patrones reconocidos (ver PatternMatchers.hpp):
+    // CharArrayInitPattern: char str[] = "hello", char name[50] = "world"
+    // CharPointerInitPattern: char* str = "hello"
+    // StrcpyCallPattern: strcpy(dest, "source"), strcpy(dest, src)
+    // StrcmpCallPattern: strcmp(str1, str2), strcmp(str, "literal")
 
-    // Expresion regular para char pointer con inicializacion de string literal
-    // Ejemplo: char* str = "hello"
-    std::regex char_pointer_init_pattern{
-        R"(\bchar\s*\*\s*([A-Za-z_][A-Za-z0-9_]*)\s*=\s*("[^"]*"))"
-    };
+    // Lexer compartido para ubicar comentarios
+    CLexer lexer;
 
-    // Expresion regular para strcpy calls
-    // Ejemplo: strcpy(dest, "source"), strcpy(dest, src)
-    std::regex strcpy_pattern{
-        R"(\bstrcpy\s*\(\s*([A-Za-z_][A-Za-z0-9_]*)\s*,\s*([^)]+)\s*\))"
-    };
+    // Inserta #include <string> y comenta las directivas de <string.h>
+    IncludeRewriter include_rewriter{ "#include <string>" };
+    IncludeRewriter header_rewriter{ "", "<string.h>", "// #include <string.h> // Reemplazado por <string>" };
 
-    // Expresion regular para strcmp calls
-    // Ejemplo: strcmp(str1, str2), strcmp(str, "literal")
-    std::regex strcmp_pattern{
-        R"(\bstrcmp\s*\(\s*([^,]+)\s*,\s*([^)]+)\s*\))"
-    };
+public:
+    std::string transpileFile(std::string_view content) const;
 
-    // Expresion regular para detectar strings literales
-    std::regex string_literal_pattern{
-        R"("([^"\\]|\\.)*")"
-    };
+    // Procesamiento linea a linea para el pipeline fusionado y el modo por tramos
+    void beginStream(Context& context, bool insert_include, bool prepend_include, StringOperationMode mode,
+        std::string& out) const;
 
-    // Expresion regular para detectar comentarios
-    std::regex comment_pattern{
-        R"(//.*$|/\*.*?\*/)"
-    };
+    // Variables ya conocidas como std::string (p. ej. reunidas con
+    // CollectDeclarations en un recorrido previo); llamar despues de beginStream.
+    // Se consultan sin copiarlas: 'names' debe seguir vivo hasta endStream
+    void useKnownStrings(Context& context, const std::set<std::string>& names) const;
 
-    // Set para rastrear variables que han sido convertidas a std::string
-    std::set<std::string> converted_strings;
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const;
 
-public:
-    std::string transpileFile(const std::string& content);
+    // 'triggers' son los bits de KeywordPrefilter ya calculados para la linea
+    void transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
+
+    void endStream(Context& context, std::string& out) const;
 
 private:
-    std::string addStringInclude(const std::string& content);
+    void transpileStringDeclarations(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
 
-    std::string replaceStringHeader(const std::string& content);
+    void transpileStringOperations(Context& context, std::string_view line, bool has_newline, std::string& out,
+        unsigned triggers) const;
 
-    std::string transpileStringDeclarations(const std::string& content);
+    std::string processStringDeclarationLine(Context& context, const std::string& line) const;
 
-    std::string transpileStringOperations(const std::string& content);
+    std::string processStringOperationLine(Context& context, const std::string& line) const;
 
-    std::string processStringDeclarationLine(const std::string& line);
+    std::string processLineWithLiterals(Context& context, const std::string& line, bool isDeclaration) const;
 
-    std::string processStringOperationLine(const std::string& line);
+    // Cada etapa busca sobre el texto original del tramo [begin, end) y registra
+    // sus reemplazos en 'edits'
+    void processStringDeclarations(Context& context, const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    bool containsStringLiteralOrComment(const std::string& line);
+    void processStringOperations(Context& context, const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    std::string processLineWithLiterals(const std::string& line, bool isDeclaration);
+    void processCharArrayInit(Context& context, const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    std::string processStringDeclarations(const std::string& line);
+    void processCharPointerInit(Context& context, const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    std::string processStringOperations(const std::string& line);
+    void processStrcpyCalls(Context& context, const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    std::string processCharArrayInit(const std::string& line);
+    void processStrcmpCalls(Context& context, const std::string& line, size_t begin, size_t end, EditList& edits) const;
 
-    std::string processCharPointerInit(const std::string& line);
+    // Consulta converted_strings y, en modo inmediato, recuerda la variable consultada
+    bool isConvertedString(Context& context, const std::string& name) const;
 
-    std::string processStrcpyCalls(const std::string& line);
+    // En modo inmediato recuerda las variables ausentes
+    void recordUnconverted(Context& context, const std::string& name) const;
 
-    std::string processStrcmpCalls(const std::string& line);
+    // Operadores que deciden la conversion de strcmp: se buscan en todo el texto
+    // anterior a la llamada y en todo el posterior a "strcmp"
+    static constexpr std::array<std::string_view, 6> operators_before{ "== 0", "!= 0", "< 0", "> 0", "<=", ">=" };
+    static constexpr std::array<std::string_view, 4> operators_after{ "== 0", "!= 0", "< 0", "> 0" };
 
-    std::string determineComparisonOperator(const std::string& line, size_t strcmp_pos);
+    // 'before' y 'after' indican que operadores aparecen a cada lado del strcmp
+    std::string determineComparisonOperator(const std::array<bool, operators_before.size()>& before,
+        const std::array<bool, operators_after.size()>& after) const;
 
-    std::vector<StringRegion> findProtectedRegions(const std::string& line);
+    void findProtectedRegions(const std::vector<Token>& tokens, size_t line_length,
+        std::vector<ProtectedRegion>& protected_regions) const;
 
-    std::string trim(const std::string& str);
+    std::string trim(const std::string& str) const;
 };
 
 
 
 
-std::string StringTranspiler::transpileFile(const std::string& content) {
-    std::string result = content;
+inline std::string StringTranspiler::transpileFile(std::string_view content) const {
+    std::string result;
+    result.reserve(content.size() + content.size() / 16 + 32);
 
-    converted_strings.clear();
+    bool insert_include = content.find("#include <string>") == std::string_view::npos;
+    bool prepend_include = insert_include && !lexer.hasIncludeDirective(content);
 
-    result = addStringInclude(result);
+    Context context;
+    beginStream(context, insert_include, prepend_include, StringOperationMode::Deferred, result);
+    KeywordPrefilter::shared().forEachLine(content, [&](std::string_view line, bool has_newline, unsigned triggers) {
+        transpileLine(context, line, has_newline, result, triggers);
+    });
+    endStream(context, result);
 
-    result = replaceStringHeader(result);
+    return result;
+}
 
-    result = transpileStringDeclarations(result);
+inline void StringTranspiler::beginStream(Context& context, bool insert_include, bool prepend_include, StringOperationMode mode,
+    std::string& out) const {
+    context.converted_strings.clear();
+    context.known_strings = nullptr;
+    context.stream_declarations.clear();
+    context.stream_lookups.clear();
+
+    context.declaration_lex_state = LexState{};
+    context.operation_lex_state = LexState{};
+    context.operation_mode = mode;
+    context.deferred_lines.clear();
+    context.unconverted_lookups.clear();
+    context.stream_invalidated = false;
+
+    header_rewriter.begin(context.header, false, false, [](std::string_view, bool) {});
+    include_rewriter.begin(context.include, insert_include, prepend_include, [&](std::string_view line, bool has_newline) {
+        unsigned triggers = KeywordPrefilter::shared().scan(line);
+        header_rewriter.rewriteLine(context.header, line, has_newline, triggers,
+            [&](std::string_view rewritten, bool rewritten_newline) {
+                transpileStringDeclarations(context, rewritten, rewritten_newline, out,
+                    KeywordPrefilter::rescanIfChanged(line, rewritten, triggers));
+            });
+    });
+}
 
-    result = transpileStringOperations(result);
+inline void StringTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out) const {
+    transpileLine(context, line, has_newline, out, KeywordPrefilter::shared().scan(line));
+}
 
-    return result;
+inline void StringTranspiler::transpileLine(Context& context, std::string_view line, bool has_newline, std::string& out,
+    unsigned triggers) const {
+    include_rewriter.rewriteLine(context.include, line, has_newline, triggers,
+        [&](std::string_view included, bool included_newline) {
+            unsigned included_triggers = KeywordPrefilter::rescanIfChanged(line, included, triggers);
+            header_rewriter.rewriteLine(context.header, included, included_newline, included_triggers,
+                [&](std::string_view rewritten, bool rewritten_newline) {
+                    transpileStringDeclarations(context, rewritten, rewritten_newline, out,
+                        KeywordPrefilter::rescanIfChanged(included, rewritten, included_triggers));
+                });
+        });
 }
 
-std::string StringTranspiler::addStringInclude(const std::string& content) {
-    std::string result = content;
+inline void StringTranspiler::useKnownStrings(Context& context, const std::set<std::string>& names) const {
+    context.known_strings = &names;
+}
 
-    if (result.find("#include <string>") == std::string::npos) {
-        std::regex include_pattern(R"(#include\s*[<"][^>"]*[>"])");
-        std::smatch match;
+inline void StringTranspiler::endStream(Context& context, std::string& out) const {
+    if (context.operation_mode == StringOperationMode::Deferred) {
+        // Todas las declaraciones ya se conocen
+        KeywordPrefilter::shared().forEachLine(context.deferred_lines,
+            [&](std::string_view line, bool has_newline, unsigned triggers) {
+                transpileStringOperations(context, line, has_newline, out, triggers);
+            });
+        context.deferred_lines.clear();
+        return;
+    }
 
-        if (std::regex_search(result, match, include_pattern)) {
-            size_t pos = match.position() + match.length();
-            result.insert(pos, "\n#include <string>");
-        }
-        else {
-            result = "#include <string>\n" + result;
+    // Las decisiones solo dependen de si cada variable estaba convertida: si
+    // ninguna de las ausentes se declaro despues, coinciden con las del set final
+    for (const auto& name : context.unconverted_lookups) {
+        if (context.converted_strings.count(name) != 0) {
+            context.stream_invalidated = true;
+            break;
         }
     }
-
-    return result;
+    context.unconverted_lookups.clear();
 }
 
-std::string StringTranspiler::replaceStringHeader(const std::string& content) {
-    std::string result = content;
+inline void StringTranspiler::transpileStringDeclarations(Context& context, std::string_view line, bool has_newline,
+    std::string& out, unsigned triggers) const {
+    StringOperationMode operation_mode = context.operation_mode;
 
-    result = std::regex_replace(result,
-        std::regex(R"(#include\s*<string\.h>)"),
-        "// #include <string.h> // Reemplazado por <string>");
+    // Sin "char" no hay declaraciones que convertir
+    if ((triggers & trigger_string_declaration) == 0) {
+        lexer.skipLine(line, has_newline, context.declaration_lex_state, (triggers & trigger_lexer) == 0);
 
-    return result;
-}
-
-std::string StringTranspiler::transpileStringDeclarations(const std::string& content) {
-    std::istringstream iss(content);
-    std::string line;
-    std::string processed_content;
-
-    while (std::getline(iss, line)) {
-        std::string processed_line = processStringDeclarationLine(line);
-        processed_content += processed_line + "\n";
+        if (operation_mode == StringOperationMode::Deferred) {
+            context.deferred_lines.append(line);
+            context.deferred_lines += '\n';
+        }
+        else if (operation_mode == StringOperationMode::Immediate) {
+            transpileStringOperations(context, line, true, out, triggers);
+        }
+        return;
     }
 
-    return processed_content;
-}
+    context.line_tokens.clear();
+    lexer.tokenizeLine(line, has_newline, context.declaration_lex_state, context.line_tokens);
+    findProtectedRegions(context.line_tokens, line.size(), context.protected_regions);
 
-std::string StringTranspiler::transpileStringOperations(const std::string& content) {
-    std::istringstream iss(content);
-    std::string line;
-    std::string processed_content;
+    std::string declared = processStringDeclarationLine(context, std::string(line));
+    declared += '\n';
 
-    while (std::getline(iss, line)) {
-        std::string processed_line = processStringOperationLine(line);
-        processed_content += processed_line + "\n";
+    if (operation_mode == StringOperationMode::Deferred) {
+        context.deferred_lines += declared;
+        return;
+    }
+    if (operation_mode == StringOperationMode::CollectDeclarations) {
+        return;
     }
 
-    return processed_content;
+    // Una declaracion puede convertirse en varias lineas
+    forEachLine(declared, [&](std::string_view declared_line, bool) {
+        transpileStringOperations(context, declared_line, true, out, KeywordPrefilter::shared().scan(declared_line));
+    });
 }
 
-std::string StringTranspiler::processStringDeclarationLine(const std::string& line) {
-    if (containsStringLiteralOrComment(line)) {
-        return processLineWithLiterals(line, true);
+inline void StringTranspiler::transpileStringOperations(Context& context, std::string_view line, bool has_newline,
+    std::string& out, unsigned triggers) const {
+    // Sin strcpy ni strcmp la linea no cambia
+    if ((triggers & trigger_string_operation) == 0) {
+        lexer.skipLine(line, has_newline, context.operation_lex_state, (triggers & trigger_lexer) == 0);
+        out.append(line);
+        out += '\n';
+        return;
     }
 
-    return processStringDeclarations(line);
-}
+    context.line_tokens.clear();
+    lexer.tokenizeLine(line, has_newline, context.operation_lex_state, context.line_tokens);
 
-std::string StringTranspiler::processStringOperationLine(const std::string& line) {
-    if (containsStringLiteralOrComment(line)) {
-        return processLineWithLiterals(line, false);
-    }
+    findProtectedRegions(context.line_tokens, line.size(), context.protected_regions);
+
+    out += processStringOperationLine(context, std::string(line));
+    out += '\n';
+}
 
-    return processStringOperations(line);
+inline std::string StringTranspiler::processStringDeclarationLine(Context& context, const std::string& line) const {
+    return processLineWithLiterals(context, line, true);
 }
 
-bool StringTranspiler::containsStringLiteralOrComment(const std::string& line) {
-    std::smatch match;
-    return std::regex_search(line, match, string_literal_pattern) ||
-        std::regex_search(line, match, comment_pattern);
+inline std::string StringTranspiler::processStringOperationLine(Context& context, const std::string& line) const {
+    return processLineWithLiterals(context, line, false);
 }
 
-std::string StringTranspiler::processLineWithLiterals(const std::string& line, bool isDeclaration) {
-    std::vector<StringRegion> protected_regions = findProtectedRegions(line);
+inline std::string StringTranspiler::processLineWithLiterals(Context& context, const std::string& line, bool isDeclaration) const {
+    EditList& line_edits = context.line_edits;
+    line_edits.clear();
+
+    // Los comentarios separan la linea en tramos que se procesan por separado
+    auto process_segment = [&](size_t begin, size_t end) {
+        if (isDeclaration) {
+            processStringDeclarations(context, line, begin, end, line_edits);
+        }
+        else {
+            processStringOperations(context, line, begin, end, line_edits);
+        }
+    };
 
-    std::string processed_line;
     size_t last_pos = 0;
 
-    for (const auto& region : protected_regions) {
+    for (const auto& region : context.protected_regions) {
         if (region.start > last_pos) {
-            std::string segment = line.substr(last_pos, region.start - last_pos);
-            if (isDeclaration) {
-                segment = processStringDeclarations(segment);
-            }
-            else {
-                segment = processStringOperations(segment);
-            }
-            processed_line += segment;
+            process_segment(last_pos, region.start);
         }
-
-        processed_line += line.substr(region.start, region.length);
         last_pos = region.start + region.length;
     }
 
     if (last_pos < line.length()) {
-        std::string segment = line.substr(last_pos);
-        if (isDeclaration) {
-            segment = processStringDeclarations(segment);
-        }
-        else {
-            segment = processStringOperations(segment);
-        }
-        processed_line += segment;
+        process_segment(last_pos, line.length());
     }
 
-    return processed_line;
-}
-
-std::string StringTranspiler::processStringDeclarations(const std::string& line) {
-    std::string result = line;
-
-    result = processCharArrayInit(result);
-
-    result = processCharPointerInit(result);
+    if (line_edits.empty()) {
+        return line;
+    }
 
-    return result;
+    return line_edits.apply(line);
 }
 
-std::string StringTranspiler::processStringOperations(const std::string& line) {
-    std::string result = line;
+inline void StringTranspiler::processStringDeclarations(Context& context, const std::string& line, size_t begin, size_t end,
+    EditList& edits) const {
+    processCharArrayInit(context, line, begin, end, edits);
 
-    result = processStrcpyCalls(result);
+    processCharPointerInit(context, line, begin, end, edits);
+}
 
-    result = processStrcmpCalls(result);
+inline void StringTranspiler::processStringOperations(Context& context, const std::string& line, size_t begin, size_t end,
+    EditList& edits) const {
+    processStrcpyCalls(context, line, begin, end, edits);
 
-    return result;
+    processStrcmpCalls(context, line, begin, end, edits);
 }
 
-std::string StringTranspiler::processCharArrayInit(const std::string& line) {
-    std::string result = line;
-    std::smatch match;
-
-    while (std::regex_search(result, match, char_array_init_pattern)) {
-        std::string var_name = trim(match[1].str());
-        std::string array_size = trim(match[2].str());
-        std::string string_literal = match[3].str();
+inline void StringTranspiler::processCharArrayInit(Context& context, const std::string& line, size_t begin, size_t end,
+    EditList& edits) const {
+    std::string_view segment = std::string_view(line).substr(begin, end - begin);
 
-        converted_strings.insert(var_name);
+    forEachPatternMatch<CharArrayInitPattern>(segment, [&](const PatternMatch& match) {
+        std::string var_name = trim(match.str(1));
+        std::string array_size = trim(match.str(2));
+        std::string string_literal = match.str(3);
 
         std::string replacement = "std::string " + var_name + " = " + string_literal +
             "; // Convertido de char array";
 
-        size_t pos = match.position();
-        size_t len = match.length();
-        result.replace(pos, len, replacement);
-    }
-
-    return result;
+        if (edits.replace(begin + match.position, match.length, std::move(replacement))) {
+            TranspilerStats::countRule(StatsRule::StringCharArray);
+            context.converted_strings.insert(var_name);
+            context.stream_declarations.insert(var_name);
+        }
+    });
 }
 
-std::string StringTranspiler::processCharPointerInit(const std::string& line) {
-    std::string result = line;
-    std::smatch match;
-
-    while (std::regex_search(result, match, char_pointer_init_pattern)) {
-        std::string var_name = trim(match[1].str());
-        std::string string_literal = match[2].str();
+inline void StringTranspiler::processCharPointerInit(Context& context, const std::string& line, size_t begin, size_t end,
+    EditList& edits) const {
+    std::string_view segment = std::string_view(line).substr(begin, end - begin);
 
-        converted_strings.insert(var_name);
+    forEachPatternMatch<CharPointerInitPattern>(segment, [&](const PatternMatch& match) {
+        std::string var_name = trim(match.str(1));
+        std::string string_literal = match.str(2);
 
         std::string replacement = "std::string " + var_name + " = " + string_literal +
             "; // Convertido de char*";
 
-        size_t pos = match.position();
-        size_t len = match.length();
-        result.replace(pos, len, replacement);
-    }
-
-    return result;
+        if (edits.replace(begin + match.position, match.length, std::move(replacement))) {
+            TranspilerStats::countRule(StatsRule::StringCharPointer);
+            context.converted_strings.insert(var_name);
+            context.stream_declarations.insert(var_name);
+        }
+    });
 }
 
-std::string StringTranspiler::processStrcpyCalls(const std::string& line) {
-    std::string result = line;
-    std::smatch match;
+inline void StringTranspiler::processStrcpyCalls(Context& context, const std::string& line, size_t begin, size_t end,
+    EditList& edits) const {
+    std::string_view segment = std::string_view(line).substr(begin, end - begin);
+    PatternMatch match;
+
+    // Las llamadas que se dejan sin convertir se saltan un caracter a la vez
+    size_t search_from = 0;
 
-    while (std::regex_search(result, match, strcpy_pattern)) {
-        std::string dest = trim(match[1].str());
-        std::string source = trim(match[2].str());
+    while (search_from < segment.size() && searchPattern<StrcpyCallPattern>(segment, search_from, match)) {
+        std::string dest = trim(match.str(1));
+        std::string source = trim(match.str(2));
 
-        if (converted_strings.find(dest) != converted_strings.end()) {
+        if (isConvertedString(context, dest)) {
             std::string replacement = dest + " = " + source + "; // Convertido de strcpy";
 
-            size_t pos = match.position();
-            size_t len = match.length();
-            result.replace(pos, len, replacement);
+            if (edits.replace(begin + match.position, match.length, std::move(replacement))) {
+                TranspilerStats::countRule(StatsRule::StringStrcpy);
+            }
+            search_from = match.end();
+        }
+        else {
+            recordUnconverted(context, dest);
+            search_from = match.position + 1;
         }
     }
-
-    return result;
 }
 
-std::string StringTranspiler::processStrcmpCalls(const std::string& line) {
-    std::string result = line;
-    std::smatch match;
-
-    while (std::regex_search(result, match, strcmp_pattern)) {
-        std::string str1 = trim(match[1].str());
-        std::string str2 = trim(match[2].str());
-
-        bool str1_converted = converted_strings.find(str1) != converted_strings.end();
-        bool str2_converted = converted_strings.find(str2) != converted_strings.end();
+inline void StringTranspiler::processStrcmpCalls(Context& context, const std::string& line, size_t begin, size_t end,
+    EditList& edits) const {
+    std::string_view segment = std::string_view(line).substr(begin, end - begin);
+    PatternMatch match;
+
+    // El operador depende del texto del tramo con los reemplazos previos ya aplicados.
+    // Para no reconstruirlo en cada llamada (cuadratico en lineas con muchas): 'current'
+    // es el tramo con los reemplazos que habia al convertir el primer strcmp, y lo
+    // posterior a cada llamada se busca ahi, porque los strcmp convertidos quedan
+    // siempre antes de la llamada en curso. Lo anterior se acumula en 'before' con
+    // todos los reemplazos, revisando solo el texto agregado
+    std::string current;
+    std::array<size_t, operators_after.size()> last_after{};
+    std::string before;
+    size_t before_end = begin;
+    size_t added_size = 0;
+    size_t removed_size = 0;
+    std::array<bool, operators_before.size()> found_before{};
+
+    // Las comparaciones que se dejan sin convertir se saltan un caracter a la vez
+    size_t search_from = 0;
+
+    while (search_from < segment.size() && searchPattern<StrcmpCallPattern>(segment, search_from, match)) {
+        std::string str1 = trim(match.str(1));
+        std::string str2 = trim(match.str(2));
+
+        size_t pos = begin + match.position;
+
+        bool str1_converted = isConvertedString(context, str1);
+        bool str2_converted = isConvertedString(context, str2);
+
+        // Con una de las dos convertida la decision ya no depende de la otra
+        if (!str1_converted && !str2_converted) {
+            recordUnconverted(context, str1);
+            recordUnconverted(context, str2);
+        }
 
-        if (str1_converted || str2_converted) {
-            std::string comparison_op = determineComparisonOperator(result, match.position());
-            std::string replacement = "(" + str1 + " " + comparison_op + " " + str2 + ")";
+        if ((str1_converted || str2_converted) && !edits.overlaps(pos, match.length)) {
+            if (current.empty()) {
+                edits.applyRange(line, begin, end, current);
+                for (size_t i = 0; i < operators_after.size(); ++i) {
+                    last_after[i] = current.rfind(operators_after[i]);
+                }
+            }
 
-            size_t pos = match.position();
-            size_t len = match.length();
-            result.replace(pos, len, replacement + " /* Convertido de strcmp */");
-        }
-    }
+            size_t scanned = before.size() >= 3 ? before.size() - 3 : 0;
+            edits.applyRange(line, before_end, pos, before);
+            before_end = pos;
+            for (size_t i = 0; i < operators_before.size(); ++i) {
+                found_before[i] = found_before[i] || before.find(operators_before[i], scanned) != std::string::npos;
+            }
 
-    return result;
-}
+            // "strcmp" no tiene reemplazos: lo posterior empieza 6 caracteres despues
+            size_t after_start = before.size() + removed_size - added_size + 6;
+            std::array<bool, operators_after.size()> found_after{};
+            for (size_t i = 0; i < operators_after.size(); ++i) {
+                found_after[i] = last_after[i] != std::string::npos && last_after[i] >= after_start;
+            }
 
-std::string StringTranspiler::determineComparisonOperator(const std::string& line, size_t strcmp_pos) {
-    if (strcmp_pos > 0) {
-        std::string before = line.substr(0, strcmp_pos);
+            std::string comparison_op = determineComparisonOperator(found_before, found_after);
+            std::string replacement = "(" + str1 + " " + comparison_op + " " + str2 + ") /* Convertido de strcmp */";
 
-        if (before.find("== 0") != std::string::npos ||
-            before.find("!= 0") != std::string::npos) {
-            return "=="; 
-        }
-        if (before.find("< 0") != std::string::npos) {
-            return "<";  
+            added_size += replacement.size();
+            removed_size += match.length;
+            edits.replace(pos, match.length, std::move(replacement));
+            TranspilerStats::countRule(StatsRule::StringStrcmp);
+            search_from = match.end();
         }
-        if (before.find("> 0") != std::string::npos) {
-            return ">";  
-        }
-        if (before.find("<=") != std::string::npos) {
-            return "<=";
-        }
-        if (before.find(">=") != std::string::npos) {
-            return ">=";
+        else {
+            search_from = match.position + 1;
         }
     }
+}
 
-    size_t after_pos = strcmp_pos + 6; 
-    if (after_pos < line.length()) {
-        std::string after = line.substr(after_pos);
-        if (after.find("== 0") != std::string::npos) {
-            return "==";
-        }
-        if (after.find("!= 0") != std::string::npos) {
-            return "!=";
-        }
-        if (after.find("< 0") != std::string::npos) {
-            return "<";
-        }
-        if (after.find("> 0") != std::string::npos) {
-            return ">";
-        }
+inline bool StringTranspiler::isConvertedString(Context& context, const std::string& name) const {
+    if (context.operation_mode == StringOperationMode::Immediate) {
+        context.stream_lookups.insert(name);
     }
-
-    return "==";
+    return context.converted_strings.find(name) != context.converted_strings.end() ||
+        (context.known_strings != nullptr && context.known_strings->count(name) != 0);
 }
 
-std::vector<StringTranspiler::StringRegion> StringTranspiler::findProtectedRegions(const std::string& line) {
-    std::vector<StringRegion> regions;
+inline void StringTranspiler::recordUnconverted(Context& context, const std::string& name) const {
+    if (context.operation_mode == StringOperationMode::Immediate) {
+        context.unconverted_lookups.insert(name);
+    }
+}
 
-    std::sregex_iterator iter(line.begin(), line.end(), comment_pattern);
-    std::sregex_iterator end;
+inline std::string StringTranspiler::determineComparisonOperator(const std::array<bool, operators_before.size()>& before,
+    const std::array<bool, operators_after.size()>& after) const {
+    // "== 0", "!= 0", "< 0", "> 0", "<=", ">="
+    if (before[0] || before[1]) {
+        return "==";
+    }
+    if (before[2]) {
+        return "<";
+    }
+    if (before[3]) {
+        return ">";
+    }
+    if (before[4]) {
+        return "<=";
+    }
+    if (before[5]) {
+        return ">=";
+    }
 
-    for (; iter != end; ++iter) {
-        const std::smatch& match = *iter;
-        regions.emplace_back(match.position(), match.length());
+    // "== 0", "!= 0", "< 0", "> 0"
+    if (after[0]) {
+        return "==";
+    }
+    if (after[1]) {
+        return "!=";
+    }
+    if (after[2]) {
+        return "<";
+    }
+    if (after[3]) {
+        return ">";
     }
 
-    std::sort(regions.begin(), regions.end(),
-        [](const StringRegion& a, const StringRegion& b) {
-            return a.start < b.start;
-        });
+    return "==";
+}
 
-    return regions;
+inline void StringTranspiler::findProtectedRegions(const std::vector<Token>& tokens, size_t line_length,
+    std::vector<ProtectedRegion>& protected_regions) const {
+    // Solo se protegen comentarios: los literales de cadena forman parte
+    // de las declaraciones que este transpilador convierte
+    size_t cursor = 0;
+    CLexer::collectProtectedRegions(tokens, cursor, 0, line_length,
+        CLexer::protect_comments, protected_regions);
 }
 
-std::string StringTranspiler::trim(const std::string& str) {
+inline std::string StringTranspiler::trim(const std::string& str) const {
     size_t start = str.find_first_not_of(" \t\r\n");
     if (start == std::string::npos) return "";
 
@@ -0,0 +1,218 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Proporcion de lineas (de 0 a 1) que ejercita cada etapa; el resto son lineas de
+// codigo que ninguna etapa cambia
+struct SyntheticDensity {
+    double printf_calls = 0.10;
+    double null_pointers = 0.05;
+    double arrays = 0.08;
+    double defines = 0.03;
+    double strings = 0.06;
+};
+
+// Genera archivos C sinteticos para medir el transpilador. La salida depende solo
+// del tamano, las densidades y la semilla: la misma llamada produce los mismos
+// bytes en cualquier maquina, asi que dos mediciones comparan el mismo trabajo.
+// Los nombres llevan un contador para que las lineas no se repitan identicas.
+class SyntheticSource {
+public:
+    static constexpr uint64_t default_seed = 0x2545F4914F6CDD1Dull;
+
+private:
+    SyntheticDensity density;
+    uint64_t state;
+    size_t counter = 0;
+
+    // Sufijo de la funcion en curso (total_<id> acumula en ella)
+    std::string function_id;
+
+public:
+    explicit SyntheticSource(const SyntheticDensity& density = {}, uint64_t seed = default_seed);
+
+    // Cabecera con #include y funciones completas hasta alcanzar 'target_size' bytes
+    std::string generate(size_t target_size);
+
+private:
+    size_t next(size_t bound);
+
+    double nextUnit();
+
+    void appendFunction(std::string& out);
+
+    void appendLine(std::string& out);
+
+    void appendPrintf(std::string& out, const std::string& id);
+    void appendNull(std::string& out, const std::string& id);
+    void appendArray(std::string& out, const std::string& id);
+    void appendDefine(std::string& out, const std::string& id);
+    void appendString(std::string& out, const std::string& id);
+    void appendPlain(std::string& out, const std::string& id);
+};
+
+
+inline SyntheticSource::SyntheticSource(const SyntheticDensity& line_density, uint64_t seed)
+    : density(line_density), state(seed)
+{
+}
+
+// Generador lineal congruente: no depende de la implementacion de <random>
+inline size_t SyntheticSource::next(size_t bound)
+{
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<size_t>((state >> 33) % bound);
+}
+
+inline double SyntheticSource::nextUnit()
+{
+    return static_cast<double>(next(1u << 24)) / static_cast<double>(1u << 24);
+}
+
+inline std::string SyntheticSource::generate(size_t target_size)
+{
+    std::string out;
+    out.reserve(target_size + 1024);
+
+    out += "#include <stdio.h>\n#include <stdlib.h>\n#include <string.h>\n\n";
+    while (out.size() < target_size) {
+        appendFunction(out);
+    }
+    return out;
+}
+
+inline void SyntheticSource::appendFunction(std::string& out)
+{
+    function_id = std::to_string(counter++);
+
+    out += "int funcion_" + function_id + "(int n, const char* texto) {\n";
+    out += "    int total_" + function_id + " = 0;\n";
+
+    size_t lines = 8 + next(24);
+    for (size_t i = 0; i < lines; ++i) {
+        appendLine(out);
+    }
+
+    out += "    return total_" + function_id + ";\n}\n\n";
+}
+
+inline void SyntheticSource::appendLine(std::string& out)
+{
+    std::string id = std::to_string(counter++);
+
+    double choice = nextUnit();
+    if ((choice -= density.printf_calls) < 0) appendPrintf(out, id);
+    else if ((choice -= density.null_pointers) < 0) appendNull(out, id);
+    else if ((choice -= density.arrays) < 0) appendArray(out, id);
+    else if ((choice -= density.defines) < 0) appendDefine(out, id);
+    else if ((choice -= density.strings) < 0) appendString(out, id);
+    else appendPlain(out, id);
+}
+
+inline void SyntheticSource::appendPrintf(std::string& out, const std::string& id)
+{
+    switch (next(5)) {
+    case 0:
+        out += "    printf(\"valor %d\\n\", n + " + id + ");\n";
+        break;
+    case 1:
+        out += "    printf(\"hola %s, tienes %d soles y %.2f de radio\\n\", texto, n, 3.5 * " + id + ");\n";
+        break;
+    case 2:
+        out += "    printf(\"progreso %d%%\\t(%c)\\n\", n % 100, 'a' + " + id + " % 26);\n";
+        break;
+    case 3:
+        out += "    printf(\"linea %d\\n\",\n        n * " + id + ");\n";
+        break;
+    default:
+        out += "    printf(\"sin argumentos " + id + "\\n\");\n";
+        break;
+    }
+}
+
+inline void SyntheticSource::appendNull(std::string& out, const std::string& id)
+{
+    switch (next(3)) {
+    case 0:
+        out += "    int* ptr_" + id + " = NULL;\n";
+        break;
+    case 1:
+        out += "    if (texto == NULL) { return " + id + "; }\n";
+        break;
+    default:
+        out += "    char* buffer_" + id + " = n > 0 ? (char*)malloc(n) : NULL;\n";
+        break;
+    }
+}
+
+inline void SyntheticSource::appendArray(std::string& out, const std::string& id)
+{
+    switch (next(4)) {
+    case 0:
+        out += "    int tabla_" + id + "[" + std::to_string(4 + next(60)) + "];\n";
+        break;
+    case 1:
+        out += "    double valores_" + id + "[] = { 1.5, 2.5, 3.5, " + id + ".0 };\n";
+        break;
+    case 2:
+        out += "    int datos_" + id + "[5] = { 1, 2, 3, 4, " + id + " };\n";
+        break;
+    default:
+        out += "    int a_" + id + "[10], b_" + id + "[20];\n";
+        break;
+    }
+}
+
+inline void SyntheticSource::appendDefine(std::string& out, const std::string& id)
+{
+    switch (next(4)) {
+    case 0:
+        out += "#define LIMITE_" + id + " " + id + "\n";
+        break;
+    case 1:
+        out += "#define FACTOR_" + id + " 1.25\n";
+        break;
+    case 2:
+        out += "#define NOMBRE_" + id + " \"nombre " + id + "\"\n";
+        break;
+    default:
+        out += "#define CUADRADO_" + id + "(x) ((x) * (x))\n";
+        break;
+    }
+}
+
+inline void SyntheticSource::appendString(std::string& out, const std::string& id)
+{
+    switch (next(3)) {
+    case 0:
+        out += "    char* nombre_" + id + " = \"mike\";\n";
+        break;
+    case 1:
+        out += "    char copia_" + id + "[] = \"perez\";\n";
+        break;
+    default:
+        out += "    const char* etiqueta_" + id + " = \"etiqueta " + id + "\";\n";
+        break;
+    }
+}
+
+inline void SyntheticSource::appendPlain(std::string& out, const std::string& id)
+{
+    switch (next(5)) {
+    case 0:
+        out += "    total_" + function_id + " += n * " + id + ";\n";
+        break;
+    case 1:
+        out += "    for (int i = 0; i < n; ++i) { n -= i % 3; }\n";
+        break;
+    case 2:
+        out += "    /* comentario " + id + " con printf y NULL dentro */\n";
+        break;
+    case 3:
+        out += "\n";
+        break;
+    default:
+        out += "    n = (n << 1) ^ " + id + ";\n";
+        break;
+    }
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "ByteClassScanner.hpp"
+
+// Divide un archivo en tramos que terminan despues de una linea que cierra una
+// declaracion o funcion de nivel superior (fuera de funciones, comentarios y
+// directivas). Solo sigue llaves, comentarios, literales y directivas: quien use
+// los tramos debe comprobar que cada uno termina limpio (ver
+// TranspilerPipeline::transpileSection)
+class TopLevelSplitter {
+private:
+    // Bytes que cambian el estado del recorrido ('c' por "char")
+    ByteClassScanner boundary_scanner{ "{}\"'/#\\c" };
+    ByteClassBitmaps content_bitmaps;
+
+public:
+    // Corta en el primer limite despues de cada 'target_size' bytes y agrega a
+    // 'declaration_lines' las lineas que tienen "char" y empiezan fuera de comentarios
+    std::vector<std::string_view> split(std::string_view content, size_t target_size,
+        std::vector<std::string_view>& declaration_lines);
+
+private:
+    static bool isIdentifierChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+};
+
+
+inline std::vector<std::string_view> TopLevelSplitter::split(std::string_view content, size_t target_size,
+    std::vector<std::string_view>& declaration_lines)
+{
+    enum class Mode { Code, LineComment, BlockComment, StringLiteral, CharLiteral };
+
+    size_t size = content.size();
+
+    std::vector<std::string_view> sections;
+    size_t section_start = 0;
+
+    Mode mode = Mode::Code;
+    long depth = 0;
+
+    // Estado de la linea en curso
+    size_t line_begin = 0;
+    bool starts_in_code = true;     // no empieza dentro de un comentario ni de una linea unida
+    bool directive = false;         // linea de preprocesador; sus llaves no cuentan
+    bool has_char = false;
+    size_t comment_start = size;    // inicio de un comentario '//'
+
+    auto start_line = [&](size_t begin, bool in_code) {
+        line_begin = begin;
+        starts_in_code = in_code;
+        directive = false;
+        has_char = false;
+        comment_start = size;
+    };
+
+    auto end_line = [&](size_t newline) {
+        size_t code_end = std::min(newline, comment_start);
+        while (code_end > line_begin && (content[code_end - 1] == ' ' || content[code_end - 1] == '\t' ||
+            content[code_end - 1] == '\r')) {
+            --code_end;
+        }
+        char last = code_end > line_begin ? content[code_end - 1] : '\n';
+
+        if (has_char && starts_in_code) {
+            declaration_lines.push_back(content.substr(line_begin, newline - line_begin));
+        }
+
+        if (depth == 0 && !directive && (last == ';' || last == '}') &&
+            newline + 1 - section_start >= target_size && newline + 1 < size) {
+            sections.push_back(content.substr(section_start, newline + 1 - section_start));
+            section_start = newline + 1;
+        }
+
+        start_line(newline + 1, true);
+    };
+
+    // Solo se visitan los saltos de linea y los bytes especiales; lo que queda
+    // dentro de un comentario de bloque o detras de un '\' se salta con 'skip_to'
+    boundary_scanner.scan(content, content_bitmaps);
+    size_t skip_to = 0;
+
+    for (size_t word = 0; word < content_bitmaps.newlines.size(); ++word) {
+        uint64_t bits = content_bitmaps.newlines[word] | content_bitmaps.specials[word];
+
+        while (bits != 0) {
+            size_t pos = word * 64 + static_cast<size_t>(std::countr_zero(bits));
+            bits &= bits - 1;
+            if (pos < skip_to || pos >= size) continue;
+
+            char c = content[pos];
+            char next = pos + 1 < size ? content[pos + 1] : '\0';
+
+            // Una linea unida con '\' sigue siendo la misma linea
+            if (c == '\\') {
+                if (next == '\n') {
+                    skip_to = pos + 2;
+                    starts_in_code = false;
+                }
+                else if (mode == Mode::StringLiteral || mode == Mode::CharLiteral) {
+                    skip_to = pos + 2;
+                }
+                continue;
+            }
+
+            if (c == '\n') {
+                mode = Mode::Code;
+                end_line(pos);
+                continue;
+            }
+
+            switch (mode) {
+            case Mode::LineComment:
+            case Mode::BlockComment:
+                continue;
+            case Mode::StringLiteral:
+                if (c == '"') mode = Mode::Code;
+                continue;
+            case Mode::CharLiteral:
+                if (c == '\'') mode = Mode::Code;
+                continue;
+            case Mode::Code:
+                break;
+            }
+
+            switch (c) {
+            case '{':
+            case '}':
+                if (!directive) depth += c == '{' ? 1 : -1;
+                break;
+            case '"':
+                mode = Mode::StringLiteral;
+                break;
+            case '\'':
+                mode = Mode::CharLiteral;
+                break;
+            case '/':
+                if (next == '/') {
+                    mode = Mode::LineComment;
+                    comment_start = pos;
+                    skip_to = pos + 2;
+                }
+                else if (next == '*') {
+                    size_t comment_end = content.find("*/", pos + 2);
+                    if (comment_end == std::string_view::npos) {
+                        mode = Mode::BlockComment;
+                        skip_to = size;
+                        break;
+                    }
+
+                    // La linea donde termina el comentario empieza dentro de el
+                    skip_to = comment_end + 2;
+                    size_t newline = content.rfind('\n', comment_end);
+                    if (newline != std::string_view::npos && newline > pos) {
+                        start_line(newline + 1, false);
+                    }
+                }
+                break;
+            case '#':
+                if (content.find_first_not_of(" \t", line_begin) == pos) directive = true;
+                break;
+            case 'c':
+                if ((pos == 0 || !isIdentifierChar(content[pos - 1])) && content.substr(pos, 4) == "char" &&
+                    (pos + 4 == size || !isIdentifierChar(content[pos + 4]))) {
+                    has_char = true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (line_begin < size && mode == Mode::Code) {
+        if (has_char && starts_in_code) {
+            declaration_lines.push_back(content.substr(line_begin));
+        }
+    }
+
+    sections.push_back(content.substr(section_start));
+    return sections;
+}
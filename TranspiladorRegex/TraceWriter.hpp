@@ -0,0 +1,109 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonLine.hpp"
+#include "MappedFile.hpp"
+
+// Eventos en el formato de Chrome (trace event format) que abren chrome://tracing
+// y Perfetto. Cada intervalo es un evento completo ("ph":"X") con el hilo que lo
+// ejecuto; los tiempos se miden desde la creacion del TraceWriter. Los eventos se
+// guardan en memoria y se escriben juntos al terminar.
+class TraceWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    Clock::time_point origin = Clock::now();
+
+    mutable std::mutex mutex;
+    std::vector<std::string> events;
+    uint32_t thread_count = 0;
+
+public:
+    // 'args' es el contenido de un objeto JSON ("\"bytes\":12,...") o vacio
+    void complete(std::string_view name, std::string_view category, Clock::time_point start, Clock::time_point end,
+        std::string_view args = {});
+
+    size_t size() const;
+
+    // false si no se pudo escribir el archivo
+    bool write(const std::string& path) const;
+
+private:
+    // Numero pequeno y estable para el hilo actual (los ids del sistema son largos)
+    uint32_t threadId();
+
+    double microseconds(Clock::time_point time) const {
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    }
+};
+
+
+inline uint32_t TraceWriter::threadId()
+{
+    // El id pertenece a este TraceWriter: se reasigna si el hilo escribe en otro
+    thread_local const TraceWriter* owner = nullptr;
+    thread_local uint32_t id = 0;
+
+    if (owner != this) {
+        std::lock_guard<std::mutex> lock(mutex);
+        owner = this;
+        id = ++thread_count;
+
+        std::string name = "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(id) +
+            ",\"args\":{\"name\":\"hilo " + std::to_string(id) + "\"}}";
+        events.push_back(std::move(name));
+    }
+    return id;
+}
+
+inline void TraceWriter::complete(std::string_view name, std::string_view category, Clock::time_point start,
+    Clock::time_point end, std::string_view args)
+{
+    uint32_t tid = threadId();
+
+    char times[96];
+    std::snprintf(times, sizeof(times), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+        microseconds(start), std::chrono::duration<double, std::micro>(end - start).count(), tid);
+
+    std::string event = "{\"name\":";
+    JsonLine::appendString(event, name);
+    event += ",\"cat\":";
+    JsonLine::appendString(event, category);
+    event += times;
+    if (!args.empty()) {
+        event += ",\"args\":{";
+        event.append(args);
+        event += '}';
+    }
+    event += '}';
+
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(std::move(event));
+}
+
+inline size_t TraceWriter::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return events.size();
+}
+
+inline bool TraceWriter::write(const std::string& path) const
+{
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < events.size(); ++i) {
+            json += events[i];
+            json += i + 1 < events.size() ? ",\n" : "\n";
+        }
+    }
+    json += "]}\n";
+
+    return writeFile(path, json);
+}
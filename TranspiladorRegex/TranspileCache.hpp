@@ -0,0 +1,241 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include "ByteHash.hpp"
+#include "MappedFile.hpp"
+#include "TranspilerPipeline.hpp"
+
+// Identifica una transpilacion: 128 bits que dependen de los bytes de entrada,
+// de las etapas habilitadas y de TranspilerRules::version
+struct CacheKey {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    std::string hex() const;
+};
+
+// Resultados guardados en un directorio local, un archivo por clave. Si la
+// entrada, las etapas y la version de las reglas coinciden se devuelve la salida
+// guardada sin ejecutar ninguna etapa. Cada acierto actualiza la fecha de la
+// entrada; al superar el tamano maximo se borran las usadas hace mas tiempo.
+// Las entradas se escriben en un temporal y se renombran, asi que varios hilos o
+// procesos pueden compartir el directorio.
+class TranspileCache {
+public:
+    static constexpr uintmax_t default_max_bytes = uintmax_t{ 256 } << 20;
+
+private:
+    std::filesystem::path directory;
+    uintmax_t max_bytes;
+
+    // Distingue los temporales de este proceso de los de otros
+    std::string temp_tag;
+    std::atomic<size_t> temp_counter{ 0 };
+
+    // Bytes en el directorio segun la ultima revision mas lo guardado desde entonces
+    std::atomic<uintmax_t> stored_bytes{ 0 };
+    std::mutex eviction_mutex;
+
+    std::atomic<size_t> hit_count{ 0 };
+    std::atomic<size_t> miss_count{ 0 };
+    std::atomic<size_t> evicted_count{ 0 };
+
+public:
+    TranspileCache(std::filesystem::path directory, uintmax_t max_bytes = default_max_bytes);
+
+    static CacheKey makeKey(std::string_view input, unsigned passes);
+
+    // true y la salida guardada en 'output' si existe una entrada para 'key'
+    bool lookup(const CacheKey& key, std::string& output);
+
+    void store(const CacheKey& key, std::string_view output);
+
+    // Devuelve la salida guardada o la de 'run()', que se guarda para la proxima vez
+    template <typename Run>
+    std::string transpile(std::string_view input, unsigned passes, Run&& run);
+
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+
+    void printSummary(std::ostream& out) const;
+
+private:
+    std::filesystem::path entryPath(const CacheKey& key) const;
+
+    // Borra las entradas mas antiguas hasta dejar el directorio en 3/4 del maximo
+    void evict();
+};
+
+
+inline std::string CacheKey::hex() const
+{
+    static constexpr char digits[] = "0123456789abcdef";
+
+    std::string text(32, '0');
+    for (size_t i = 0; i < 16; ++i) {
+        text[15 - i] = digits[(high >> (4 * i)) & 0xf];
+        text[31 - i] = digits[(low >> (4 * i)) & 0xf];
+    }
+    return text;
+}
+
+inline TranspileCache::TranspileCache(std::filesystem::path cache_directory, uintmax_t max_size)
+    : directory(std::move(cache_directory)), max_bytes(max_size)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    fs::create_directories(directory, error);
+    if (!fs::is_directory(directory)) {
+        throw std::runtime_error("No se pudo crear el directorio de cache: " + directory.string());
+    }
+
+    std::random_device random;
+    temp_tag = std::to_string(random()) + "-" + std::to_string(random());
+
+    uintmax_t total = 0;
+    for (const auto& entry : fs::directory_iterator(directory, error)) {
+        if (entry.path().extension() == ".out") total += entry.file_size(error);
+    }
+    stored_bytes = total;
+
+    if (total > max_bytes) evict();
+}
+
+inline CacheKey TranspileCache::makeKey(std::string_view input, unsigned passes)
+{
+    // Las etapas y la version eligen las semillas de las dos mitades
+    std::string stamp(TranspilerRules::version);
+    stamp += ':';
+    stamp += std::to_string(passes);
+
+    CacheKey key;
+    key.high = hashBytes(input, hashBytes(stamp, 1));
+    key.low = hashBytes(input, hashBytes(stamp, 2));
+    return key;
+}
+
+inline std::filesystem::path TranspileCache::entryPath(const CacheKey& key) const
+{
+    return directory / (key.hex() + ".out");
+}
+
+inline bool TranspileCache::lookup(const CacheKey& key, std::string& output)
+{
+    std::filesystem::path path = entryPath(key);
+
+    MappedFile entry;
+    if (!entry.open(path.string())) {
+        ++miss_count;
+        return false;
+    }
+
+    output.assign(entry.view());
+    ++hit_count;
+
+    // La fecha de modificacion hace de marca de ultimo uso
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+    return true;
+}
+
+inline void TranspileCache::store(const CacheKey& key, std::string_view output)
+{
+    namespace fs = std::filesystem;
+
+    // Una salida que no cabe desalojaria todo lo demas
+    if (output.size() > max_bytes) return;
+
+    fs::path path = entryPath(key);
+    fs::path temp = directory / (key.hex() + ".tmp-" + temp_tag + "-" + std::to_string(temp_counter++));
+
+    std::error_code error;
+    if (!writeFile(temp.string(), output)) {
+        fs::remove(temp, error);
+        return;
+    }
+
+    fs::rename(temp, path, error);
+    if (error) {
+        fs::remove(temp, error);
+        return;
+    }
+
+    if ((stored_bytes += output.size()) > max_bytes) evict();
+}
+
+template <typename Run>
+std::string TranspileCache::transpile(std::string_view input, unsigned passes, Run&& run)
+{
+    CacheKey key = makeKey(input, passes);
+
+    std::string output;
+    if (lookup(key, output)) return output;
+
+    output = run();
+    store(key, output);
+    return output;
+}
+
+inline void TranspileCache::evict()
+{
+    namespace fs = std::filesystem;
+
+    std::lock_guard<std::mutex> lock(eviction_mutex);
+
+    struct Entry {
+        fs::file_time_type used;
+        uintmax_t size;
+        fs::path path;
+    };
+
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+
+    std::error_code error;
+    for (const auto& item : fs::directory_iterator(directory, error)) {
+        if (item.path().extension() != ".out") continue;
+
+        std::error_code entry_error;
+        uintmax_t size = item.file_size(entry_error);
+        fs::file_time_type used = item.last_write_time(entry_error);
+        if (entry_error) continue;
+
+        entries.push_back(Entry{ used, size, item.path() });
+        total += size;
+    }
+
+    // Otro hilo pudo haber desalojado mientras se esperaba el mutex
+    if (total > max_bytes) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+
+        uintmax_t target = max_bytes / 4 * 3;
+        for (const auto& entry : entries) {
+            if (total <= target) break;
+
+            if (fs::remove(entry.path, error)) {
+                total -= entry.size;
+                ++evicted_count;
+            }
+        }
+    }
+
+    stored_bytes = total;
+}
+
+inline void TranspileCache::printSummary(std::ostream& out) const
+{
+    out << "Cache: " << hit_count << " aciertos, " << miss_count << " fallos, "
+        << evicted_count << " entradas desalojadas\n";
+}
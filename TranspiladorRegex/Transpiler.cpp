@@ -1,59 +1,440 @@
-﻿#include <iostream>
+﻿#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <csignal>
+#include <iostream>
 #include <fstream>
-#include "PrintfToCoutTranspiler.hpp"
-#include "DefineTranspiler.hpp"
-#include "NullTranspiler.hpp"
-#include "ArrayTranspiler.hpp"
-#include "StringTranspiler.hpp"
+#include <memory>
+#include <vector>
+#include "BatchTranspiler.hpp"
+#include "JsonlTranspiler.hpp"
+#include "MappedFile.hpp"
+#include "ParallelTranspiler.hpp"
+#include "PassRegistry.hpp"
+#include "SourceMap.hpp"
+#include "TranspileCache.hpp"
+#include "TranspilerPipeline.hpp"
+#include "TranspilerServer.hpp"
+#include "TranspilerStats.hpp"
+#include "TreeWatcher.hpp"
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// --stats cuenta tambien las asignaciones de memoria de cada etapa; sin --stats no
+// se cuentan (ver AllocationCounter::enable)
+TRANSPILER_COUNT_ALLOCATIONS();
 
 std::string test_input();
 
+// Escribe lo pedido con --stats y --trace; false si algun archivo no se pudo escribir
+bool report_instrumentation(const Instrumentation& instrumentation, const std::string& stats_file,
+    const std::string& trace_file);
+
+#if defined(__linux__)
+// Ctrl+C en --watch termina el ciclo y muestra el resumen
+TreeWatcher* active_watcher = nullptr;
+
+extern "C" void stop_watcher(int) {
+    if (active_watcher) active_watcher->stop();
+}
+#endif
+
+// Tamano en bytes con sufijo opcional K, M o G ("64M"); 0 si no es valido o no
+// cabe en size_t
+size_t parse_byte_size(const std::string& text);
+
+// Entero decimal sin signo entre 'min' y 'max'; false si 'text' tiene otra cosa
+bool parse_count(std::string_view text, size_t min, size_t max, size_t& value);
+
 int main(int argc, char** argv) {
 
     std::string input_file;
     std::string output_ile;
-    std::string content;
 
-    if (argc == 3) {
-        input_file = argv[1];
-        output_ile = argv[2];
+    // La entrada se proyecta en memoria y se recorre sin copiarla
+    MappedFile input;
+    std::string test_content;
+    std::string_view content;
 
-        std::ifstream inFile(input_file);
-        if (!inFile.is_open()) {
-            std::cerr << "No se pudo abrir el archivo: " << input_file << "\n";
+    // --sequential ejecuta los transpiladores uno tras otro sobre el archivo completo
+    PipelineMode mode = PipelineMode::Fused;
+    std::vector<std::string> positional;
+
+    // --stream lee stdin y escribe stdout por tramos; --budget limita la memoria
+    bool stream = false;
+    size_t memory_budget = size_t{ 64 } << 20;
+
+    // --batch <directorio|patron|@manifiesto> <directorio de salida>
+    bool batch = false;
+
+    // --jsonl <entrada.jsonl> <salida.jsonl> transpila el campo "source_code" de cada
+    // registro; --field=<nombre> es el campo donde se escribe el resultado
+    bool jsonl = false;
+    std::string jsonl_field = "regex_code";
+
+    // --serve <socket> atiende solicitudes por un socket Unix (ver TranspilerServer)
+    bool serve = false;
+
+    // --watch <directorio> <directorio de salida> transpila de nuevo los fuentes que cambian;
+    // --debounce=<ms> es la espera sin eventos antes de procesar un lote
+    bool watch = false;
+    size_t debounce_ms = 50;
+    constexpr size_t max_debounce_ms = 60000;
+
+    // --jobs=N hilos para el modo por lotes y para dividir un archivo grande
+    size_t jobs = 0;
+    constexpr size_t max_jobs = 1024;
+
+    // --cache=<directorio> reutiliza resultados anteriores; --cache-size limita el directorio
+    std::string cache_dir;
+    size_t cache_size = TranspileCache::default_max_bytes;
+
+    // --passes=<lista> aplica solo los pases nombrados ("define,null,printf"), en el
+    // orden del registro; --list-passes muestra los registrados
+    std::string pass_list = "all";
+
+    // --source-map escribe junto a la salida <salida>.map, con la linea de la entrada
+    // de cada linea generada (Source Map v3); --source-map=<archivo> elige el archivo
+    bool source_map = false;
+    std::string source_map_file;
+
+    // --stats muestra tiempo, bytes, lineas, coincidencias y asignaciones por etapa, y
+    // las consultas a la memoria de lineas (los recorridos medidos no la usan);
+    // --stats=<archivo.json> los escribe en JSON. --trace=<archivo.json> (o --trace
+    // <archivo.json>) guarda intervalos por etapa y por tramo o archivo para chrome://tracing
+    TranspilerStats stats;
+    TraceWriter trace;
+    Instrumentation instrumentation;
+    std::string stats_file;
+    std::string trace_file;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sequential") {
+            mode = PipelineMode::Sequential;
+        }
+        else if (arg == "--stream") {
+            stream = true;
+        }
+        else if (arg == "--batch") {
+            batch = true;
+        }
+        else if (arg == "--jsonl") {
+            jsonl = true;
+        }
+        else if (arg.rfind("--field=", 0) == 0) {
+            jsonl_field = arg.substr(8);
+            if (jsonl_field.empty()) {
+                std::cerr << "Campo no valido: " << arg << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--serve") {
+            serve = true;
+        }
+        else if (arg == "--watch") {
+            watch = true;
+        }
+        else if (arg.rfind("--debounce=", 0) == 0) {
+            if (!parse_count(std::string_view(arg).substr(11), 0, max_debounce_ms, debounce_ms)) {
+                std::cerr << "Espera no valida (0 a " << max_debounce_ms << " ms): " << arg << "\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--jobs=", 0) == 0) {
+            if (!parse_count(std::string_view(arg).substr(7), 1, max_jobs, jobs)) {
+                std::cerr << "Cantidad de hilos no valida (1 a " << max_jobs << "): " << arg << "\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--cache=", 0) == 0) {
+            cache_dir = arg.substr(8);
+            if (cache_dir.empty()) {
+                std::cerr << "Directorio de cache no valido: " << arg << "\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--cache-size=", 0) == 0) {
+            cache_size = parse_byte_size(arg.substr(13));
+            if (cache_size == 0) {
+                std::cerr << "Tamano de cache no valido: " << arg << "\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--passes=", 0) == 0) {
+            pass_list = arg.substr(9);
+        }
+        else if (arg == "--source-map") {
+            source_map = true;
+        }
+        else if (arg.rfind("--source-map=", 0) == 0) {
+            source_map_file = arg.substr(13);
+            if (source_map_file.empty()) {
+                std::cerr << "Archivo de mapa no valido: " << arg << "\n";
+                return 1;
+            }
+            source_map = true;
+        }
+        else if (arg == "--list-passes") {
+            PassRegistry::shared().print(std::cout);
+            return 0;
+        }
+        else if (arg == "--stats") {
+            instrumentation.stats = &stats;
+        }
+        else if (arg.rfind("--stats=", 0) == 0) {
+            stats_file = arg.substr(8);
+            if (stats_file.empty()) {
+                std::cerr << "Archivo de estadisticas no valido: " << arg << "\n";
+                return 1;
+            }
+            instrumentation.stats = &stats;
+        }
+        else if (arg == "--trace" || arg.rfind("--trace=", 0) == 0) {
+            trace_file = arg == "--trace" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(8);
+            if (trace_file.empty()) {
+                std::cerr << "Archivo de traza no valido: " << arg << "\n";
+                return 1;
+            }
+            instrumentation.trace = &trace;
+        }
+        else if (arg.rfind("--budget=", 0) == 0) {
+            memory_budget = parse_byte_size(arg.substr(9));
+            if (memory_budget == 0) {
+                std::cerr << "Presupuesto de memoria no valido: " << arg << "\n";
+                return 1;
+            }
+        }
+        else {
+            positional.push_back(arg);
+        }
+    }
+
+    PassPlan plan;
+    try {
+        plan = PassRegistry::shared().plan(pass_list);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (!plan.isPipeline() && (stream || serve || watch || batch || jsonl)) {
+        std::cerr << "--passes solo se aplica a la transpilacion de un archivo\n";
+        return 1;
+    }
+
+    if (source_map && (!plan.isPipeline() || stream || serve || watch || batch || jsonl)) {
+        std::cerr << "--source-map solo se aplica a la transpilacion de un archivo con todos los pases\n";
+        return 1;
+    }
+
+    // El modo por tramos no mide, no usa la cache y tiene su propio recorrido por etapas
+    if (stream && (instrumentation.enabled() || !cache_dir.empty() || mode == PipelineMode::Sequential || jobs != 0)) {
+        std::cerr << "--stream no admite --stats, --trace, --cache, --sequential ni --jobs\n";
+        return 1;
+    }
+
+    if (instrumentation.stats != nullptr) AllocationCounter::enable();
+
+    if (stream) {
+#if defined(_WIN32)
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        try {
+            TranspilerPipeline pipeline;
+            pipeline.transpileStream(stdin, stdout, memory_budget);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
             return 1;
         }
 
-        std::string aux_content((std::istreambuf_iterator<char>(inFile)),
-            std::istreambuf_iterator<char>());
-        inFile.close();
+        return 0;
+    }
+
+    if (serve) {
+        if (positional.size() != 1) {
+            std::cerr << "Uso: Transpiler --serve <socket>\n";
+            return 1;
+        }
 
-        content = aux_content;
+#if defined(_WIN32)
+        std::cerr << "El modo servidor no esta disponible en Windows\n";
+        return 1;
+#else
+        try {
+            TranspilerServer server(positional[0], mode);
+            std::cerr << "Escuchando en " << positional[0] << "\n";
+            server.run();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+
+        return 0;
+#endif
+    }
+
+    if (watch) {
+        if (positional.size() != 2) {
+            std::cerr << "Uso: Transpiler --watch <directorio> <directorio de salida>\n";
+            return 1;
+        }
+
+#if !defined(__linux__)
+        std::cerr << "El modo de vigilancia solo esta disponible en Linux\n";
+        return 1;
+#else
+        try {
+            TreeWatcher watcher(positional[0], positional[1], mode, jobs, std::chrono::milliseconds(static_cast<long>(debounce_ms)));
+            active_watcher = &watcher;
+            std::signal(SIGINT, stop_watcher);
+            std::signal(SIGTERM, stop_watcher);
+
+            watcher.run(std::cout, std::cerr);
+
+            active_watcher = nullptr;
+            watcher.printSummary(std::cout);
+            if (instrumentation.stats != nullptr) LineMemo::shared().printSummary(std::cout);
+        }
+        catch (const std::exception& e) {
+            active_watcher = nullptr;
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+
+        return 0;
+#endif
+    }
+
+    if (jsonl) {
+        if (positional.size() != 2) {
+            std::cerr << "Uso: Transpiler --jsonl <entrada.jsonl> <salida.jsonl> [--field=<nombre>]\n";
+            return 1;
+        }
+
+        try {
+            JsonlTranspiler jsonl_transpiler(mode, jobs, jsonl_field, instrumentation);
+            JsonlSummary summary = jsonl_transpiler.run(positional[0], positional[1], std::cerr);
+            summary.print(std::cout);
+            if (instrumentation.stats != nullptr) LineMemo::shared().printSummary(std::cout);
+            if (!report_instrumentation(instrumentation, stats_file, trace_file)) return 1;
+
+            return 0;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (batch) {
+        if (positional.size() != 2) {
+            std::cerr << "Uso: Transpiler --batch <directorio|patron|@manifiesto> <directorio de salida>\n";
+            return 1;
+        }
+
+        try {
+            std::unique_ptr<TranspileCache> cache;
+            if (!cache_dir.empty()) cache = std::make_unique<TranspileCache>(cache_dir, cache_size);
+
+            BatchTranspiler batch_transpiler(mode, jobs, cache.get(), instrumentation);
+            auto batch_jobs = batch_transpiler.collectJobs(positional[0], positional[1]);
+            BatchSummary summary = batch_transpiler.run(batch_jobs, std::cerr);
+            summary.print(std::cout);
+            if (instrumentation.stats != nullptr) LineMemo::shared().printSummary(std::cout);
+            if (cache) cache->printSummary(std::cout);
+            if (!report_instrumentation(instrumentation, stats_file, trace_file)) return 1;
+
+            return summary.failures == 0 ? 0 : 1;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (positional.size() == 2) {
+        input_file = positional[0];
+        output_ile = positional[1];
+
+        if (!input.open(input_file)) {
+            std::cerr << "No se pudo abrir el archivo: " << input_file << "\n";
+            return 1;
+        }
+
+        content = input.view();
     }
     else {
         std::cerr << "No se ingreso un archivo de entrada y salida, se utilizara un archivo de prueba\n";
-        content = test_input();
+        test_content = test_input();
+        content = test_content;
         output_ile = "test-output.cpp";
     }
 
-    std::ofstream outFile(output_ile, std::ofstream::trunc);
-
     try {
-        DefineTranspiler defineTranspiler;
-        NullTranspiler nullTranspiler;
-        ArrayTranspiler arrayTranspiler;
-        StringTranspiler stringTranspiler;
-        PrintfTranspiler printfTranspiler;
+        // Con un subconjunto de pases se aplican uno tras otro y se omiten los que no
+        // encuentran sus palabras en su entrada
+        size_t skipped_passes = 0;
+        SourceMap map;
+        auto transpile = [&] {
+            // El mapa necesita el registro de un recorrido fusionado del archivo completo
+            if (source_map) {
+                TranspilerPipeline pipeline;
+                pipeline.instrument(instrumentation);
+                return pipeline.transpileMapped(content, mode, map);
+            }
+
+            if (!plan.isPipeline()) {
+                TranspilerPipeline pipeline;
+                pipeline.instrument(instrumentation);
+                return plan.run(pipeline, content, mode, &skipped_passes);
+            }
+
+            ParallelTranspiler transpiler(mode, jobs, instrumentation);
+            return transpiler.transpile(content);
+        };
+
+        // Los pases registrados desde fuera no tienen version para la cache
+        bool cacheable = std::all_of(plan.steps().begin(), plan.steps().end(),
+            [](const PassInfo& pass) { return pass.stage_bit != 0; });
 
-        std::string result = defineTranspiler.transpileFile(content);
-        result = nullTranspiler.transpileFile(result);
-        result = arrayTranspiler.transpileFile(result);
-        result = stringTranspiler.transpileFile(result);
-        result = printfTranspiler.transpileFile(result);
+        std::unique_ptr<TranspileCache> cache;
+        if (!cache_dir.empty() && cacheable && !source_map) cache = std::make_unique<TranspileCache>(cache_dir, cache_size);
 
-        outFile << result;
+        std::string result = cache ? cache->transpile(content, plan.stagePasses(), transpile) : transpile();
+
+        if (!writeFile(output_ile, result)) {
+            std::cerr << "No se pudo escribir el archivo: " << output_ile << "\n";
+            return 1;
+        }
+
+        if (source_map) {
+            if (source_map_file.empty()) source_map_file = output_ile + ".map";
+            if (!writeFile(source_map_file, map.json(output_ile, input_file))) {
+                std::cerr << "No se pudo escribir el archivo: " << source_map_file << "\n";
+                return 1;
+            }
+        }
 
         std::cout << "Transpilacion completada\n";
+        if (source_map) {
+            std::cout << "Mapa de lineas: " << source_map_file << " (" << map.lines() << " lineas"
+                << (map.isExact() ? "" : ", aproximado") << ")\n";
+        }
+        if (!plan.isPipeline()) {
+            std::cout << "Pases: " << plan.names() << " (" << skipped_passes << " omitidos sin cambios)\n";
+        }
+        if (instrumentation.stats != nullptr) LineMemo::shared().printSummary(std::cout);
+        if (cache) cache->printSummary(std::cout);
+        if (!report_instrumentation(instrumentation, stats_file, trace_file)) return 1;
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
@@ -63,6 +444,56 @@ int main(int argc, char** argv) {
 	return 0;
 }
 
+bool report_instrumentation(const Instrumentation& instrumentation, const std::string& stats_file,
+    const std::string& trace_file) {
+    if (instrumentation.stats != nullptr) {
+        if (stats_file.empty()) {
+            instrumentation.stats->print(std::cout);
+        }
+        else if (!writeFile(stats_file, instrumentation.stats->json() + "\n")) {
+            std::cerr << "No se pudo escribir el archivo: " << stats_file << "\n";
+            return false;
+        }
+    }
+
+    if (instrumentation.trace != nullptr && !instrumentation.trace->write(trace_file)) {
+        std::cerr << "No se pudo escribir el archivo: " << trace_file << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+size_t parse_byte_size(const std::string& text) {
+    size_t value = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end == text.data()) return 0;
+
+    size_t digits = static_cast<size_t>(end - text.data());
+    if (digits == text.size()) return value;
+    if (digits + 1 < text.size()) return 0;
+
+    unsigned shift = 0;
+    switch (std::toupper(static_cast<unsigned char>(text[digits]))) {
+    case 'K': shift = 10; break;
+    case 'M': shift = 20; break;
+    case 'G': shift = 30; break;
+    default: return 0;
+    }
+
+    if (value > (SIZE_MAX >> shift)) return 0;
+    return value << shift;
+}
+
+bool parse_count(std::string_view text, size_t min, size_t max, size_t& value) {
+    size_t parsed = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+    if (error != std::errc() || end != text.data() + text.size() || parsed < min || parsed > max) return false;
+
+    value = parsed;
+    return true;
+}
+
 std::string test_input() {
 
     std::string test_input = R"(#include <stdio.h>
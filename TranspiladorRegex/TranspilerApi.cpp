@@ -0,0 +1,201 @@
+// Implementacion de TranspilerApi.h sobre TranspilerPipeline y WorkStealingPool.
+// Ninguna excepcion cruza la frontera en C: se convierten en un transpiler_status
+// y el mensaje queda en el manejador.
+#include "TranspilerApi.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "TranspilerPipeline.hpp"
+#include "WorkStealingPool.hpp"
+
+struct transpiler_handle {
+    PipelineMode mode;
+    WorkStealingPool pool;
+
+    // pipelines[0] atiende las llamadas individuales; el lote usa uno por hilo
+    std::vector<TranspilerPipeline> pipelines;
+
+    std::string last_error;
+
+    transpiler_handle(PipelineMode mode, size_t workers)
+        : mode(mode), pool(workers), pipelines(pool.size())
+    {
+    }
+};
+
+namespace {
+
+    // Ejecuta 'call' y traduce sus excepciones a un estado
+    template <typename Call>
+    transpiler_status guarded(transpiler_handle* handle, Call&& call)
+    {
+        try {
+            handle->last_error.clear();
+            return call();
+        }
+        catch (const std::bad_alloc&) {
+            handle->last_error = "sin memoria";
+            return TRANSPILER_OUT_OF_MEMORY;
+        }
+        catch (const std::exception& e) {
+            handle->last_error = e.what();
+            return TRANSPILER_ERROR;
+        }
+        catch (...) {
+            handle->last_error = "error desconocido";
+            return TRANSPILER_ERROR;
+        }
+    }
+
+    // Copia terminada en '\0' reservada con malloc, para liberarla con transpiler_free
+    char* duplicate(std::string_view text)
+    {
+        char* copy = static_cast<char*>(std::malloc(text.size() + 1));
+        if (!copy) throw std::bad_alloc();
+
+        std::memcpy(copy, text.data(), text.size());
+        copy[text.size()] = '\0';
+        return copy;
+    }
+
+    bool validInput(const char* input, size_t input_size)
+    {
+        return input != nullptr || input_size == 0;
+    }
+
+    std::string_view inputView(const char* input, size_t input_size)
+    {
+        return input_size == 0 ? std::string_view() : std::string_view(input, input_size);
+    }
+}
+
+extern "C" {
+
+int transpiler_abi_version(void)
+{
+    return TRANSPILER_ABI_VERSION;
+}
+
+transpiler_handle* transpiler_create(int mode, size_t workers)
+{
+    if (mode != TRANSPILER_MODE_FUSED && mode != TRANSPILER_MODE_SEQUENTIAL) return nullptr;
+
+    try {
+        return new transpiler_handle(mode == TRANSPILER_MODE_SEQUENTIAL ? PipelineMode::Sequential
+            : PipelineMode::Fused, workers);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void transpiler_destroy(transpiler_handle* handle)
+{
+    delete handle;
+}
+
+transpiler_status transpiler_transpile_into(transpiler_handle* handle, const char* input, size_t input_size,
+    char* output, size_t output_capacity, size_t* output_size)
+{
+    if (!handle || !output_size || !validInput(input, input_size) || (!output && output_capacity != 0)) {
+        return TRANSPILER_INVALID_ARGUMENT;
+    }
+
+    return guarded(handle, [&] {
+        std::string_view result = handle->pipelines[0].transpileView(inputView(input, input_size), handle->mode);
+        *output_size = result.size();
+        if (result.size() > output_capacity) return TRANSPILER_BUFFER_TOO_SMALL;
+
+        if (!result.empty()) std::memcpy(output, result.data(), result.size());
+        if (result.size() < output_capacity) output[result.size()] = '\0';
+        return TRANSPILER_OK;
+    });
+}
+
+transpiler_status transpiler_transpile(transpiler_handle* handle, const char* input, size_t input_size,
+    char** output, size_t* output_size)
+{
+    if (!handle || !output || !validInput(input, input_size)) return TRANSPILER_INVALID_ARGUMENT;
+    *output = nullptr;
+
+    return guarded(handle, [&] {
+        std::string_view result = handle->pipelines[0].transpileView(inputView(input, input_size), handle->mode);
+        *output = duplicate(result);
+        if (output_size) *output_size = result.size();
+        return TRANSPILER_OK;
+    });
+}
+
+transpiler_status transpiler_transpile_batch(transpiler_handle* handle, const transpiler_buffer* inputs,
+    size_t count, transpiler_buffer* outputs)
+{
+    if (!handle || (count != 0 && (!inputs || !outputs))) return TRANSPILER_INVALID_ARGUMENT;
+
+    for (size_t i = 0; i < count; ++i) {
+        outputs[i] = transpiler_buffer{ nullptr, 0 };
+        if (!validInput(inputs[i].data, inputs[i].size)) return TRANSPILER_INVALID_ARGUMENT;
+    }
+
+    return guarded(handle, [&] {
+        // Las entradas mayores primero, para que la ultima no quede sola al final
+        std::vector<size_t> order(count);
+        for (size_t i = 0; i < count; ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return inputs[a].size > inputs[b].size;
+        });
+
+        std::vector<transpiler_status> statuses(count, TRANSPILER_OK);
+        std::vector<std::string> errors(count);
+
+        handle->pool.run(order, [&](size_t worker, size_t index) {
+            try {
+                std::string_view result = handle->pipelines[worker].transpileView(
+                    inputView(inputs[index].data, inputs[index].size), handle->mode);
+                outputs[index] = transpiler_buffer{ duplicate(result), result.size() };
+            }
+            catch (const std::bad_alloc&) {
+                statuses[index] = TRANSPILER_OUT_OF_MEMORY;
+                errors[index] = "sin memoria";
+            }
+            catch (const std::exception& e) {
+                statuses[index] = TRANSPILER_ERROR;
+                errors[index] = e.what();
+            }
+        });
+
+        for (size_t i = 0; i < count; ++i) {
+            if (statuses[i] == TRANSPILER_OK) continue;
+
+            handle->last_error = "entrada " + std::to_string(i) + ": " + errors[i];
+            return statuses[i];
+        }
+        return TRANSPILER_OK;
+    });
+}
+
+void transpiler_free(char* output)
+{
+    std::free(output);
+}
+
+void transpiler_free_batch(transpiler_buffer* outputs, size_t count)
+{
+    if (!outputs) return;
+
+    for (size_t i = 0; i < count; ++i) {
+        std::free(const_cast<char*>(outputs[i].data));
+        outputs[i] = transpiler_buffer{ nullptr, 0 };
+    }
+}
+
+const char* transpiler_last_error(const transpiler_handle* handle)
+{
+    return handle ? handle->last_error.c_str() : "";
+}
+
+}
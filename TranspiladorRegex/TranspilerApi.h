@@ -0,0 +1,100 @@
+#pragma once
+/*
+ * API en C de libtranspiler para usar el transpilador dentro del proceso (ctypes,
+ * cffi) sin lanzar el ejecutable ni escribir archivos temporales.
+ *
+ * Un manejador guarda los pipelines y el conjunto de hilos; se crea una vez y se
+ * reutiliza. Los hilos se crean en el primer transpiler_transpile_batch y esperan
+ * el siguiente hasta transpiler_destroy. Un manejador no debe usarse desde dos hilos a la vez; hilos distintos
+ * pueden usar manejadores distintos.
+ *
+ * Las funciones devuelven un transpiler_status y no lanzan excepciones. Las
+ * salidas que reserva la biblioteca terminan en '\0' y se liberan con
+ * transpiler_free (o transpiler_free_batch).
+ *
+ * Ejemplo con ctypes:
+ *
+ *   lib = ctypes.CDLL("libtranspiler.so")
+ *   lib.transpiler_create.restype = ctypes.c_void_p
+ *   handle = lib.transpiler_create(0, 0)
+ *   output = ctypes.create_string_buffer(1 << 20)
+ *   size = ctypes.c_size_t()
+ *   lib.transpiler_transpile_into(ctypes.c_void_p(handle), code, len(code),
+ *       output, len(output), ctypes.byref(size))
+ */
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(TRANSPILER_API_EXPORTS)
+#    define TRANSPILER_API __declspec(dllexport)
+#  else
+#    define TRANSPILER_API __declspec(dllimport)
+#  endif
+#else
+#  define TRANSPILER_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Se incrementa solo si cambia una firma o el significado de un valor */
+#define TRANSPILER_ABI_VERSION 1
+
+typedef struct transpiler_handle transpiler_handle;
+
+typedef enum transpiler_status {
+    TRANSPILER_OK = 0,
+    /* El buffer del llamador no alcanza; el tamano necesario queda en *output_size */
+    TRANSPILER_BUFFER_TOO_SMALL = 1,
+    TRANSPILER_INVALID_ARGUMENT = 2,
+    TRANSPILER_OUT_OF_MEMORY = 3,
+    /* La transpilacion fallo; ver transpiler_last_error */
+    TRANSPILER_ERROR = 4
+} transpiler_status;
+
+typedef enum transpiler_mode {
+    TRANSPILER_MODE_FUSED = 0,
+    TRANSPILER_MODE_SEQUENTIAL = 1
+} transpiler_mode;
+
+typedef struct transpiler_buffer {
+    const char* data;
+    size_t size;
+} transpiler_buffer;
+
+TRANSPILER_API int transpiler_abi_version(void);
+
+/* 'workers' es la cantidad de hilos de transpiler_transpile_batch (0: uno por
+ * nucleo). Devuelve NULL si 'mode' no es valido o no hay memoria */
+TRANSPILER_API transpiler_handle* transpiler_create(int mode, size_t workers);
+
+TRANSPILER_API void transpiler_destroy(transpiler_handle* handle);
+
+/* Escribe el resultado en 'output' sin reservar memoria para la salida y deja su
+ * tamano en *output_size. Si cabe, tambien escribe un '\0' final. Con
+ * TRANSPILER_BUFFER_TOO_SMALL no se escribe nada en 'output' */
+TRANSPILER_API transpiler_status transpiler_transpile_into(transpiler_handle* handle, const char* input,
+    size_t input_size, char* output, size_t output_capacity, size_t* output_size);
+
+/* Reserva el resultado; se libera con transpiler_free */
+TRANSPILER_API transpiler_status transpiler_transpile(transpiler_handle* handle, const char* input,
+    size_t input_size, char** output, size_t* output_size);
+
+/* Transpila 'count' entradas con los hilos del manejador. outputs[i] recibe un
+ * resultado reservado por la biblioteca, o {NULL, 0} si esa entrada fallo; en ese
+ * caso devuelve el estado de la primera que fallo */
+TRANSPILER_API transpiler_status transpiler_transpile_batch(transpiler_handle* handle,
+    const transpiler_buffer* inputs, size_t count, transpiler_buffer* outputs);
+
+TRANSPILER_API void transpiler_free(char* output);
+
+TRANSPILER_API void transpiler_free_batch(transpiler_buffer* outputs, size_t count);
+
+/* Mensaje del ultimo error del manejador ("" si no hubo); vale hasta la
+ * siguiente llamada con el mismo manejador */
+TRANSPILER_API const char* transpiler_last_error(const transpiler_handle* handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,242 @@
+// Microbenchmarks de cada etapa (transpileFile) y de los auxiliares mas usados de
+// sus reglas, con Google Benchmark. Las entradas salen de SyntheticSource con una semilla fija,
+// asi que dos ejecuciones miden exactamente los mismos bytes.
+//
+// Por omision cada caso se repite 5 veces y solo se informan media, mediana,
+// desviacion y coeficiente de variacion: para comparar dos versiones conviene
+// usar la mediana (compare.py de Google Benchmark acepta la salida JSON de
+// --benchmark_out). Un cambio de 5% se distingue si el coeficiente de variacion
+// queda por debajo de ~1-2%; si no, subir --benchmark_min_time o fijar el CPU.
+//
+// Uso: transpiler_bench [opciones de Google Benchmark]
+//      transpiler_bench --emit <bytes>   escribe en stdout el archivo sintetico
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "SyntheticSource.hpp"
+#include "TranspilerPipeline.hpp"
+
+namespace {
+
+    constexpr size_t file_size = size_t{ 256 } << 10;
+
+    using DensityField = double SyntheticDensity::*;
+
+    // Las entradas se generan una sola vez por proceso
+    const std::string& mixedSource(size_t size)
+    {
+        static std::vector<std::pair<size_t, std::string>> sources;
+        for (const auto& [source_size, source] : sources) {
+            if (source_size == size) return source;
+        }
+        return sources.emplace_back(size, SyntheticSource().generate(size)).second;
+    }
+
+    // Densidad alta de lo que procesa una etapa; las demas casi no trabajan
+    const std::string& denseSource(DensityField field)
+    {
+        static std::vector<std::pair<DensityField, std::string>> sources;
+        for (const auto& [source_field, source] : sources) {
+            if (source_field == field) return source;
+        }
+
+        SyntheticDensity density{ 0.02, 0.02, 0.02, 0.02, 0.02 };
+        density.*field = 0.5;
+        return sources.emplace_back(field, SyntheticSource(density).generate(file_size)).second;
+    }
+
+    template <typename Transpiler>
+    void transpileFileCase(benchmark::State& state, const Transpiler& transpiler, DensityField field)
+    {
+        // Argumento 0: mezcla habitual; 1: densidad alta para la etapa
+        const std::string& input = state.range(0) == 1 ? denseSource(field) : mixedSource(file_size);
+
+        for (auto _ : state) {
+            std::string output = transpiler.transpileFile(input);
+            benchmark::DoNotOptimize(output.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+        state.SetLabel(state.range(0) == 1 ? "densa" : "mixta");
+    }
+
+    void BM_DefineTranspileFile(benchmark::State& state)
+    {
+        transpileFileCase(state, TranspilerRules::shared().defineTranspiler, &SyntheticDensity::defines);
+    }
+
+    void BM_NullTranspileFile(benchmark::State& state)
+    {
+        transpileFileCase(state, TranspilerRules::shared().nullTranspiler, &SyntheticDensity::null_pointers);
+    }
+
+    void BM_ArrayTranspileFile(benchmark::State& state)
+    {
+        transpileFileCase(state, TranspilerRules::shared().arrayTranspiler, &SyntheticDensity::arrays);
+    }
+
+    void BM_StringTranspileFile(benchmark::State& state)
+    {
+        transpileFileCase(state, TranspilerRules::shared().stringTranspiler, &SyntheticDensity::strings);
+    }
+
+    void BM_PrintfTranspileFile(benchmark::State& state)
+    {
+        transpileFileCase(state, TranspilerRules::shared().printfTranspiler, &SyntheticDensity::printf_calls);
+    }
+
+    // Pipeline completo; el argumento es el tamano del archivo
+    void BM_PipelineFused(benchmark::State& state)
+    {
+        const std::string& input = mixedSource(static_cast<size_t>(state.range(0)));
+        TranspilerPipeline pipeline;
+
+        for (auto _ : state) {
+            std::string output = pipeline.transpile(input, PipelineMode::Fused);
+            benchmark::DoNotOptimize(output.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+    }
+
+    void BM_PipelineSequential(benchmark::State& state)
+    {
+        const std::string& input = mixedSource(static_cast<size_t>(state.range(0)));
+        TranspilerPipeline pipeline;
+
+        for (auto _ : state) {
+            std::string output = pipeline.transpile(input, PipelineMode::Sequential);
+            benchmark::DoNotOptimize(output.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+    }
+
+    void BM_ProcessFormatString(benchmark::State& state)
+    {
+        struct Case {
+            std::string format;
+            std::vector<std::string> args;
+        };
+        const std::vector<Case> cases{
+            { "valor %d\\n", { "n" } },
+            { "hola %s, tienes %d soles y %.2f de radio\\n", { "texto", "n", "3.5 * r" } },
+            { "progreso %d%%\\t(%c)\\n", { "n % 100", "'a' + i" } },
+            { "%5d|%-8s|%08.3f|%x|%lu\\n", { "a", "b", "c", "d", "e" } },
+            { "sin argumentos\\n", {} },
+        };
+        const PrintfTranspiler& transpiler = TranspilerRules::shared().printfTranspiler;
+
+        for (auto _ : state) {
+            for (const auto& item : cases) {
+                std::string output = transpiler.processFormatString(item.format, item.args);
+                benchmark::DoNotOptimize(output.data());
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * cases.size()));
+    }
+
+    void BM_FindProtectedRegions(benchmark::State& state)
+    {
+        const std::vector<std::string> lines{
+            "    printf(\"hola %s, tienes %d soles\\n\", nombre, n); /* comentario */",
+            "    char* nombre = \"mike\"; int arr[5] = { 1, 2, 3, 4, 5 }; // fin",
+            "    int tabla[10], otra[20];",
+            "    strcpy(copia, \"texto con [corchetes] y NULL\");",
+        };
+
+        CLexer lexer;
+        std::vector<std::vector<Token>> tokens(lines.size());
+        for (size_t i = 0; i < lines.size(); ++i) {
+            LexState lex_state;
+            lexer.tokenizeLine(lines[i], true, lex_state, tokens[i]);
+        }
+
+        const ArrayTranspiler& transpiler = TranspilerRules::shared().arrayTranspiler;
+        std::vector<ProtectedRegion> regions;
+
+        for (auto _ : state) {
+            for (size_t i = 0; i < lines.size(); ++i) {
+                regions.clear();
+                transpiler.findProtectedRegions(tokens[i], lines[i].size(), regions);
+                benchmark::DoNotOptimize(regions.data());
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * lines.size()));
+    }
+
+    void BM_CountInitializerElements(benchmark::State& state)
+    {
+        const std::vector<std::string> initializers{
+            "{ 1, 2, 3, 4, 5 }",
+            "{ 1.2, 1.3, 1.4, 1.5, 1.6, 1.7, 1.8, 1.9, 2.0, 2.1, 2.2, 2.3 }",
+            "{ 'a', 'b', 'c', 'd', 'e' }",
+            "{}",
+        };
+        const ArrayTranspiler& transpiler = TranspilerRules::shared().arrayTranspiler;
+
+        for (auto _ : state) {
+            for (const auto& initializer : initializers) {
+                benchmark::DoNotOptimize(transpiler.countInitializerElements(initializer));
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * initializers.size()));
+    }
+
+    void BM_DeduceType(benchmark::State& state)
+    {
+        const std::vector<std::string> values{
+            "3.1416", "42", "\"texto\"", "'a'", "100UL", "(1 << 4)", "1.5f", "0x1F", "MAX_SIZE * 2", "-7",
+        };
+        const DefineTranspiler& transpiler = TranspilerRules::shared().defineTranspiler;
+
+        for (auto _ : state) {
+            for (const auto& value : values) {
+                std::string type = transpiler.deduceType(value);
+                benchmark::DoNotOptimize(type.data());
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * values.size()));
+    }
+}
+
+BENCHMARK(BM_DefineTranspileFile)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NullTranspileFile)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ArrayTranspileFile)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StringTranspileFile)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PrintfTranspileFile)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PipelineFused)->Arg(16 << 10)->Arg(256 << 10)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PipelineSequential)->Arg(16 << 10)->Arg(256 << 10)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ProcessFormatString);
+BENCHMARK(BM_FindProtectedRegions);
+BENCHMARK(BM_CountInitializerElements);
+BENCHMARK(BM_DeduceType);
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && std::strcmp(argv[1], "--emit") == 0) {
+        std::cout << SyntheticSource().generate(std::stoul(argv[2]));
+        return 0;
+    }
+
+    // Repeticiones y agregados por omision; la linea de comandos puede cambiarlos
+    std::vector<char*> args(argv, argv + argc);
+    bool repetitions_given = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--benchmark_repetitions", 23) == 0) repetitions_given = true;
+    }
+
+    char repetitions[] = "--benchmark_repetitions=5";
+    char aggregates[] = "--benchmark_report_aggregates_only=true";
+    if (!repetitions_given) {
+        args.push_back(repetitions);
+        args.push_back(aggregates);
+    }
+
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,971 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "PrintfToCoutTranspiler.hpp"
+#include "DefineTranspiler.hpp"
+#include "NullTranspiler.hpp"
+#include "ArrayTranspiler.hpp"
+#include "StringTranspiler.hpp"
+#include "SourceLines.hpp"
+#include "SourceMap.hpp"
+#include "ChunkedStream.hpp"
+#include "KeywordPrefilter.hpp"
+#include "LineMemo.hpp"
+#include "AllocationCounter.hpp"
+#include "EditList.hpp"
+#include "TranspilerStats.hpp"
+
+enum class PipelineMode {
+    Sequential,   // cada transpilador recorre el archivo completo, uno tras otro
+    Fused         // un solo recorrido: cada linea pasa por todas las etapas
+};
+
+// Etapas que se pueden elegir por separado, en el orden en que se aplican
+enum PipelinePass : unsigned {
+    pass_define = 1u << 0,
+    pass_null = 1u << 1,
+    pass_array = 1u << 2,
+    pass_string = 1u << 3,
+    pass_printf = 1u << 4,
+    all_passes = (1u << 5) - 1
+};
+
+// Nombres separados por comas ("define,null,printf") o "all"; 0 si alguno no existe
+unsigned parsePassList(std::string_view list);
+
+// Reglas de las cinco etapas. No cambian durante un recorrido, asi que todos los
+// pipelines del proceso pueden compartir una sola instancia desde cualquier hilo
+struct TranspilerRules {
+    DefineTranspiler defineTranspiler;
+    NullTranspiler nullTranspiler;
+    ArrayTranspiler arrayTranspiler;
+    StringTranspiler stringTranspiler;
+    PrintfTranspiler printfTranspiler;
+
+    // Se cambia al modificar cualquier regla: invalida los resultados que guardo
+    // TranspileCache con la version anterior
+    static constexpr std::string_view version = "2026.10.1";
+
+    static const TranspilerRules& shared();
+};
+
+// Encadena los cinco transpiladores en el orden define -> NULL -> arreglos -> cadenas -> printf.
+// El modo fusionado produce exactamente la misma salida que el secuencial; si detecta
+// que no puede garantizarlo (p. ej. un strcpy convertido antes de conocer todas las
+// declaraciones), vuelve a procesar el archivo en modo secuencial.
+class TranspilerPipeline {
+public:
+    static constexpr size_t stage_count = 5;
+
+    // Palabras que cada etapa necesita en su entrada para cambiarla: las de
+    // KeywordPrefilter y los encabezados que reemplaza. Sin ninguna de ellas, y con la
+    // directiva de include_needles ya presente, la etapa copia su entrada sin cambios
+    // (salvo el '\n' que las etapas intermedias agregan a una ultima linea sin el)
+    static constexpr std::array<std::array<std::string_view, 4>, stage_count> stage_triggers{ {
+        { "#define" },
+        { "NULL" },
+        { "[" },
+        { "char", "strcpy", "strcmp", "string.h" },
+        { "printf", "stdio.h" },
+    } };
+
+    // Directivas que inserta cada etapa si su entrada no las tiene
+    static constexpr std::array<std::string_view, stage_count> include_needles{
+        "", "", "#include <array>", "#include <string>", "#include <iostream>"
+    };
+
+    // Directivas que inserta cada etapa; se deciden con el archivo completo
+    struct IncludePlan {
+        bool insert_array = false;
+        bool prepend_array = false;
+        bool insert_string = false;
+        bool prepend_string = false;
+        bool insert_iostream = false;
+        bool prepend_iostream = false;
+
+        bool operator==(const IncludePlan&) const = default;
+    };
+
+    // Lo que decide los includes: si hay alguna directiva #include y si ya estan las
+    // que insertan las etapas de arreglos, cadenas y printf. Se puede reunir por
+    // tramos y combinar
+    struct IncludeFacts {
+        bool has_include = false;
+        std::array<bool, 3> has_needle{};
+
+        void merge(const IncludeFacts& other);
+        bool operator==(const IncludeFacts&) const = default;
+    };
+
+    // Resultado de transpileSection
+    struct SectionResult {
+        std::string output;
+
+        // Ninguna etapa arrastra estado de la ultima linea del tramo a la siguiente
+        bool ends_idle = false;
+
+        std::array<bool, stage_count> needle_found{};
+
+        // Variables declaradas como std::string en el tramo y variables consultadas
+        // por strcpy/strcmp: si alguna no coincide con el archivo completo, el tramo
+        // debe repetirse
+        std::set<std::string> declared_strings;
+        std::set<std::string> string_lookups;
+    };
+
+private:
+    // Reglas compartidas (ver TranspilerRules) y estado propio de cada etapa
+    const DefineTranspiler& defineTranspiler;
+    const NullTranspiler& nullTranspiler;
+    const ArrayTranspiler& arrayTranspiler;
+    const StringTranspiler& stringTranspiler;
+    const PrintfTranspiler& printfTranspiler;
+
+    DefineTranspiler::Context define_context;
+    NullTranspiler::Context null_context;
+    ArrayTranspiler::Context array_context;
+    StringTranspiler::Context string_context;
+    PrintfTranspiler::Context printf_context;
+
+    CLexer lexer;
+
+    // Saltos de linea y bytes iniciales de palabras clave del archivo en curso
+    ByteClassBitmaps content_bitmaps;
+
+    // Salida pendiente de cada etapa antes de entregarla a la siguiente
+    std::array<std::string, stage_count> stage_output;
+
+    // Si cada etapa encontro su directiva de include_needles en su entrada
+    std::array<bool, stage_count> needle_found{};
+
+    // Medicion opcional (ver instrument); los contadores son del recorrido en curso
+    Instrumentation instrumentation;
+    StatsCounters run_counters;
+
+    // Si no es nullptr, runFused registra aqui de que linea de la entrada sale cada
+    // linea del resultado (ver transpileMapped)
+    SourceMap* source_map = nullptr;
+
+    // Mide un recorrido completo: activa el conteo de reglas del hilo, suma los
+    // contadores a TranspilerStats y registra el intervalo en la traza. Sin
+    // medicion no hace nada
+    class RunScope {
+    private:
+        TranspilerPipeline& pipeline;
+        const char* name;
+        size_t input_size;
+        bool active;
+        uint64_t* previous_rules = nullptr;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        RunScope(TranspilerPipeline& pipeline, const char* name, size_t input_size);
+        ~RunScope();
+
+        RunScope(const RunScope&) = delete;
+        RunScope& operator=(const RunScope&) = delete;
+    };
+
+public:
+    // El pipeline solo guarda el estado de un recorrido: es barato de construir, pero
+    // cada hilo necesita el suyo. Los modos fusionado y por tramos consultan 'memo'
+    // antes de analizar una linea (nullptr la desactiva); el secuencial no la usa
+    explicit TranspilerPipeline(const TranspilerRules& rules = TranspilerRules::shared(),
+        LineMemo* memo = &LineMemo::shared());
+
+    // Registra tiempos, bytes, lineas, coincidencias y asignaciones por etapa en
+    // 'instrumentation.stats' e intervalos en 'instrumentation.trace'. Las lineas
+    // que salen de la memoria suman las coincidencias que se contaron al guardarlas.
+    // Sin medicion el costo es una comparacion por linea y etapa
+    void instrument(const Instrumentation& instrumentation);
+
+    std::string transpile(std::string_view content, PipelineMode mode = PipelineMode::Fused);
+
+    // Como transpile(), pero el resultado queda en un buffer del pipeline que vale
+    // hasta la siguiente llamada. En modo fusionado el buffer conserva su capacidad,
+    // asi que llamadas repetidas no reservan memoria para la salida
+    std::string_view transpileView(std::string_view content, PipelineMode mode = PipelineMode::Fused);
+
+    // Como transpile(), y ademas deja en 'map' la linea de la entrada de cada linea
+    // del resultado. El mapa sale de un recorrido fusionado; si hay que repetir el
+    // archivo en modo secuencial, se registra un recorrido fusionado con todas las
+    // variables std::string ya conocidas (como en ParallelTranspiler), y si aun asi
+    // la salida no coincide, el mapa se aproxima comparando lineas
+    std::string transpileMapped(std::string_view content, PipelineMode mode, SourceMap& map);
+
+    // Aplica solo las etapas de 'passes' (bits PipelinePass). Con todas equivale a
+    // transpile(); un subconjunto se aplica en modo secuencial
+    std::string transpilePasses(std::string_view content, unsigned passes, PipelineMode mode = PipelineMode::Fused);
+
+    // Una etapa sobre el archivo completo, con sus mediciones. No decide si hace
+    // falta: eso lo hace quien la llama (ver skipPass y PassPlan::run)
+    std::string transpileStage(size_t stage, std::string_view input);
+
+    // Lo que hace un pase omitido porque no cambiaria su entrada
+    enum class Skip {
+        No,             // el pase hace falta
+        Unchanged,      // se omite y la entrada queda igual
+        EndLastLine     // se omite, pero la entrada recibe el '\n' final que agregaria el pase
+    };
+
+    // Criterio con el que el modo secuencial, transpilePasses, PassPlan y applyPass
+    // omiten las etapas y los pases que no cambiarian su entrada: un pase hace
+    // falta si 'include' no esta en 'input' o si aparece alguna de 'triggers' (las
+    // vacias no cuentan; sin ninguna, hace falta siempre). Con 'ends_last_line', omitirlo
+    // igual termina con '\n' una ultima linea que no lo tiene
+    template <typename Triggers>
+    static Skip skipPass(std::string_view input, const Triggers& triggers, std::string_view include,
+        bool ends_last_line);
+
+    // Decisiones sobre includes que toma transpile() para 'content'
+    IncludePlan planIncludes(std::string_view content) const;
+
+    IncludeFacts scanIncludeFacts(std::string_view content) const;
+
+    static IncludePlan planIncludes(const IncludeFacts& facts);
+
+    // Directivas que cada etapa deberia encontrar en su entrada segun 'includes'
+    static std::array<bool, stage_count> expectedNeedles(const IncludePlan& includes);
+
+    // Procesa en modo fusionado un tramo de un archivo mayor (ver ParallelTranspiler).
+    // 'includes' son las directivas que se insertan en este tramo y 'declared_strings'
+    // las variables std::string de todo el archivo. El resultado solo es valido si
+    // las consultadas coinciden con las que declaran los tramos y si termina limpio
+    SectionResult transpileSection(std::string_view section, const IncludePlan& includes,
+        const std::set<std::string>& declared_strings);
+
+    // Agrega las variables que la etapa de cadenas declararia en 'line', una linea
+    // que empieza fuera de comentarios y literales, haciendola pasar sola por las
+    // etapas anteriores. Es una aproximacion barata que ParallelTranspiler verifica
+    // con transpileSection
+    void collectDeclarations(std::string_view line, bool has_newline, std::set<std::string>& declared_strings);
+
+    // Modo por tramos para entradas que no caben en memoria: misma salida que
+    // transpile(). Las etapas se aplican una tras otra como en el modo secuencial;
+    // cada una recorre su entrada por tramos y escribe en un archivo temporal que
+    // lee la siguiente. Los buffers usan a lo sumo la mitad de 'memory_budget'
+    // (salvo lineas o llamadas a printf mas largas que un tramo)
+    void transpileStream(std::FILE* input, std::FILE* output, size_t memory_budget);
+
+private:
+    std::string transpileSequential(std::string_view content);
+
+    std::string transpileFused(std::string_view content);
+
+    // Aplica las etapas de 'passes' una tras otra sobre el archivo completo,
+    // omitiendo las que no cambiarian su entrada
+    std::string transpileStages(std::string_view content, unsigned passes);
+
+    // Una etapa sobre el archivo completo
+    std::string transpileStageFile(size_t stage, std::string_view input) const;
+
+    // Recorrido fusionado de un archivo completo. Devuelve false si hay que repetirlo
+    // en modo secuencial; si no, el resultado queda en la salida de la ultima etapa
+    bool runFusedFile(std::string_view content);
+
+    // Recorrido fusionado; el resultado queda en la salida de la ultima etapa.
+    // Devuelve si ninguna etapa quedo con estado pendiente antes de endStream
+    bool runFused(std::string_view content, const IncludePlan& includes,
+        const std::set<std::string>* declared_strings);
+
+    // 'triggers' son los bits de KeywordPrefilter de la linea
+    void runStage(size_t stage, std::string_view line, bool has_newline, unsigned triggers);
+
+    void transpileStageLine(size_t stage, std::string_view line, bool has_newline, unsigned triggers);
+
+    // transpileStageLine con tiempo, bytes, asignaciones y si la linea cambio
+    void measureStageLine(size_t stage, std::string_view line, bool has_newline, unsigned triggers);
+
+    // Ejecuta una etapa sobre todo el archivo (modo secuencial) y la mide si corresponde
+    template <typename Run>
+    std::string measurePass(size_t stage, std::string_view input, Run&& run);
+
+    // Lineas de 'input' que no aparecen iguales en 'output' (ver measurePass)
+    static void countChangedLines(std::string_view input, std::string_view output, PassStats& pass);
+
+    // Entrega las lineas completas de la etapa 'stage' a la siguiente. Si la etapa
+    // copio 'input' sin cambios, la siguiente reutiliza sus bits sin volver a analizarla
+    void forwardStage(size_t stage, std::string_view input = {}, unsigned input_triggers = all_triggers);
+
+    // Lo que una etapa necesita saber de toda su entrada antes de procesarla
+    struct IncludeScan {
+        bool needle_found = false;
+        bool has_include = false;
+    };
+
+    IncludeScan scanIncludes(ChunkedInput& input, std::string_view needle);
+
+    // Recorre 'input' con una etapa y escribe su salida en 'output'
+    template <typename BeginStage, typename TranspileLine, typename EndStage>
+    void streamStage(ChunkedInput& input, std::FILE* output, size_t flush_threshold,
+        BeginStage&& begin, TranspileLine&& transpile_line, EndStage&& end);
+};
+
+
+inline const TranspilerRules& TranspilerRules::shared()
+{
+    static const TranspilerRules rules;
+    return rules;
+}
+
+inline TranspilerPipeline::TranspilerPipeline(const TranspilerRules& rules, LineMemo* memo)
+    : defineTranspiler(rules.defineTranspiler),
+      nullTranspiler(rules.nullTranspiler),
+      arrayTranspiler(rules.arrayTranspiler),
+      stringTranspiler(rules.stringTranspiler),
+      printfTranspiler(rules.printfTranspiler)
+{
+    define_context.memo = memo;
+    null_context.memo = memo;
+    array_context.memo = memo;
+    printf_context.memo = memo;
+}
+
+inline void TranspilerPipeline::instrument(const Instrumentation& measurement)
+{
+    instrumentation = measurement;
+}
+
+inline TranspilerPipeline::RunScope::RunScope(TranspilerPipeline& owner, const char* run_name, size_t size)
+    : pipeline(owner), name(run_name), input_size(size), active(owner.instrumentation.enabled())
+{
+    if (!active) return;
+
+    pipeline.run_counters = StatsCounters{};
+    previous_rules = TranspilerStats::activeRules();
+    TranspilerStats::activeRules() = pipeline.run_counters.rule_matches.data();
+    start = std::chrono::steady_clock::now();
+}
+
+inline TranspilerPipeline::RunScope::~RunScope()
+{
+    if (!active) return;
+
+    auto end = std::chrono::steady_clock::now();
+    TranspilerStats::activeRules() = previous_rules;
+
+    StatsCounters& counters = pipeline.run_counters;
+    counters.runs = 1;
+    if (pipeline.instrumentation.stats != nullptr) {
+        pipeline.instrumentation.stats->merge(counters);
+    }
+
+    if (pipeline.instrumentation.trace != nullptr) {
+        // En modo fusionado las etapas se alternan por linea: su tiempo va como argumento
+        std::string args = "\"bytes\":" + std::to_string(input_size);
+        if (pipeline.instrumentation.stats != nullptr) {
+            for (size_t stage = 0; stage < stage_count; ++stage) {
+                char value[64];
+                std::snprintf(value, sizeof(value), ",\"%s_ms\":%.3f",
+                    TranspilerStats::pass_names[stage].data(), counters.passes[stage].seconds * 1000.0);
+                args += value;
+            }
+        }
+        pipeline.instrumentation.trace->complete(name, "pipeline", start, end, args);
+    }
+}
+
+inline std::string TranspilerPipeline::transpile(std::string_view content, PipelineMode mode)
+{
+    RunScope scope(*this, mode == PipelineMode::Sequential ? "secuencial" : "fusionado", content.size());
+
+    if (mode == PipelineMode::Sequential) {
+        return transpileSequential(content);
+    }
+
+    return transpileFused(content);
+}
+
+inline std::string_view TranspilerPipeline::transpileView(std::string_view content, PipelineMode mode)
+{
+    RunScope scope(*this, mode == PipelineMode::Sequential ? "secuencial" : "fusionado", content.size());
+
+    std::string& result = stage_output[stage_count - 1];
+    if (mode == PipelineMode::Sequential || !runFusedFile(content)) {
+        result = transpileSequential(content);
+    }
+
+    return result;
+}
+
+inline std::string TranspilerPipeline::transpileMapped(std::string_view content, PipelineMode mode, SourceMap& map)
+{
+    RunScope scope(*this, mode == PipelineMode::Sequential ? "secuencial" : "fusionado", content.size());
+
+    std::string& result = stage_output[stage_count - 1];
+    IncludePlan includes = planIncludes(content);
+
+    map.clear();
+    source_map = &map;
+    runFused(content, includes, nullptr);
+    source_map = nullptr;
+
+    // Un mapa registrado que al decodificarlo no cubre la salida se aproxima
+    auto checked = [&](std::string output) {
+        if (!map.matches(content, output)) map.approximate(content, output);
+        return output;
+    };
+
+    bool valid = !string_context.stream_invalidated && needle_found == expectedNeedles(includes);
+    if (mode == PipelineMode::Fused && valid) {
+        return checked(std::move(result));
+    }
+
+    std::string output = transpileSequential(content);
+    if (valid && result == output) return checked(std::move(output));
+
+    std::set<std::string> declared_strings = string_context.stream_declarations;
+    map.clear();
+    source_map = &map;
+    runFused(content, includes, &declared_strings);
+    source_map = nullptr;
+
+    if (result != output) {
+        map.approximate(content, output);
+    }
+    return checked(std::move(output));
+}
+
+inline std::string TranspilerPipeline::transpilePasses(std::string_view content, unsigned passes, PipelineMode mode)
+{
+    if ((passes & all_passes) == all_passes) {
+        return transpile(content, mode);
+    }
+
+    return transpileStages(content, passes);
+}
+
+inline std::string TranspilerPipeline::transpileSequential(std::string_view content)
+{
+    return transpileStages(content, all_passes);
+}
+
+inline std::string TranspilerPipeline::transpileStages(std::string_view content, unsigned passes)
+{
+    std::string result;
+    std::string_view current = content;
+    bool transpiled = false;
+
+    for (size_t stage = 0; stage < stage_count; ++stage) {
+        if ((passes & (1u << stage)) == 0) continue;
+
+        Skip skip = skipPass(current, stage_triggers[stage], include_needles[stage], stage + 1 < stage_count);
+        if (skip == Skip::EndLastLine) {
+            if (!transpiled) result.assign(content);
+            result += '\n';
+            current = result;
+            transpiled = true;
+        }
+        if (skip != Skip::No) continue;
+
+        result = transpileStage(stage, current);
+        current = result;
+        transpiled = true;
+    }
+
+    if (!transpiled) result.assign(content);
+    return result;
+}
+
+inline std::string TranspilerPipeline::transpileStage(size_t stage, std::string_view input)
+{
+    return measurePass(stage, input, [&] { return transpileStageFile(stage, input); });
+}
+
+inline std::string TranspilerPipeline::transpileStageFile(size_t stage, std::string_view input) const
+{
+    switch (stage) {
+    case 0: return defineTranspiler.transpileFile(input);
+    case 1: return nullTranspiler.transpileFile(input);
+    case 2: return arrayTranspiler.transpileFile(input);
+    case 3: return stringTranspiler.transpileFile(input);
+    default: return printfTranspiler.transpileFile(input);
+    }
+}
+
+template <typename Triggers>
+inline TranspilerPipeline::Skip TranspilerPipeline::skipPass(std::string_view input, const Triggers& triggers,
+    std::string_view include, bool ends_last_line)
+{
+    if (!include.empty() && input.find(include) == std::string_view::npos) return Skip::No;
+
+    bool any_trigger = false;
+    for (std::string_view trigger : triggers) {
+        if (trigger.empty()) continue;
+        if (input.find(trigger) != std::string_view::npos) return Skip::No;
+        any_trigger = true;
+    }
+    if (!any_trigger) return Skip::No;
+
+    // Lo unico que haria un pase intermedio es terminar la ultima linea
+    return ends_last_line && !input.empty() && input.back() != '\n' ? Skip::EndLastLine : Skip::Unchanged;
+}
+
+template <typename Run>
+inline std::string TranspilerPipeline::measurePass(size_t stage, std::string_view input, Run&& run)
+{
+    if (!instrumentation.enabled()) return run();
+
+    AllocationCounter::Totals allocations = AllocationCounter::current();
+    uint64_t conflicts = EditList::conflicts();
+    auto start = std::chrono::steady_clock::now();
+    std::string output = run();
+    auto end = std::chrono::steady_clock::now();
+    const AllocationCounter::Totals& after = AllocationCounter::current();
+
+    PassStats& pass = run_counters.passes[stage];
+    pass.seconds += std::chrono::duration<double>(end - start).count();
+    pass.bytes_in += input.size();
+    pass.bytes_out += output.size();
+    pass.allocations += after.count - allocations.count;
+    pass.allocated_bytes += after.bytes - allocations.bytes;
+    pass.edit_conflicts += EditList::conflicts() - conflicts;
+    if (instrumentation.stats != nullptr) countChangedLines(input, output, pass);
+
+    if (instrumentation.trace != nullptr) {
+        instrumentation.trace->complete(TranspilerStats::pass_names[stage], "etapa", start, end,
+            "\"bytes\":" + std::to_string(input.size()));
+    }
+
+    return output;
+}
+
+inline void TranspilerPipeline::countChangedLines(std::string_view input, std::string_view output, PassStats& pass)
+{
+    // Cada linea de la entrada se busca en las proximas lineas de la salida: una
+    // etapa puede unir lineas (un printf de varias lineas) o agregar otras (includes)
+    static constexpr size_t lookahead = 4;
+
+    std::vector<std::string_view> output_lines;
+    forEachLine(output, [&](std::string_view line, bool) { output_lines.push_back(line); });
+
+    size_t next = 0;
+    forEachLine(input, [&](std::string_view line, bool) {
+        ++pass.lines;
+
+        size_t limit = std::min(output_lines.size(), next + lookahead);
+        for (size_t i = next; i < limit; ++i) {
+            if (output_lines[i] == line) {
+                next = i + 1;
+                return;
+            }
+        }
+        ++pass.lines_touched;
+    });
+}
+
+inline TranspilerPipeline::IncludePlan TranspilerPipeline::planIncludes(std::string_view content) const
+{
+    return planIncludes(scanIncludeFacts(content));
+}
+
+inline void TranspilerPipeline::IncludeFacts::merge(const IncludeFacts& other)
+{
+    has_include = has_include || other.has_include;
+    for (size_t i = 0; i < has_needle.size(); ++i) {
+        has_needle[i] = has_needle[i] || other.has_needle[i];
+    }
+}
+
+inline TranspilerPipeline::IncludeFacts TranspilerPipeline::scanIncludeFacts(std::string_view content) const
+{
+    IncludeFacts facts;
+    facts.has_include = lexer.hasIncludeDirective(content);
+    for (size_t i = 0; i < facts.has_needle.size(); ++i) {
+        facts.has_needle[i] = content.find(include_needles[i + 2]) != std::string_view::npos;
+    }
+    return facts;
+}
+
+inline TranspilerPipeline::IncludePlan TranspilerPipeline::planIncludes(const IncludeFacts& facts)
+{
+    // Las decisiones sobre includes se toman con el archivo original: las etapas
+    // previas solo agregan directivas, nunca eliminan ni crean otras
+    IncludePlan plan;
+    bool has_include = facts.has_include;
+
+    plan.insert_array = !facts.has_needle[0];
+    plan.prepend_array = plan.insert_array && !has_include;
+    has_include = has_include || plan.insert_array;
+
+    plan.insert_string = !facts.has_needle[1];
+    plan.prepend_string = plan.insert_string && !has_include;
+    has_include = has_include || plan.insert_string;
+
+    plan.insert_iostream = !facts.has_needle[2];
+    plan.prepend_iostream = plan.insert_iostream && !has_include;
+
+    return plan;
+}
+
+inline std::array<bool, TranspilerPipeline::stage_count> TranspilerPipeline::expectedNeedles(const IncludePlan& includes)
+{
+    return { false, false, !includes.insert_array, !includes.insert_string, !includes.insert_iostream };
+}
+
+inline std::string TranspilerPipeline::transpileFused(std::string_view content)
+{
+    if (!runFusedFile(content)) {
+        return transpileSequential(content);
+    }
+
+    return std::move(stage_output[stage_count - 1]);
+}
+
+inline bool TranspilerPipeline::runFusedFile(std::string_view content)
+{
+    IncludePlan includes = planIncludes(content);
+    runFused(content, includes, nullptr);
+
+    return !string_context.stream_invalidated && needle_found == expectedNeedles(includes);
+}
+
+inline TranspilerPipeline::SectionResult TranspilerPipeline::transpileSection(std::string_view section,
+    const IncludePlan& includes, const std::set<std::string>& declared_strings)
+{
+    RunScope scope(*this, "tramo", section.size());
+
+    SectionResult section_result;
+    section_result.ends_idle = runFused(section, includes, &declared_strings);
+    section_result.output = std::move(stage_output[stage_count - 1]);
+    section_result.needle_found = needle_found;
+    section_result.declared_strings = string_context.stream_declarations;
+    section_result.string_lookups = string_context.stream_lookups;
+
+    return section_result;
+}
+
+inline void TranspilerPipeline::collectDeclarations(std::string_view line, bool has_newline,
+    std::set<std::string>& declared_strings)
+{
+    for (auto& output : stage_output) output.clear();
+
+    defineTranspiler.beginStream(define_context);
+    defineTranspiler.transpileLine(define_context, line, has_newline, stage_output[0]);
+
+    nullTranspiler.beginStream(null_context);
+    forEachLine(stage_output[0], [&](std::string_view defined, bool defined_newline) {
+        nullTranspiler.transpileLine(null_context, defined, defined_newline, stage_output[1]);
+    });
+
+    arrayTranspiler.beginStream(array_context, false, false, stage_output[2]);
+    forEachLine(stage_output[1], [&](std::string_view nulled, bool nulled_newline) {
+        arrayTranspiler.transpileLine(array_context, nulled, nulled_newline, stage_output[2]);
+    });
+
+    std::string unused;
+    stringTranspiler.beginStream(string_context, false, false, StringOperationMode::CollectDeclarations, unused);
+    forEachLine(stage_output[2], [&](std::string_view converted, bool converted_newline) {
+        stringTranspiler.transpileLine(string_context, converted, converted_newline, unused);
+    });
+
+    const auto& found = string_context.stream_declarations;
+    declared_strings.insert(found.begin(), found.end());
+
+    for (auto& output : stage_output) output.clear();
+}
+
+inline bool TranspilerPipeline::runFused(std::string_view content, const IncludePlan& includes,
+    const std::set<std::string>* declared_strings)
+{
+    needle_found = {};
+
+    for (auto& output : stage_output) output.clear();
+
+    // La ultima etapa acumula el resultado completo
+    std::string& result = stage_output[stage_count - 1];
+    result.reserve(content.size() + content.size() / 8 + 128);
+
+    defineTranspiler.beginStream(define_context);
+    nullTranspiler.beginStream(null_context);
+    arrayTranspiler.beginStream(array_context, includes.insert_array, includes.prepend_array, stage_output[2]);
+    stringTranspiler.beginStream(string_context, includes.insert_string, includes.prepend_string, StringOperationMode::Immediate, stage_output[3]);
+    if (declared_strings != nullptr) {
+        stringTranspiler.useKnownStrings(string_context, *declared_strings);
+    }
+    printfTranspiler.beginStream(printf_context, includes.insert_iostream, includes.prepend_iostream, result);
+
+    for (size_t stage = 0; stage + 1 < stage_count; ++stage) {
+        forwardStage(stage);
+    }
+
+    // El prefiltro se calcula una vez por linea del original, sobre los mapas de
+    // bits del archivo completo
+    // Con mapa, la salida se atribuye cada vez que ninguna etapa retiene lineas: lo
+    // agregado desde la vez anterior sale de las lineas de entrada leidas desde entonces
+    size_t input_line = 0, span_start = 0, mapped = 0;
+
+    KeywordPrefilter::shared().forEachLine(content, content_bitmaps,
+        [&](std::string_view line, bool has_newline, unsigned triggers) {
+            runStage(0, line, has_newline, triggers);
+
+            if (source_map == nullptr) return;
+            ++input_line;
+            if (!printf_context.holdsOutput()) {
+                source_map->addSpan(std::string_view(result).substr(mapped), span_start, input_line - span_start);
+                mapped = result.size();
+                span_start = input_line;
+            }
+        });
+
+    bool idle = define_context.idle() && null_context.idle() && array_context.idle() &&
+        string_context.idle() && printf_context.idle();
+
+    defineTranspiler.endStream(define_context, stage_output[0]);
+    forwardStage(0);
+    nullTranspiler.endStream(null_context, stage_output[1]);
+    forwardStage(1);
+    arrayTranspiler.endStream(array_context, stage_output[2]);
+    forwardStage(2);
+    stringTranspiler.endStream(string_context, stage_output[3]);
+    forwardStage(3);
+    printfTranspiler.endStream(printf_context, result);
+
+    // Lo que queda sale de las lineas retenidas o, si no hay, de la ultima
+    if (source_map != nullptr) {
+        if (span_start == input_line && span_start > 0) --span_start;
+        source_map->addSpan(std::string_view(result).substr(mapped), span_start,
+            std::max<size_t>(input_line - span_start, 1));
+    }
+
+    return idle;
+}
+
+inline void TranspilerPipeline::runStage(size_t stage, std::string_view line, bool has_newline, unsigned triggers)
+{
+    if ((triggers & trigger_include) != 0 && !include_needles[stage].empty() &&
+        line.find(include_needles[stage]) != std::string_view::npos) {
+        needle_found[stage] = true;
+    }
+
+    if (instrumentation.stats != nullptr) {
+        measureStageLine(stage, line, has_newline, triggers);
+    }
+    else {
+        transpileStageLine(stage, line, has_newline, triggers);
+    }
+
+    // La ultima etapa escribe directamente en el resultado
+    if (stage + 1 < stage_count) {
+        forwardStage(stage, line, triggers);
+    }
+}
+
+inline void TranspilerPipeline::transpileStageLine(size_t stage, std::string_view line, bool has_newline, unsigned triggers)
+{
+    switch (stage) {
+    case 0: defineTranspiler.transpileLine(define_context, line, has_newline, stage_output[0], triggers); break;
+    case 1: nullTranspiler.transpileLine(null_context, line, has_newline, stage_output[1], triggers); break;
+    case 2: arrayTranspiler.transpileLine(array_context, line, has_newline, stage_output[2], triggers); break;
+    case 3: stringTranspiler.transpileLine(string_context, line, has_newline, stage_output[3], triggers); break;
+    default: printfTranspiler.transpileLine(printf_context, line, has_newline, stage_output[4], triggers); break;
+    }
+}
+
+inline void TranspilerPipeline::measureStageLine(size_t stage, std::string_view line, bool has_newline, unsigned triggers)
+{
+    const std::string& output = stage_output[stage];
+    size_t output_start = output.size();
+
+    AllocationCounter::Totals allocations = AllocationCounter::current();
+    uint64_t conflicts = EditList::conflicts();
+    auto start = std::chrono::steady_clock::now();
+    transpileStageLine(stage, line, has_newline, triggers);
+    auto end = std::chrono::steady_clock::now();
+    const AllocationCounter::Totals& after = AllocationCounter::current();
+
+    PassStats& pass = run_counters.passes[stage];
+    pass.seconds += std::chrono::duration<double>(end - start).count();
+    pass.bytes_in += line.size() + (has_newline ? 1 : 0);
+    pass.bytes_out += output.size() - output_start;
+    pass.allocations += after.count - allocations.count;
+    pass.allocated_bytes += after.bytes - allocations.bytes;
+    pass.edit_conflicts += EditList::conflicts() - conflicts;
+    ++pass.lines;
+
+    // Las etapas intermedias terminan en '\n' incluso la ultima linea del archivo
+    std::string_view produced = std::string_view(output).substr(output_start);
+    if (!produced.empty() && produced.back() == '\n') produced.remove_suffix(1);
+    if (produced != line) ++pass.lines_touched;
+}
+
+inline void TranspilerPipeline::forwardStage(size_t stage, std::string_view input, unsigned input_triggers)
+{
+    std::string& output = stage_output[stage];
+    if (output.empty()) return;
+
+    // Las etapas intermedias siempre terminan sus lineas en '\n'
+    std::string lines;
+    lines.swap(output);
+
+    bool unchanged = lines.size() == input.size() + 1 && lines.compare(0, input.size(), input) == 0;
+    const KeywordPrefilter& prefilter = KeywordPrefilter::shared();
+
+    forEachLine(lines, [&](std::string_view line, bool has_newline) {
+        runStage(stage + 1, line, has_newline, unchanged ? input_triggers : prefilter.scan(line));
+    });
+
+    // Conservar la capacidad del buffer para la proxima linea
+    lines.clear();
+    output.swap(lines);
+}
+
+inline void TranspilerPipeline::transpileStream(std::FILE* input, std::FILE* output, size_t memory_budget)
+{
+    size_t chunk_size = std::max<size_t>(memory_budget / 4, 256);
+
+    auto source = std::make_unique<ChunkedInput>(input, chunk_size);
+
+    // Cada etapa lee la salida temporal de la anterior
+    auto next_stage = [&](auto&& run) {
+        std::FILE* stage_file = openTemporaryFile();
+        try {
+            run(stage_file);
+        }
+        catch (...) {
+            std::fclose(stage_file);
+            throw;
+        }
+        source = std::make_unique<ChunkedInput>(stage_file, chunk_size, true);
+    };
+
+    next_stage([&](std::FILE* stage_file) {
+        streamStage(*source, stage_file, chunk_size,
+            [&](std::string&) { defineTranspiler.beginStream(define_context); },
+            [&](std::string_view line, bool has_newline, unsigned triggers, std::string& out) {
+                defineTranspiler.transpileLine(define_context, line, has_newline, out, triggers);
+            },
+            [&](std::string& out) { defineTranspiler.endStream(define_context, out); });
+    });
+
+    next_stage([&](std::FILE* stage_file) {
+        streamStage(*source, stage_file, chunk_size,
+            [&](std::string&) { nullTranspiler.beginStream(null_context); },
+            [&](std::string_view line, bool has_newline, unsigned triggers, std::string& out) {
+                nullTranspiler.transpileLine(null_context, line, has_newline, out, triggers);
+            },
+            [&](std::string& out) { nullTranspiler.endStream(null_context, out); });
+    });
+
+    next_stage([&](std::FILE* stage_file) {
+        IncludeScan scan = scanIncludes(*source, include_needles[2]);
+        bool insert_include = !scan.needle_found;
+        bool prepend_include = insert_include && !scan.has_include;
+
+        streamStage(*source, stage_file, chunk_size,
+            [&](std::string& out) { arrayTranspiler.beginStream(array_context, insert_include, prepend_include, out); },
+            [&](std::string_view line, bool has_newline, unsigned triggers, std::string& out) {
+                arrayTranspiler.transpileLine(array_context, line, has_newline, out, triggers);
+            },
+            [&](std::string& out) { arrayTranspiler.endStream(array_context, out); });
+    });
+
+    next_stage([&](std::FILE* stage_file) {
+        IncludeScan scan = scanIncludes(*source, include_needles[3]);
+        bool insert_include = !scan.needle_found;
+        bool prepend_include = insert_include && !scan.has_include;
+
+        // Las operaciones dependen de todas las declaraciones: un recorrido previo
+        // las reune y el segundo convierte con el set completo
+        std::string unused;
+        stringTranspiler.beginStream(string_context, insert_include, prepend_include, StringOperationMode::CollectDeclarations, unused);
+        source->forEachLine([&](std::string_view line, bool has_newline, unsigned triggers) {
+            stringTranspiler.transpileLine(string_context, line, has_newline, unused, triggers);
+        });
+        stringTranspiler.endStream(string_context, unused);
+        std::set<std::string> declared = string_context.converted_strings;
+
+        streamStage(*source, stage_file, chunk_size,
+            [&](std::string& out) {
+                stringTranspiler.beginStream(string_context, insert_include, prepend_include, StringOperationMode::Immediate, out);
+                stringTranspiler.useKnownStrings(string_context, declared);
+            },
+            [&](std::string_view line, bool has_newline, unsigned triggers, std::string& out) {
+                stringTranspiler.transpileLine(string_context, line, has_newline, out, triggers);
+            },
+            [&](std::string& out) { stringTranspiler.endStream(string_context, out); });
+    });
+
+    IncludeScan scan = scanIncludes(*source, include_needles[4]);
+    bool insert_include = !scan.needle_found;
+    bool prepend_include = insert_include && !scan.has_include;
+
+    streamStage(*source, output, chunk_size,
+        [&](std::string& out) { printfTranspiler.beginStream(printf_context, insert_include, prepend_include, out); },
+        [&](std::string_view line, bool has_newline, unsigned triggers, std::string& out) {
+            printfTranspiler.transpileLine(printf_context, line, has_newline, out, triggers);
+        },
+        [&](std::string& out) { printfTranspiler.endStream(printf_context, out); });
+}
+
+inline TranspilerPipeline::IncludeScan TranspilerPipeline::scanIncludes(ChunkedInput& input, std::string_view needle)
+{
+    // Equivale a content.find(needle) y CLexer::hasIncludeDirective sobre la entrada completa
+    IncludeScan scan;
+    LexState state;
+    std::vector<Token> tokens;
+    IncludeDirective directive;
+
+    input.forEachLine([&](std::string_view line, bool has_newline, unsigned triggers) {
+        if ((triggers & trigger_include) != 0 && line.find(needle) != std::string_view::npos) {
+            scan.needle_found = true;
+        }
+
+        if (scan.has_include) return;
+
+        if ((triggers & trigger_include) == 0) {
+            lexer.skipLine(line, has_newline, state, (triggers & trigger_lexer) == 0);
+            return;
+        }
+
+        tokens.clear();
+        lexer.tokenizeLine(line, has_newline, state, tokens);
+        scan.has_include = CLexer::findIncludeDirective(line, tokens, directive);
+    });
+
+    return scan;
+}
+
+template <typename BeginStage, typename TranspileLine, typename EndStage>
+inline void TranspilerPipeline::streamStage(ChunkedInput& input, std::FILE* output, size_t flush_threshold,
+    BeginStage&& begin, TranspileLine&& transpile_line, EndStage&& end)
+{
+    ChunkedOutput chunked(output, flush_threshold);
+
+    begin(chunked.text());
+    input.forEachLine([&](std::string_view line, bool has_newline, unsigned triggers) {
+        transpile_line(line, has_newline, triggers, chunked.text());
+        chunked.flushIfFull();
+    });
+    end(chunked.text());
+
+    chunked.flush();
+}
+
+inline unsigned parsePassList(std::string_view list)
+{
+    static constexpr std::array<std::pair<std::string_view, unsigned>, 6> names{ {
+        { "define", pass_define }, { "null", pass_null }, { "array", pass_array },
+        { "string", pass_string }, { "printf", pass_printf }, { "all", all_passes }
+    } };
+
+    unsigned passes = 0;
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view name = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        auto found = std::find_if(names.begin(), names.end(), [&](const auto& entry) { return entry.first == name; });
+        if (found == names.end()) return 0;
+        passes |= found->second;
+    }
+
+    return passes;
+}
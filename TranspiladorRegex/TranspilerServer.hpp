@@ -0,0 +1,425 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "LatencyRecorder.hpp"
+#include "TranspilerPipeline.hpp"
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Servidor persistente sobre un socket Unix: el proceso se inicia una sola vez y
+// todas las solicitudes comparten TranspilerRules::shared(). Cada cliente se atiende
+// en su propio hilo, hasta max_clients a la vez (los demas esperan en la cola del
+// socket), y toma un pipeline libre (o crea uno) para cada solicitud, de modo que
+// los buffers de cada etapa tambien se reutilizan.
+//
+// Protocolo: una linea de cabecera de texto seguida de un cuerpo binario.
+//   TRANSPILE <pases> <bytes>\n<fuente>  ->  OK <bytes> <microsegundos>\n<salida>
+//   STATS\n                              ->  OK <bytes> 0\n<json>
+//   SHUTDOWN\n                           ->  OK 0 0\n (y el servidor termina)
+// <pases> es "all" o una lista como "define,null,printf" (ver parsePassList). Un
+// error se responde con "ERR <bytes>\n<mensaje>"; si la cabecera no se entiende,
+// ademas se cierra la conexion.
+class TranspilerServer {
+private:
+    static constexpr size_t max_header_size = 256;
+    static constexpr size_t max_source_size = size_t{ 256 } << 20;
+    static constexpr size_t max_clients = 64;
+
+    // Lo que crece a lo sumo el cuerpo de una solicitud por cada lectura
+    static constexpr size_t body_chunk_size = size_t{ 256 } << 10;
+
+    std::string socket_path;
+    PipelineMode mode;
+    int listen_fd = -1;
+    std::atomic<bool> stopping{ false };
+
+    mutable std::mutex pipelines_mutex;
+    std::vector<std::unique_ptr<TranspilerPipeline>> idle_pipelines;
+    size_t pipeline_count = 0;
+
+    // Conexiones abiertas, para cerrarlas al terminar
+    std::mutex clients_mutex;
+    std::condition_variable clients_done;
+    std::set<int> client_fds;
+
+    std::atomic<uint64_t> requests{ 0 };
+    std::atomic<uint64_t> failures{ 0 };
+    LatencyRecorder latencies;
+
+    // Lectura con buffer de una conexion
+    struct ClientReader {
+        int fd;
+        std::string buffer;
+        size_t start = 0;
+
+        explicit ClientReader(int fd) : fd(fd) {}
+
+        // Lee hasta '\n' (sin incluirlo); false si la conexion se cerro o la linea es muy larga
+        bool readLine(std::string& line);
+
+        // Lee exactamente 'count' bytes. 'count' lo declara el cliente: 'bytes' crece
+        // a medida que llegan los datos, no se reserva de antemano
+        bool readBytes(size_t count, std::string& bytes);
+
+    private:
+        bool fill();
+    };
+
+public:
+    explicit TranspilerServer(std::string socket_path, PipelineMode mode = PipelineMode::Fused);
+    ~TranspilerServer();
+
+    TranspilerServer(const TranspilerServer&) = delete;
+    TranspilerServer& operator=(const TranspilerServer&) = delete;
+
+    // Atiende clientes hasta recibir SHUTDOWN o hasta que se llame a stop().
+    // Lanza std::runtime_error si no puede escuchar en el socket
+    void run();
+
+    void stop();
+
+    std::string statsJson() const;
+
+private:
+    void serveClient(int fd);
+
+    // Atiende una solicitud; false si hay que cerrar la conexion
+    bool handleRequest(ClientReader& reader, const std::string& header);
+
+    std::unique_ptr<TranspilerPipeline> acquirePipeline();
+
+    void releasePipeline(std::unique_ptr<TranspilerPipeline> pipeline);
+
+    // Pipeline prestado durante una solicitud; vuelve a la lista de libres incluso
+    // si la transpilacion lanza una excepcion
+    class PipelineLease {
+    private:
+        TranspilerServer& server;
+        std::unique_ptr<TranspilerPipeline> pipeline;
+
+    public:
+        explicit PipelineLease(TranspilerServer& server) : server(server), pipeline(server.acquirePipeline()) {}
+        ~PipelineLease() { server.releasePipeline(std::move(pipeline)); }
+
+        PipelineLease(const PipelineLease&) = delete;
+        PipelineLease& operator=(const PipelineLease&) = delete;
+
+        TranspilerPipeline* operator->() const { return pipeline.get(); }
+    };
+
+    static bool sendAll(int fd, std::string_view header, std::string_view body = {});
+
+    static bool sendError(int fd, std::string_view message);
+};
+
+
+inline bool TranspilerServer::ClientReader::fill()
+{
+    if (start > 0) {
+        buffer.erase(0, start);
+        start = 0;
+    }
+
+    char chunk[64 * 1024];
+    ssize_t received;
+    do {
+        received = ::recv(fd, chunk, sizeof(chunk), 0);
+    } while (received < 0 && errno == EINTR);
+
+    if (received <= 0) return false;
+    buffer.append(chunk, static_cast<size_t>(received));
+    return true;
+}
+
+inline bool TranspilerServer::ClientReader::readLine(std::string& line)
+{
+    while (true) {
+        size_t newline = buffer.find('\n', start);
+        if (newline != std::string::npos) {
+            line.assign(buffer, start, newline - start);
+            start = newline + 1;
+            return true;
+        }
+
+        if (buffer.size() - start > max_header_size || !fill()) return false;
+    }
+}
+
+inline bool TranspilerServer::ClientReader::readBytes(size_t count, std::string& bytes)
+{
+    bytes.clear();
+
+    size_t available = std::min(count, buffer.size() - start);
+    bytes.append(buffer, start, available);
+    start += available;
+
+    // El resto del cuerpo se recibe directamente en 'bytes', de a lo sumo
+    // body_chunk_size por lectura
+    while (bytes.size() < count) {
+        size_t offset = bytes.size();
+        size_t wanted = std::min(count - offset, body_chunk_size);
+        bytes.resize(offset + wanted);
+
+        ssize_t received;
+        do {
+            received = ::recv(fd, bytes.data() + offset, wanted, 0);
+        } while (received < 0 && errno == EINTR);
+
+        if (received <= 0) return false;
+        bytes.resize(offset + static_cast<size_t>(received));
+    }
+
+    return true;
+}
+
+inline TranspilerServer::TranspilerServer(std::string socket_path, PipelineMode mode)
+    : socket_path(std::move(socket_path)), mode(mode)
+{
+}
+
+inline TranspilerServer::~TranspilerServer()
+{
+    stop();
+}
+
+inline void TranspilerServer::run()
+{
+    sockaddr_un address{};
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Ruta de socket demasiado larga: " + socket_path);
+    }
+
+    // Un cliente que se desconecta a mitad de respuesta no debe terminar el proceso
+    std::signal(SIGPIPE, SIG_IGN);
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error(std::string("No se pudo crear el socket: ") + std::strerror(errno));
+    }
+
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    ::unlink(socket_path.c_str());
+
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listen_fd, SOMAXCONN) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(listen_fd);
+        listen_fd = -1;
+        throw std::runtime_error("No se pudo escuchar en " + socket_path + ": " + error);
+    }
+
+    // Un pipeline listo antes de la primera solicitud
+    releasePipeline(acquirePipeline());
+
+    while (!stopping) {
+        {
+            std::unique_lock<std::mutex> lock(clients_mutex);
+            clients_done.wait(lock, [&] { return stopping || client_fds.size() < max_clients; });
+        }
+
+        int client = ::accept(listen_fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        if (stopping) {
+            ::close(client);
+            break;
+        }
+        client_fds.insert(client);
+        std::thread(&TranspilerServer::serveClient, this, client).detach();
+    }
+
+    stop();
+    ::close(listen_fd);
+    ::unlink(socket_path.c_str());
+    listen_fd = -1;
+
+    std::unique_lock<std::mutex> lock(clients_mutex);
+    clients_done.wait(lock, [&] { return client_fds.empty(); });
+}
+
+inline void TranspilerServer::stop()
+{
+    if (stopping.exchange(true)) return;
+
+    // shutdown() despierta a accept() y a los hilos bloqueados en recv(); run()
+    // cierra el socket al salir
+    if (listen_fd >= 0) {
+        ::shutdown(listen_fd, SHUT_RDWR);
+    }
+
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    for (int client : client_fds) {
+        ::shutdown(client, SHUT_RDWR);
+    }
+    clients_done.notify_all();
+}
+
+inline void TranspilerServer::serveClient(int fd)
+{
+    ClientReader reader(fd);
+    std::string header;
+
+    while (!stopping && reader.readLine(header)) {
+        if (!handleRequest(reader, header)) break;
+    }
+
+    ::close(fd);
+
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    client_fds.erase(fd);
+    clients_done.notify_all();
+}
+
+inline bool TranspilerServer::handleRequest(ClientReader& reader, const std::string& header)
+{
+    std::string_view command = header;
+    if (!command.empty() && command.back() == '\r') command.remove_suffix(1);
+
+    if (command == "STATS") {
+        std::string stats = statsJson();
+        return sendAll(reader.fd, "OK " + std::to_string(stats.size()) + " 0\n", stats);
+    }
+
+    if (command == "SHUTDOWN") {
+        sendAll(reader.fd, "OK 0 0\n");
+        stop();
+        return false;
+    }
+
+    // TRANSPILE <pases> <bytes>
+    std::string_view prefix = "TRANSPILE ";
+    size_t space = command.rfind(' ');
+    if (command.substr(0, prefix.size()) != prefix || space < prefix.size()) {
+        ++failures;
+        sendError(reader.fd, "solicitud no valida");
+        return false;
+    }
+
+    unsigned passes = parsePassList(command.substr(prefix.size(), space - prefix.size()));
+    std::string_view length_text = command.substr(space + 1);
+    size_t length = 0;
+    auto [end, error] = std::from_chars(length_text.data(), length_text.data() + length_text.size(), length);
+    if (error != std::errc() || end != length_text.data() + length_text.size() || length > max_source_size) {
+        ++failures;
+        sendError(reader.fd, "longitud no valida");
+        return false;
+    }
+
+    std::string source;
+    if (!reader.readBytes(length, source)) return false;
+
+    // Con el cuerpo ya leido, un error de pases no obliga a cerrar la conexion
+    if (passes == 0) {
+        ++failures;
+        return sendError(reader.fd, "pases no validos");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string output;
+    try {
+        PipelineLease pipeline(*this);
+        output = pipeline->transpilePasses(source, passes, mode);
+    }
+    catch (const std::exception& e) {
+        ++failures;
+        return sendError(reader.fd, e.what());
+    }
+
+    double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    latencies.record(microseconds);
+    ++requests;
+
+    char timing[32];
+    std::snprintf(timing, sizeof(timing), "%.1f", microseconds);
+    return sendAll(reader.fd, "OK " + std::to_string(output.size()) + " " + timing + "\n", output);
+}
+
+inline std::unique_ptr<TranspilerPipeline> TranspilerServer::acquirePipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(pipelines_mutex);
+        if (!idle_pipelines.empty()) {
+            auto pipeline = std::move(idle_pipelines.back());
+            idle_pipelines.pop_back();
+            return pipeline;
+        }
+    }
+
+    auto pipeline = std::make_unique<TranspilerPipeline>();
+
+    std::lock_guard<std::mutex> lock(pipelines_mutex);
+    ++pipeline_count;
+    return pipeline;
+}
+
+inline void TranspilerServer::releasePipeline(std::unique_ptr<TranspilerPipeline> pipeline)
+{
+    std::lock_guard<std::mutex> lock(pipelines_mutex);
+    idle_pipelines.push_back(std::move(pipeline));
+}
+
+inline std::string TranspilerServer::statsJson() const
+{
+    LatencyRecorder::Summary summary = latencies.summary();
+
+    size_t pipelines;
+    {
+        std::lock_guard<std::mutex> lock(pipelines_mutex);
+        pipelines = pipeline_count;
+    }
+
+    LineMemo::Stats memo = LineMemo::shared().stats();
+
+    char json[384];
+    std::snprintf(json, sizeof(json),
+        "{\"requests\":%llu,\"errors\":%llu,\"pipelines\":%zu,\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f,"
+        "\"line_memo\":{\"lookups\":%llu,\"hits\":%llu,\"hit_rate\":%.3f}}",
+        static_cast<unsigned long long>(requests.load()), static_cast<unsigned long long>(failures.load()),
+        pipelines, summary.p50, summary.p99, summary.max,
+        static_cast<unsigned long long>(memo.lookups), static_cast<unsigned long long>(memo.hits), memo.hitRate());
+    return json;
+}
+
+inline bool TranspilerServer::sendAll(int fd, std::string_view header, std::string_view body)
+{
+    for (std::string_view part : { header, body }) {
+        while (!part.empty()) {
+            ssize_t sent = ::send(fd, part.data(), part.size(), 0);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent <= 0) return false;
+            part.remove_prefix(static_cast<size_t>(sent));
+        }
+    }
+    return true;
+}
+
+inline bool TranspilerServer::sendError(int fd, std::string_view message)
+{
+    return sendAll(fd, "ERR " + std::to_string(message.size()) + "\n", message);
+}
+
+#endif
@@ -0,0 +1,208 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "TraceWriter.hpp"
+
+// Reglas cuyas coincidencias se cuentan, agrupadas por etapa
+enum class StatsRule : unsigned char {
+    DefineValue, DefineFlag, DefineFunction,
+    NullPointer,
+    ArrayAutoInit, ArrayInitialized, ArrayMultiple, ArrayDeclaration,
+    StringCharArray, StringCharPointer, StringStrcpy, StringStrcmp,
+    PrintfCall,
+    Count
+};
+
+constexpr size_t stats_rule_count = static_cast<size_t>(StatsRule::Count);
+
+// Lo medido en una etapa. 'lines_touched' son las lineas cuya salida difiere de la
+// entrada y 'edit_conflicts' los reemplazos descartados por solaparse con otro de
+// la misma linea (ver EditList)
+struct PassStats {
+    double seconds = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t lines = 0;
+    uint64_t lines_touched = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    uint64_t edit_conflicts = 0;
+
+    void add(const PassStats& other);
+};
+
+struct StatsCounters {
+    static constexpr size_t pass_count = 5;
+
+    std::array<PassStats, pass_count> passes{};
+    std::array<uint64_t, stats_rule_count> rule_matches{};
+
+    // Archivos o tramos transpilados
+    uint64_t runs = 0;
+
+    void add(const StatsCounters& other);
+};
+
+// Totales por etapa y por regla de todos los pipelines que los registran (ver
+// TranspilerPipeline::instrument). Cada pipeline acumula un recorrido en sus
+// propios contadores y los suma aqui al terminarlo, asi que los hilos no
+// comparten nada mientras transpilan.
+class TranspilerStats {
+public:
+    // Mismos nombres que acepta parsePassList
+    static constexpr std::array<std::string_view, StatsCounters::pass_count> pass_names{
+        "define", "null", "array", "string", "printf"
+    };
+
+    static constexpr std::array<std::string_view, stats_rule_count> rule_names{
+        "define.valor", "define.bandera", "define.funcion",
+        "null.NULL",
+        "array.autoinicializado", "array.inicializado", "array.multiple", "array.declaracion",
+        "string.char_arreglo", "string.char_puntero", "string.strcpy", "string.strcmp",
+        "printf.printf"
+    };
+
+private:
+    mutable std::mutex mutex;
+    StatsCounters totals;
+
+public:
+    // Contadores de reglas del hilo actual; nullptr mientras nadie mide
+    static uint64_t*& activeRules() {
+        thread_local uint64_t* rules = nullptr;
+        return rules;
+    }
+
+    // Las reglas la llaman en cada reemplazo: sin medicion solo cuesta una comparacion
+    static void countRule(StatsRule rule) {
+        if (uint64_t* rules = activeRules()) ++rules[static_cast<size_t>(rule)];
+    }
+
+    void merge(const StatsCounters& counters);
+
+    StatsCounters snapshot() const;
+
+    // Tabla por etapa y coincidencias por regla
+    void print(std::ostream& out) const;
+
+    std::string json() const;
+};
+
+// Medicion opcional de un pipeline: estadisticas, trazas o ambas
+struct Instrumentation {
+    TranspilerStats* stats = nullptr;
+    TraceWriter* trace = nullptr;
+
+    bool enabled() const { return stats != nullptr || trace != nullptr; }
+};
+
+
+inline void PassStats::add(const PassStats& other)
+{
+    seconds += other.seconds;
+    bytes_in += other.bytes_in;
+    bytes_out += other.bytes_out;
+    lines += other.lines;
+    lines_touched += other.lines_touched;
+    allocations += other.allocations;
+    allocated_bytes += other.allocated_bytes;
+    edit_conflicts += other.edit_conflicts;
+}
+
+inline void StatsCounters::add(const StatsCounters& other)
+{
+    for (size_t i = 0; i < passes.size(); ++i) passes[i].add(other.passes[i]);
+    for (size_t i = 0; i < rule_matches.size(); ++i) rule_matches[i] += other.rule_matches[i];
+    runs += other.runs;
+}
+
+inline void TranspilerStats::merge(const StatsCounters& counters)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    totals.add(counters);
+}
+
+inline StatsCounters TranspilerStats::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals;
+}
+
+inline void TranspilerStats::print(std::ostream& out) const
+{
+    StatsCounters counters = snapshot();
+
+    double total_seconds = 0;
+    for (const auto& pass : counters.passes) total_seconds += pass.seconds;
+
+    out << std::left << std::setw(8) << "Etapa" << std::right
+        << std::setw(11) << "ms" << std::setw(8) << "%"
+        << std::setw(13) << "KB entrada" << std::setw(12) << "KB salida"
+        << std::setw(10) << "Lineas" << std::setw(11) << "Cambiadas" << std::setw(14) << "Asignaciones"
+        << std::setw(12) << "Conflictos" << "\n";
+
+    for (size_t i = 0; i < counters.passes.size(); ++i) {
+        const PassStats& pass = counters.passes[i];
+        out << std::left << std::setw(8) << pass_names[i] << std::right << std::fixed
+            << std::setprecision(2) << std::setw(11) << pass.seconds * 1000.0
+            << std::setprecision(1) << std::setw(7) << (total_seconds > 0 ? pass.seconds / total_seconds * 100.0 : 0.0) << "%"
+            << std::setw(13) << static_cast<double>(pass.bytes_in) / 1024.0
+            << std::setw(12) << static_cast<double>(pass.bytes_out) / 1024.0
+            << std::setw(10) << pass.lines << std::setw(11) << pass.lines_touched
+            << std::setw(14) << pass.allocations << std::setw(12) << pass.edit_conflicts << "\n";
+    }
+
+    out << "Coincidencias:";
+    for (size_t i = 0; i < counters.rule_matches.size(); ++i) {
+        out << (i == 0 ? " " : ", ") << rule_names[i] << " " << counters.rule_matches[i];
+    }
+    out << "\n";
+}
+
+inline std::string TranspilerStats::json() const
+{
+    StatsCounters counters = snapshot();
+
+    std::string json = "{\"runs\":" + std::to_string(counters.runs) + ",\"passes\":[";
+    for (size_t i = 0; i < counters.passes.size(); ++i) {
+        const PassStats& pass = counters.passes[i];
+
+        char values[320];
+        std::snprintf(values, sizeof(values),
+            "\"seconds\":%.6f,\"bytes_in\":%llu,\"bytes_out\":%llu,\"lines\":%llu,\"lines_touched\":%llu,"
+            "\"allocations\":%llu,\"allocated_bytes\":%llu,\"edit_conflicts\":%llu",
+            pass.seconds, static_cast<unsigned long long>(pass.bytes_in),
+            static_cast<unsigned long long>(pass.bytes_out), static_cast<unsigned long long>(pass.lines),
+            static_cast<unsigned long long>(pass.lines_touched), static_cast<unsigned long long>(pass.allocations),
+            static_cast<unsigned long long>(pass.allocated_bytes), static_cast<unsigned long long>(pass.edit_conflicts));
+
+        json += i == 0 ? "{\"name\":\"" : ",{\"name\":\"";
+        json.append(pass_names[i]);
+        json += "\",";
+        json += values;
+
+        // Coincidencias de las reglas de esta etapa ("define.valor" -> "valor")
+        json += ",\"matches\":{";
+        bool first = true;
+        for (size_t rule = 0; rule < rule_names.size(); ++rule) {
+            std::string_view name = rule_names[rule];
+            size_t dot = name.find('.');
+            if (name.substr(0, dot) != pass_names[i]) continue;
+
+            json += first ? "\"" : ",\"";
+            json.append(name.substr(dot + 1));
+            json += "\":" + std::to_string(counters.rule_matches[rule]);
+            first = false;
+        }
+        json += "}}";
+    }
+    json += "]}";
+
+    return json;
+}
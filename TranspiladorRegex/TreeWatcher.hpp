@@ -0,0 +1,471 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+#include "BatchTranspiler.hpp"
+#include "IncrementalTranspiler.hpp"
+#include "LatencyRecorder.hpp"
+#include "MappedFile.hpp"
+#include "TranspilerPipeline.hpp"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Mantiene un arbol de salida al dia con un arbol de fuentes: al inicio transpila
+// todo (como --batch) y despues espera eventos de inotify. Los eventos se agrupan
+// hasta que pasa 'debounce' sin ninguno nuevo (un editor suele escribir, renombrar
+// y cambiar atributos de un mismo archivo seguidos), o a lo sumo max_batch_wait
+// desde el primero si no dejan de llegar, y solo se transpilan los .c y .h que
+// cambiaron. Cada salida se escribe en un temporal y se renombra, asi que quien la
+// lea nunca ve un archivo a medias.
+//
+// Las fuentes se leen con pread y no se proyectan en memoria: un editor puede
+// truncarlas en cualquier momento, y con la proyeccion eso terminaria el proceso
+// con SIGBUS. Un archivo que cambia mientras se lee se deja para el proximo evento.
+//
+// El pipeline es el mismo en todos los eventos; los archivos grandes guardan ademas
+// un IncrementalTranspiler para que un cambio pequeno solo repita sus tramos.
+class TreeWatcher {
+public:
+    static constexpr std::chrono::milliseconds default_debounce{ 50 };
+
+    // Espera maxima desde el primer evento de un lote, aunque sigan llegando otros
+    // (si 'debounce' es mayor, se usa 'debounce')
+    static constexpr std::chrono::milliseconds max_batch_wait{ 1000 };
+
+    // Desde este tamano un archivo conserva su estado incremental entre eventos
+    static constexpr size_t incremental_min_size = size_t{ 256 } << 10;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::filesystem::path source_dir;
+    std::filesystem::path output_dir;
+    PipelineMode mode;
+    size_t jobs;
+    std::chrono::milliseconds debounce;
+
+    int inotify_fd = -1;
+    std::atomic<bool> stopping{ false };
+
+    // Directorio (relativo a la fuente) de cada descriptor de inotify
+    std::unordered_map<int, std::filesystem::path> watches;
+
+    // Cambios del lote en curso: ruta relativa -> true si se borro
+    std::map<std::filesystem::path, bool> pending;
+    Clock::time_point first_event;
+    Clock::time_point last_event;
+
+    TranspilerPipeline pipeline;
+    std::unordered_map<std::string, std::unique_ptr<IncrementalTranspiler>> incremental;
+
+    // Contenido de la fuente en curso; conserva su capacidad entre archivos
+    std::string source_buffer;
+
+    size_t temp_counter = 0;
+    size_t batches = 0;
+    size_t files_written = 0;
+    size_t failures = 0;
+    size_t postponed = 0;
+    LatencyRecorder latencies;
+
+public:
+    TreeWatcher(std::filesystem::path source_dir, std::filesystem::path output_dir,
+        PipelineMode mode = PipelineMode::Fused, size_t jobs = 0,
+        std::chrono::milliseconds debounce = default_debounce);
+    ~TreeWatcher();
+
+    TreeWatcher(const TreeWatcher&) = delete;
+    TreeWatcher& operator=(const TreeWatcher&) = delete;
+
+    // Sincroniza el arbol y atiende eventos hasta que se llame a stop(). Informa cada
+    // lote en 'log' y los errores de cada archivo en 'errors'
+    void run(std::ostream& log, std::ostream& errors);
+
+    // Se puede llamar desde otro hilo o desde un manejador de senales
+    void stop() { stopping = true; }
+
+    void printSummary(std::ostream& out) const;
+
+private:
+    // Agrega vigilancia a 'relative' y sus subdirectorios; si 'enqueue', agrega al
+    // lote los fuentes que ya contienen (pudieron crearse antes de vigilarlos)
+    void watchTree(const std::filesystem::path& relative, bool enqueue);
+
+    void readEvents();
+
+    void markChanged(const std::filesystem::path& relative, bool removed);
+
+    void processPending(std::ostream& log, std::ostream& errors);
+
+    enum class FileResult {
+        Written,
+        Failed,
+        Changed     // la fuente cambio mientras se leia: se repite con el proximo evento
+    };
+
+    FileResult transpileFile(const std::filesystem::path& relative, std::ostream& errors);
+
+    // Lee 'path' completo en 'content'. Changed si se trunco o crecio durante la lectura
+    static FileResult readSource(const std::filesystem::path& path, std::string& content);
+
+    // Momento en que hay que procesar el lote pendiente
+    Clock::time_point batchDeadline() const;
+
+    bool writeAtomically(const std::filesystem::path& path, std::string_view content);
+};
+
+
+inline TreeWatcher::TreeWatcher(std::filesystem::path source, std::filesystem::path output,
+    PipelineMode pipeline_mode, size_t job_count, std::chrono::milliseconds debounce_time)
+    : source_dir(std::move(source)), output_dir(std::move(output)), mode(pipeline_mode), jobs(job_count),
+      debounce(debounce_time)
+{
+    if (!std::filesystem::is_directory(source_dir)) {
+        throw std::runtime_error("No es un directorio: " + source_dir.string());
+    }
+
+    inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotify_fd < 0) {
+        throw std::runtime_error(std::string("No se pudo iniciar inotify: ") + std::strerror(errno));
+    }
+}
+
+inline TreeWatcher::~TreeWatcher()
+{
+    if (inotify_fd >= 0) ::close(inotify_fd);
+}
+
+inline void TreeWatcher::watchTree(const std::filesystem::path& relative, bool enqueue)
+{
+    namespace fs = std::filesystem;
+
+    constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE |
+        IN_DELETE_SELF | IN_ONLYDIR;
+
+    fs::path directory = relative.empty() ? source_dir : source_dir / relative;
+    int wd = inotify_add_watch(inotify_fd, directory.c_str(), mask);
+    if (wd < 0) {
+        throw std::runtime_error("No se pudo vigilar " + directory.string() + ": " + std::strerror(errno));
+    }
+    watches[wd] = relative;
+
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(directory, error)) {
+        fs::path child = relative / entry.path().filename();
+        if (entry.is_directory(error) && !entry.is_symlink(error)) {
+            watchTree(child, enqueue);
+        }
+        else if (enqueue && entry.is_regular_file(error) && BatchTranspiler::isSourceFile(child)) {
+            markChanged(child, false);
+        }
+    }
+}
+
+inline void TreeWatcher::markChanged(const std::filesystem::path& relative, bool removed)
+{
+    auto now = Clock::now();
+    if (pending.empty()) first_event = now;
+    last_event = now;
+
+    // Gana el ultimo evento: borrar y volver a crear un archivo lo transpila
+    pending[relative] = removed;
+}
+
+inline void TreeWatcher::readEvents()
+{
+    alignas(inotify_event) char buffer[64 * 1024];
+
+    while (true) {
+        ssize_t length = ::read(inotify_fd, buffer, sizeof(buffer));
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            throw std::runtime_error(std::string("Error al leer eventos: ") + std::strerror(errno));
+        }
+
+        for (char* pos = buffer; pos < buffer + length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(pos);
+            pos += sizeof(inotify_event) + event->len;
+
+            // Se perdieron eventos: se revisa todo el arbol
+            if (event->mask & IN_Q_OVERFLOW) {
+                std::error_code error;
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(source_dir, error)) {
+                    if (entry.is_regular_file(error) && BatchTranspiler::isSourceFile(entry.path())) {
+                        markChanged(entry.path().lexically_relative(source_dir), false);
+                    }
+                }
+                continue;
+            }
+
+            auto watch = watches.find(event->wd);
+            if (watch == watches.end()) continue;
+
+            if (event->mask & IN_IGNORED) {
+                watches.erase(watch);
+                continue;
+            }
+            if (event->len == 0) continue;
+
+            std::filesystem::path relative = watch->second / event->name;
+
+            if (event->mask & IN_ISDIR) {
+                // Un directorio nuevo o movido aqui se vigila y se transpila su contenido
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    std::error_code error;
+                    if (std::filesystem::is_directory(source_dir / relative, error)) watchTree(relative, true);
+                }
+                continue;
+            }
+
+            if (!BatchTranspiler::isSourceFile(relative)) continue;
+
+            // IN_CREATE solo no basta: el contenido llega con IN_CLOSE_WRITE
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                markChanged(relative, false);
+            }
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                markChanged(relative, true);
+            }
+        }
+    }
+}
+
+inline bool TreeWatcher::writeAtomically(const std::filesystem::path& path, std::string_view content)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    fs::create_directories(path.parent_path(), error);
+
+    // El temporal va en el mismo directorio para que rename() no cruce sistemas de archivos
+    fs::path temp = path;
+    temp += ".tmp-" + std::to_string(::getpid()) + "-" + std::to_string(temp_counter++);
+
+    if (!writeFile(temp.string(), content)) {
+        fs::remove(temp, error);
+        return false;
+    }
+
+    fs::rename(temp, path, error);
+    if (error) {
+        fs::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+inline TreeWatcher::FileResult TreeWatcher::readSource(const std::filesystem::path& path, std::string& content)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return FileResult::Failed;
+
+    struct stat info;
+    if (::fstat(fd, &info) < 0) {
+        ::close(fd);
+        return FileResult::Failed;
+    }
+
+    // Un byte de mas para notar si el archivo crecio desde fstat
+    size_t expected = static_cast<size_t>(info.st_size);
+    content.resize(expected + 1);
+
+    size_t filled = 0;
+    FileResult result = FileResult::Written;
+    while (filled < content.size()) {
+        ssize_t received = ::pread(fd, content.data() + filled, content.size() - filled, static_cast<off_t>(filled));
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0) {
+            result = FileResult::Failed;
+            break;
+        }
+        if (received == 0) break;
+        filled += static_cast<size_t>(received);
+    }
+    ::close(fd);
+
+    if (result == FileResult::Written && filled != expected) result = FileResult::Changed;
+    content.resize(std::min(filled, expected));
+    return result;
+}
+
+inline TreeWatcher::FileResult TreeWatcher::transpileFile(const std::filesystem::path& relative, std::ostream& errors)
+{
+    std::filesystem::path input_path = source_dir / relative;
+    std::filesystem::path output_path = output_dir / BatchTranspiler::outputName(relative);
+
+    FileResult read = readSource(input_path, source_buffer);
+    if (read == FileResult::Failed) {
+        // Pudo borrarse despues del evento; el borrado llegara en otro lote
+        errors << "No se pudo abrir el archivo: " << input_path.string() << "\n";
+        return read;
+    }
+    if (read == FileResult::Changed) return read;
+
+    std::string_view content = source_buffer;
+    std::string key = relative.string();
+    auto state = incremental.find(key);
+
+    bool written;
+    if (mode == PipelineMode::Fused && (state != incremental.end() || content.size() >= incremental_min_size)) {
+        if (state == incremental.end()) {
+            state = incremental.emplace(key, std::make_unique<IncrementalTranspiler>()).first;
+        }
+        written = writeAtomically(output_path, state->second->update(content));
+    }
+    else {
+        written = writeAtomically(output_path, pipeline.transpile(content, mode));
+    }
+
+    if (!written) {
+        errors << "No se pudo escribir el archivo: " << output_path.string() << "\n";
+        return FileResult::Failed;
+    }
+    return FileResult::Written;
+}
+
+inline void TreeWatcher::processPending(std::ostream& log, std::ostream& errors)
+{
+    auto start = Clock::now();
+    size_t transpiled = 0;
+    size_t removed = 0;
+    size_t changed = 0;
+
+    for (const auto& [relative, deleted] : pending) {
+        try {
+            if (deleted) {
+                std::error_code error;
+                std::filesystem::remove(output_dir / BatchTranspiler::outputName(relative), error);
+                incremental.erase(relative.string());
+                ++removed;
+            }
+            else {
+                switch (transpileFile(relative, errors)) {
+                case FileResult::Written: ++transpiled; break;
+                case FileResult::Changed: ++changed; break;
+                case FileResult::Failed: ++failures; break;
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            errors << "Error en " << relative.string() << ": " << e.what() << "\n";
+            incremental.erase(relative.string());
+            ++failures;
+        }
+    }
+
+    auto end = Clock::now();
+    double work_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    double event_ms = std::chrono::duration<double, std::milli>(end - first_event).count();
+
+    // La latencia de un lote va del primer evento a la ultima salida escrita
+    latencies.record(event_ms * 1000.0);
+    ++batches;
+    files_written += transpiled;
+    postponed += changed;
+
+    log << std::fixed << std::setprecision(2)
+        << "Lote " << batches << ": " << transpiled << " transpilados, " << removed << " borrados";
+    if (changed > 0) log << ", " << changed << " cambiaron al leerlos";
+    log << " en " << work_ms << " ms (" << event_ms << " ms desde el primer evento)\n" << std::flush;
+
+    pending.clear();
+}
+
+inline void TreeWatcher::run(std::ostream& log, std::ostream& errors)
+{
+    // Se vigila antes de sincronizar para no perder cambios hechos mientras tanto
+    watchTree({}, false);
+
+    BatchTranspiler batch(mode, jobs);
+    std::vector<BatchJob> batch_jobs = batch.collectJobs(source_dir.string(), output_dir);
+
+    // Los archivos grandes se transpilan aqui para conservar su estado incremental;
+    // asi su primer cambio ya no repite el archivo completo
+    BatchSummary large_summary;
+    auto large_start = Clock::now();
+    if (mode == PipelineMode::Fused) {
+        auto large = std::stable_partition(batch_jobs.begin(), batch_jobs.end(),
+            [](const BatchJob& job) { return job.size < incremental_min_size; });
+
+        for (auto job = large; job != batch_jobs.end(); ++job) {
+            ++large_summary.files;
+            large_summary.bytes += job->size;
+            try {
+                // Uno que cambia mientras se lee se transpila con su proximo evento
+                if (transpileFile(job->input.lexically_relative(source_dir), errors) == FileResult::Failed) {
+                    ++large_summary.failures;
+                }
+            }
+            catch (const std::exception& e) {
+                errors << "Error en " << job->input.string() << ": " << e.what() << "\n";
+                ++large_summary.failures;
+            }
+        }
+        batch_jobs.erase(large, batch_jobs.end());
+    }
+    large_summary.seconds = std::chrono::duration<double>(Clock::now() - large_start).count();
+
+    BatchSummary summary = batch.run(batch_jobs, errors);
+    summary.files += large_summary.files;
+    summary.failures += large_summary.failures;
+    summary.bytes += large_summary.bytes;
+    summary.seconds += large_summary.seconds;
+    summary.print(log);
+    log << "Vigilando " << source_dir.string() << " (" << watches.size() << " directorios)\n" << std::flush;
+
+    while (!stopping) {
+        // Sin cambios pendientes se despierta de vez en cuando para revisar stop()
+        int timeout = 250;
+        if (!pending.empty()) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(batchDeadline() - Clock::now());
+            timeout = static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(remaining.count(), 0, timeout));
+        }
+
+        pollfd descriptor{ inotify_fd, POLLIN, 0 };
+        int ready = ::poll(&descriptor, 1, timeout);
+        if (ready < 0 && errno != EINTR) {
+            throw std::runtime_error(std::string("Error en poll: ") + std::strerror(errno));
+        }
+        if (ready > 0) readEvents();
+
+        if (!pending.empty() && Clock::now() >= batchDeadline()) {
+            processPending(log, errors);
+        }
+    }
+}
+
+inline TreeWatcher::Clock::time_point TreeWatcher::batchDeadline() const
+{
+    return std::min(last_event + debounce, first_event + std::max(debounce, max_batch_wait));
+}
+
+inline void TreeWatcher::printSummary(std::ostream& out) const
+{
+    LatencyRecorder::Summary summary = latencies.summary();
+
+    out << std::fixed << std::setprecision(2)
+        << "Lotes: " << batches << ", " << files_written << " archivos transpilados (" << failures
+        << " con error, " << postponed << " pospuestos porque cambiaron al leerlos); latencia p50 " << summary.p50 / 1000.0 << " ms, p99 " << summary.p99 / 1000.0
+        << " ms, max " << summary.max / 1000.0 << " ms\n";
+}
+
+#endif
@@ -0,0 +1,220 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Reparte trabajos independientes entre varios hilos. Cada hilo tiene su propia
+// cola: toma sus trabajos por el frente y, cuando se queda sin ellos, roba del
+// final de la cola de otro. Los trabajos no generan trabajos nuevos, asi que un
+// hilo termina cuando todas las colas estan vacias.
+//
+// Los hilos se crean en la primera llamada a run que los necesita y esperan la
+// siguiente hasta que se destruye el conjunto, asi que quien llama a run muchas
+// veces (JsonlTranspiler por bloque, la API en C por lote) no los crea cada vez.
+class WorkStealingPool {
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+
+    size_t worker_count;
+
+    // Hilos 1 a worker_count - 1; el 0 es el que llama a run
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    // Trabajo de la llamada en curso, para los hilos menores que 'job_workers'
+    const std::function<void(size_t)>* job = nullptr;
+    size_t job_workers = 0;
+    size_t running = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+public:
+    // 0 usa un hilo por nucleo
+    explicit WorkStealingPool(size_t workers = 0);
+
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t size() const { return worker_count; }
+
+    // Ejecuta task(worker, item) para cada elemento de 'items', que llegan ordenados
+    // por prioridad: se reparten en turno rotativo, de modo que los primeros se
+    // empiezan antes. Si alguna tarea lanza una excepcion, se relanza la primera
+    // despues de terminar las demas. No debe llamarse desde una de sus tareas
+    template <typename Task>
+    void run(const std::vector<size_t>& items, Task&& task);
+
+private:
+    // Ejecuta work(worker) en los hilos 0 a 'workers' - 1 y espera a que terminen
+    void dispatch(size_t workers, const std::function<void(size_t)>& work);
+
+    void startThreads();
+
+    void stopThreads();
+
+    void workerLoop(size_t worker);
+
+    static bool takeFront(WorkerQueue& queue, size_t& item);
+
+    static bool takeBack(WorkerQueue& queue, size_t& item);
+};
+
+
+inline WorkStealingPool::WorkStealingPool(size_t workers)
+    : worker_count(workers != 0 ? workers : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+inline WorkStealingPool::~WorkStealingPool()
+{
+    stopThreads();
+}
+
+inline void WorkStealingPool::startThreads()
+{
+    try {
+        for (size_t worker = 1; worker < worker_count; ++worker) {
+            threads.emplace_back(&WorkStealingPool::workerLoop, this, worker);
+        }
+    }
+    catch (...) {
+        stopThreads();
+        throw;
+    }
+}
+
+inline void WorkStealingPool::stopThreads()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    stopping = false;
+}
+
+inline void WorkStealingPool::workerLoop(size_t worker)
+{
+    uint64_t seen = 0;
+    for (;;) {
+        const std::function<void(size_t)>* work;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+
+            seen = generation;
+            if (worker >= job_workers) continue;
+            work = job;
+        }
+
+        (*work)(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0) finished.notify_one();
+    }
+}
+
+inline void WorkStealingPool::dispatch(size_t workers, const std::function<void(size_t)>& work)
+{
+    if (threads.empty()) startThreads();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &work;
+        job_workers = workers;
+        running = workers - 1;
+        ++generation;
+    }
+    wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return running == 0; });
+    job = nullptr;
+}
+
+inline bool WorkStealingPool::takeFront(WorkerQueue& queue, size_t& item)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.items.empty()) return false;
+
+    item = queue.items.front();
+    queue.items.pop_front();
+    return true;
+}
+
+inline bool WorkStealingPool::takeBack(WorkerQueue& queue, size_t& item)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.items.empty()) return false;
+
+    item = queue.items.back();
+    queue.items.pop_back();
+    return true;
+}
+
+template <typename Task>
+void WorkStealingPool::run(const std::vector<size_t>& items, Task&& task)
+{
+    size_t active = std::min(worker_count, std::max<size_t>(items.size(), 1));
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    for (size_t i = 0; i < active; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < items.size(); ++i) {
+        queues[i % active]->items.push_back(items[i]);
+    }
+
+    std::mutex error_mutex;
+    std::exception_ptr first_error;
+
+    auto work = [&](size_t worker) {
+        size_t item;
+        for (;;) {
+            bool found = takeFront(*queues[worker], item);
+
+            // Robar empezando por el vecino, para no concentrar los robos en una cola
+            for (size_t offset = 1; !found && offset < active; ++offset) {
+                found = takeBack(*queues[(worker + offset) % active], item);
+            }
+            if (!found) return;
+
+            try {
+                task(worker, item);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!first_error) first_error = std::current_exception();
+            }
+        }
+    };
+
+    if (active == 1) work(0);
+    else dispatch(active, work);
+
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}